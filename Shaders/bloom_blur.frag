@@ -0,0 +1,40 @@
+#version 140
+precision mediump float;
+
+uniform sampler2D uSource;
+uniform vec2 uUVScale; //used size / texture size
+uniform vec2 uTexel;
+uniform vec2 uDirection; //(1, 0) for the horizontal pass, (0, 1) for the vertical one
+
+//Smaller level, upscaled by the linear filter and added to the result (weight 0 for none)
+uniform sampler2D uAdded;
+uniform vec2 uAddedUVScale;
+uniform vec2 uAddedTexel;
+uniform float uAddedWeight;
+
+in vec2 varyUV;
+
+out vec4 fragColor;
+
+vec3 tap(vec2 uv)
+{
+	return texture(uSource, clamp(uv, 0.5 * uTexel, uUVScale - 0.5 * uTexel)).rgb;
+}
+
+void main()
+{
+	//9-tap Gaussian (binomial 1 8 28 56 70 56 28 8 1) folded into 5 bilinear taps: each side tap reads two texels at once
+	vec2 uv = varyUV * uUVScale;
+	vec2 step1 = 1.3846153846 * uDirection * uTexel;
+	vec2 step2 = 3.2307692308 * uDirection * uTexel;
+	vec3 color = 0.2270270270 * tap(uv)
+		+ 0.3162162162 * (tap(uv + step1) + tap(uv - step1))
+		+ 0.0702702703 * (tap(uv + step2) + tap(uv - step2));
+
+	if (uAddedWeight > 0.0)
+	{
+		vec2 addedUV = clamp(varyUV * uAddedUVScale, 0.5 * uAddedTexel, uAddedUVScale - 0.5 * uAddedTexel);
+		color += uAddedWeight * texture(uAdded, addedUV).rgb;
+	}
+	fragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,36 @@
+#version 140
+precision mediump float;
+
+uniform sampler2D uSource;
+uniform vec2 uUVScale; //used size / texture size: only the bottom left corner of the source is filled
+uniform vec2 uTexel; //size of one texel of the source
+uniform vec2 uOffset; //half a texel of the target, in source uv
+uniform float uThreshold; //0 keeps every pixel
+uniform float uKnee;
+
+in vec2 varyUV;
+
+out vec4 fragColor;
+
+//Bilinear tap kept inside the used area, so the unused part of the texture never bleeds in
+vec3 tap(vec2 uv)
+{
+	return texture(uSource, clamp(uv, 0.5 * uTexel, uUVScale - 0.5 * uTexel)).rgb;
+}
+
+void main()
+{
+	//Four bilinear taps at the corners of the target texel average the whole source block under it
+	vec2 uv = varyUV * uUVScale;
+	vec3 color = 0.25 * (tap(uv - uOffset) + tap(uv + uOffset) + tap(uv + vec2(uOffset.x, -uOffset.y)) + tap(uv + vec2(-uOffset.x, uOffset.y)));
+
+	if (uThreshold > 0.0)
+	{
+		//Bright pass with a soft knee: only the brightness above the threshold is kept, and the glow fades in instead of popping
+		float brightness = max(color.r, max(color.g, color.b));
+		float soft = clamp(brightness - uThreshold + uKnee, 0.0, 2.0 * uKnee);
+		soft = soft * soft / (4.0 * uKnee + 0.0001);
+		color *= max(soft, brightness - uThreshold) / max(brightness, 0.0001);
+	}
+	fragColor = vec4(color, 1.0);
+}
@@ -1,31 +1,110 @@
 #version 140
 precision mediump float; //Medium precision for float. highp and smallp can also be used
 
-uniform vec4 uK;
-uniform vec3 uColor;
-uniform vec3 uLightPosition;
-uniform vec3 uLightColor;
-uniform vec3 uCameraPosition;
-uniform sampler2D uTexture;
+//Compiled once per material variant: GLBackend inserts #define MATERIAL_TEXTURED, MATERIAL_DIFFUSE, MATERIAL_SPECULAR
+//or MATERIAL_EMISSIVE after the #version line, and the terms a material does not use are not compiled at all
+
+//Per-figure parameters, written by GLBackend::draw() into the per-frame stream buffer
+layout(std140) uniform DrawBlock
+{
+	mat4 uMVP;
+	mat4 uModelView;
+	vec4 uK;
+	vec3 uColor;
+	vec3 uLightColor;
+	vec3 uLightPosition;
+	vec3 uCameraPosition;
+	vec4 uTextureRect; //xy : uv scale, zw : uv offset of the figure's image inside its texture page
+	vec4 uTextureSlot; //x : texture page, y : layer
+	vec3 uBoxMin; //the figure's bounding box, decodes the quantized positions
+	vec3 uBoxExtent;
+	mat4 uShadowMatrix; //figure to shadow map clip space, zero without shadows
+};
+
+#ifdef MATERIAL_TEXTURED
+#define TEXTURE_PAGES 4 //as in TexturePacker.h
+
+//All the texture pages are bound once per frame, one unit each. GLSL 1.40 only indexes sampler arrays with constants,
+//so the page is chosen by a branch, the same for the whole draw.
+uniform sampler2DArray uTextures[TEXTURE_PAGES];
+
+vec3 sampleFigureTexture(vec2 uv)
+{
+	//fract() repeats the image inside its atlas rectangle as GL_REPEAT would for a texture of its own.
+	//The mipmap level comes from the gradients before fract(), which jump where the image repeats.
+	vec3 coordinates = vec3(fract(uv) * uTextureRect.xy + uTextureRect.zw, uTextureSlot.y);
+	vec2 dx = dFdx(uv) * uTextureRect.xy;
+	vec2 dy = dFdy(uv) * uTextureRect.xy;
+	int page = int(uTextureSlot.x);
+	if (page == 0) {
+		return textureGrad(uTextures[0], coordinates, dx, dy).rgb;
+	}
+	if (page == 1) {
+		return textureGrad(uTextures[1], coordinates, dx, dy).rgb;
+	}
+	if (page == 2) {
+		return textureGrad(uTextures[2], coordinates, dx, dy).rgb;
+	}
+	return textureGrad(uTextures[3], coordinates, dx, dy).rgb;
+}
+#endif
 
 varying vec3 varyNormal; //Sometimes we use "out" instead of "varying". "out" should be used in later version of GLSL.
 varying vec3 varyPosition;
 varying vec2 vary_UV;
+varying vec4 varyShadow;
+
+#if defined(MATERIAL_DIFFUSE) || defined(MATERIAL_SPECULAR)
+//Shadow map of the frame (ShadowMaps): the static casters are cached, the moving ones are added every frame
+uniform sampler2DShadow uShadowMap;
+
+//Share of the light reaching the fragment. 3x3 PCF, each hardware filtered comparison already blends 2x2 texels.
+float shadowVisibility()
+{
+	if (varyShadow.w <= 0.0) {
+		return 1.0; //no shadows this frame, or behind the light
+	}
+	vec3 coordinates = varyShadow.xyz / varyShadow.w * 0.5 + 0.5;
+	if (any(lessThan(coordinates, vec3(0.0))) || any(greaterThan(coordinates, vec3(1.0)))) {
+		return 1.0; //outside the light's frustum
+	}
+	vec2 texel = 1.0 / vec2(textureSize(uShadowMap, 0));
+	float lit = 0.0;
+	for (int y = -1; y <= 1; y++)
+	{
+		for (int x = -1; x <= 1; x++) {
+			lit += texture(uShadowMap, vec3(coordinates.xy + vec2(x, y) * texel, coordinates.z));
+		}
+	}
+	return lit / 9.0;
+}
+#endif
 
 
 //We still use varying because OpenGLES 2.0 (OpenGL Embedded System, for example for smartphones) does not accept "in" and "out"
 
 void main()
 {
+#ifdef MATERIAL_TEXTURED
+	vec3 texture = sampleFigureTexture(vary_UV);
+#else
+	vec3 texture = uColor;
+#endif
+
+	vec3 color = uK.x*texture*uLightColor; //ambient, the only term of an emissive material
+
+#if defined(MATERIAL_DIFFUSE) || defined(MATERIAL_SPECULAR)
     vec3 L = normalize(uLightPosition-varyPosition);//light
+    float visibility = shadowVisibility(); //the ambient term stays in the shadows
+#endif
+#ifdef MATERIAL_DIFFUSE
+    color += visibility*uK.y*max(0.f,dot(varyNormal,L))*texture*uLightColor;
+#endif
+#ifdef MATERIAL_SPECULAR
     vec3 V = normalize(uCameraPosition-varyPosition);
 	vec3 R = reflect(-L,varyNormal);
-	vec3 texture = vec3(texture2D(uTexture, vary_UV));
-
-    vec3 ambient = uK.x*texture*uLightColor;
-    vec3 diffuse = uK.y*max(0.f,dot(varyNormal,L))*texture*uLightColor;
-    vec3 specular = uK.z*pow(max(0.f,dot(R, V)), uK.w)*uLightColor;
-    
+    color += visibility*uK.z*pow(max(0.f,dot(R, V)), uK.w)*uLightColor;
+#endif
 
-    gl_FragColor = vec4(min(vec3(1.0,1.0,1.0), ambient + diffuse + specular),1.f);
+    gl_FragColor = vec4(color,1.f); //HDR, tonemapped by upscale.frag
 }
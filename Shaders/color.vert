@@ -1,24 +1,74 @@
 #version 140
 precision mediump float;
 
-in vec3 vPosition; //Depending who compiles, these variables are not "attribute" but "in". In this version (130) both are accepted. in should be used later
-in vec3 vNormal;
-in vec2 vUV;
+//Compiled once per material variant, see color.frag
 
-uniform mat4 uMVP;
-uniform mat4 uModelView;
+//Quantized vertex (QuantizedVertex in VertexQuantization.h). Depending who compiles, these variables are not "attribute" but "in". In this version (130) both are accepted. in should be used later
+in vec3 vPosition; //16 bit unsigned normalized position inside the bounding box
+in vec2 vNormal; //octahedral normal, integers in [-127, 127]
+in vec2 vUV; //half floats
+
+//Per-figure parameters, written by GLBackend::draw() into the per-frame stream buffer
+layout(std140) uniform DrawBlock
+{
+	mat4 uMVP;
+	mat4 uModelView;
+	vec4 uK;
+	vec3 uColor;
+	vec3 uLightColor;
+	vec3 uLightPosition;
+	vec3 uCameraPosition;
+	vec4 uTextureRect; //xy : uv scale, zw : uv offset of the figure's image inside its texture page
+	vec4 uTextureSlot; //x : texture page, y : layer
+	vec3 uBoxMin; //the figure's bounding box, decodes the quantized positions
+	vec3 uBoxExtent;
+	mat4 uShadowMatrix; //figure to shadow map clip space, zero without shadows
+};
+
+//Eye transforms set by GLBackend::setStereo(), draws are instanced once per eye (a single instance without stereo)
+layout(std140) uniform StereoBlock
+{
+	mat4 uEyes[2]; //central camera clip space to the eye's half of the image, identity without stereo
+	vec4 uEyePlanes[2]; //keeps each eye in its half through gl_ClipDistance[0]
+	vec4 uEyeLayouts[2]; //full screen passes, see StereoViews::layouts
+};
 
 out vec3 varyNormal;
 out vec3 varyPosition;
 out vec2 vary_UV;
+out vec4 varyShadow;
+
+//The depth pre-pass (depth.vert) computes the same position, the colour pass then tests with GL_LEQUAL
+invariant gl_Position;
 
 //We still use varying because OpenGLES 2.0 (OpenGL Embedded System, for example for smartphones) does not accept "in" and "out"
 
+//Unfolds the octahedron |x| + |y| + |z| = 1, the z < 0 half being stored folded over the square's corners
+vec3 decodeNormal(vec2 encoded)
+{
+	vec2 e = encoded / 127.0;
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+	{
+		vec2 signs = vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(e.yx)) * signs;
+	}
+	return normalize(n);
+}
+
 void main()
 {
-	gl_Position = uMVP * vec4(vPosition, 1.0); //We need to put vPosition as a vec4. Because vPosition is a vec3, we need one more value (w) which is here 1.0. Hence x and y go from -w to w hence -1 to +1. Premultiply this variable if you want to transform the position.
-	varyNormal = normalize(transpose(inverse(mat3(uModelView))) * vNormal);
-	vec4 worldPosition = uModelView * vec4(vPosition, 1.0);
+	vec3 position = vPosition * uBoxExtent + uBoxMin; //same expression in depth.vert
+	gl_Position = uEyes[gl_InstanceID] * (uMVP * vec4(position, 1.0)); //We need to put the position as a vec4. Because it is a vec3, we need one more value (w) which is here 1.0. Hence x and y go from -w to w hence -1 to +1. Premultiply this variable if you want to transform the position.
+	gl_ClipDistance[0] = dot(uEyePlanes[gl_InstanceID], gl_Position);
+#if defined(MATERIAL_DIFFUSE) || defined(MATERIAL_SPECULAR)
+	//only lit variants pay for the normal decoding and the normal matrix inversion
+	varyNormal = normalize(transpose(inverse(mat3(uModelView))) * decodeNormal(vNormal));
+	vec4 worldPosition = uModelView * vec4(position, 1.0);
 	varyPosition = worldPosition.xyz / worldPosition.w;
+	varyShadow = uShadowMatrix * vec4(position, 1.0);
+#endif
+#ifdef MATERIAL_TEXTURED
 	vary_UV = -vUV + vec2(1.0, 0.0);
+#endif
 }
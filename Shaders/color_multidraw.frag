@@ -0,0 +1,45 @@
+#version 430
+
+//Same lighting as color.frag, the parameters come from the shader storage buffer instead of uniforms
+struct DrawData
+{
+	mat4 mvp;
+	mat4 normalMatrix;
+	vec4 k;
+	vec4 color; //w : texture layer
+	vec4 lightColor;
+	vec4 lightPosition;
+};
+
+layout(std430, binding = 0) readonly buffer DrawBuffer
+{
+	DrawData draws[];
+};
+
+uniform sampler2DArray uTextures;
+
+in vec3 varyNormal;
+in vec3 varyPosition;
+in vec2 vary_UV;
+flat in int varyDraw;
+
+out vec4 fragColor;
+
+void main()
+{
+	DrawData data = draws[varyDraw];
+	vec4 uK = data.k;
+	vec3 uLightColor = data.lightColor.xyz;
+	vec3 uCameraPosition = vec3(0.0, 0.0, 0.0);
+
+	vec3 L = normalize(data.lightPosition.xyz-varyPosition);//light
+	vec3 V = normalize(uCameraPosition-varyPosition);
+	vec3 R = reflect(-L,varyNormal);
+	vec3 textureColor = texture(uTextures, vec3(vary_UV, data.color.w)).rgb;
+
+	vec3 ambient = uK.x*textureColor*uLightColor;
+	vec3 diffuse = uK.y*max(0.f,dot(varyNormal,L))*textureColor*uLightColor;
+	vec3 specular = uK.z*pow(max(0.f,dot(R, V)), uK.w)*uLightColor;
+
+	fragColor = vec4(ambient + diffuse + specular,1.f); //HDR, tonemapped by upscale.frag
+}
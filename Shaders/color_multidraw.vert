@@ -0,0 +1,61 @@
+#version 430
+#extension GL_ARB_shader_draw_parameters : require
+
+//Quantized vertex, as in color.vert. The bounding box decoding the position is folded into DrawData::mvp.
+layout(location = 0) in vec3 vPosition;
+layout(location = 1) in vec2 vNormal; //octahedral normal, integers in [-127, 127]
+layout(location = 2) in vec2 vUV;
+
+//One entry per figure, filled by MultiDrawBackend::draw(). gl_DrawIDARB is the index of the command in glMultiDrawElementsIndirect.
+struct DrawData
+{
+	mat4 mvp;
+	mat4 normalMatrix;
+	vec4 k;
+	vec4 color; //w : texture layer
+	vec4 lightColor;
+	vec4 lightPosition;
+};
+
+layout(std430, binding = 0) readonly buffer DrawBuffer
+{
+	DrawData draws[];
+};
+
+//Same block as color.vert, bound by GLBackend::setStereo(). gl_InstanceID does not include the base instance.
+layout(std140, binding = 1) uniform StereoBlock
+{
+	mat4 uEyes[2];
+	vec4 uEyePlanes[2];
+	vec4 uEyeLayouts[2];
+};
+
+out vec3 varyNormal;
+out vec3 varyPosition;
+out vec2 vary_UV;
+flat out int varyDraw;
+
+//Same decoding as color.vert
+vec3 decodeNormal(vec2 encoded)
+{
+	vec2 e = encoded / 127.0;
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+	{
+		vec2 signs = vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(e.yx)) * signs;
+	}
+	return normalize(n);
+}
+
+void main()
+{
+	DrawData data = draws[gl_DrawIDARB];
+	vec4 position = data.mvp * vec4(vPosition, 1.0);
+	gl_Position = uEyes[gl_InstanceID] * position;
+	gl_ClipDistance[0] = dot(uEyePlanes[gl_InstanceID], gl_Position);
+	varyNormal = normalize(mat3(data.normalMatrix) * decodeNormal(vNormal));
+	varyPosition = position.xyz / position.w; //as in color.vert, where uModelView is uMVP : both eyes share the lighting of the central camera
+	vary_UV = -vUV + vec2(1.0, 0.0);
+	varyDraw = gl_DrawIDARB;
+}
@@ -0,0 +1,6 @@
+#version 140
+
+//Depth only: the colour writes are masked, nothing to compute
+void main()
+{
+}
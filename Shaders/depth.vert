@@ -0,0 +1,39 @@
+#version 140
+precision mediump float;
+
+in vec3 vPosition; //quantized inside the bounding box, as in color.vert
+
+//Same block as color.vert, the depth pre-pass reads the DrawBlock written by GLBackend::draw()
+layout(std140) uniform DrawBlock
+{
+	mat4 uMVP;
+	mat4 uModelView;
+	vec4 uK;
+	vec3 uColor;
+	vec3 uLightColor;
+	vec3 uLightPosition;
+	vec3 uCameraPosition;
+	vec4 uTextureRect; //xy : uv scale, zw : uv offset of the figure's image inside its texture page
+	vec4 uTextureSlot; //x : texture page, y : layer
+	vec3 uBoxMin; //the figure's bounding box, decodes the quantized positions
+	vec3 uBoxExtent;
+	mat4 uShadowMatrix; //figure to shadow map clip space, zero without shadows
+};
+
+//Eye transforms set by GLBackend::setStereo(), draws are instanced once per eye (a single instance without stereo)
+layout(std140) uniform StereoBlock
+{
+	mat4 uEyes[2]; //central camera clip space to the eye's half of the image, identity without stereo
+	vec4 uEyePlanes[2]; //keeps each eye in its half through gl_ClipDistance[0]
+	vec4 uEyeLayouts[2]; //full screen passes, see StereoViews::layouts
+};
+
+//Must match color.vert bit for bit so the colour pass can test with GL_LEQUAL
+invariant gl_Position;
+
+void main()
+{
+	vec3 position = vPosition * uBoxExtent + uBoxMin;
+	gl_Position = uEyes[gl_InstanceID] * (uMVP * vec4(position, 1.0));
+	gl_ClipDistance[0] = dot(uEyePlanes[gl_InstanceID], gl_Position);
+}
@@ -0,0 +1,16 @@
+#version 140
+precision mediump float;
+
+in vec4 varyColor;
+
+out vec4 fragColor;
+
+void main()
+{
+	//round sprite with a soft edge, blended additively
+	vec2 coord = 2.0 * gl_PointCoord - 1.0;
+	float distance2 = dot(coord, coord);
+	if (distance2 > 1.0)
+		discard;
+	fragColor = vec4(varyColor.rgb, varyColor.a * (1.0 - distance2));
+}
@@ -0,0 +1,27 @@
+#version 140
+precision mediump float;
+
+in vec4 vParticle; //xyz : world position, w : remaining life (1 at birth, 0 at death)
+in vec4 vColor;
+
+uniform mat4 uViewProjection;
+uniform float uPointSize; //diameter in pixels at distance 1
+
+//Eye transforms set by GLBackend::setStereo(), draws are instanced once per eye (a single instance without stereo)
+layout(std140) uniform StereoBlock
+{
+	mat4 uEyes[2]; //central camera clip space to the eye's half of the image, identity without stereo
+	vec4 uEyePlanes[2]; //keeps each eye in its half through gl_ClipDistance[0]
+	vec4 uEyeLayouts[2]; //full screen passes, see StereoViews::layouts
+};
+
+out vec4 varyColor;
+
+void main()
+{
+	gl_Position = uEyes[gl_InstanceID] * (uViewProjection * vec4(vParticle.xyz, 1.0));
+	gl_ClipDistance[0] = dot(uEyePlanes[gl_InstanceID], gl_Position);
+	//particles shrink and fade out as they age
+	gl_PointSize = max(uPointSize * (0.5 + 0.5 * vParticle.w) / gl_Position.w, 1.0);
+	varyColor = vec4(vColor.rgb, vColor.a * vParticle.w);
+}
@@ -0,0 +1,14 @@
+#version 140
+precision mediump float;
+
+uniform samplerCube uSkybox;
+
+in vec3 varyDirection;
+
+out vec4 fragColor;
+
+void main()
+{
+	//no lighting: the background is shown as it is
+	fragColor = vec4(texture(uSkybox, varyDirection).rgb, 1.0);
+}
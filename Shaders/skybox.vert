@@ -0,0 +1,26 @@
+#version 140
+
+uniform mat4 uInverseViewProjection; //camera rotation and projection, without the translation
+
+//Eye transforms set by GLBackend::setStereo(), draws are instanced once per eye (a single instance without stereo)
+layout(std140) uniform StereoBlock
+{
+	mat4 uEyes[2]; //central camera clip space to the eye's half of the image, identity without stereo
+	vec4 uEyePlanes[2]; //keeps each eye in its half through gl_ClipDistance[0]
+	vec4 uEyeLayouts[2]; //full screen passes, see StereoViews::layouts
+};
+
+out vec3 varyDirection;
+
+void main()
+{
+	//Full screen triangle on the far plane: z = w gives a depth of exactly 1.0, the cleared value,
+	//so GL_EQUAL keeps only the pixels no figure has covered and early depth test rejects the others
+	//In stereo each instance covers its eye's half, and looks up the direction the central camera sees at the same eye coordinate
+	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+	vec4 eye = uEyeLayouts[gl_InstanceID];
+	vec4 farPoint = uInverseViewProjection * vec4(corner.x * eye.z + eye.w, corner.y, 1.0, 1.0);
+	varyDirection = farPoint.xyz / farPoint.w;
+	gl_Position = vec4(corner.x * eye.x + eye.y, corner.y, 1.0, 1.0);
+	gl_ClipDistance[0] = dot(uEyePlanes[gl_InstanceID], gl_Position);
+}
@@ -0,0 +1,50 @@
+#version 140
+precision mediump float;
+
+uniform sampler2D uScene;
+uniform vec2 uUVScale; //rendered size / texture size: the scene only fills the bottom left corner
+uniform vec2 uTexel; //size of one texel of the scene texture
+uniform float uSharpness; //0 copies the scene as it is
+
+//Half resolution glow of the bright pixels, see BloomChain
+uniform sampler2D uBloom;
+uniform vec2 uBloomUVScale;
+uniform vec2 uBloomTexel;
+uniform float uBloomIntensity; //0 without bloom
+
+//The scene is HDR: colors above the knee are rolled off towards 1 instead of clipped, the ones below are left as they were
+const float TONEMAP_KNEE = 0.8;
+
+in vec2 varyUV;
+
+out vec4 fragColor;
+
+//Bilinear tap kept inside the rendered area, so the unused part of the texture never bleeds in
+vec3 tap(vec2 uv)
+{
+	return texture(uScene, clamp(uv, 0.5 * uTexel, uUVScale - 0.5 * uTexel)).rgb;
+}
+
+vec3 tonemap(vec3 color)
+{
+	vec3 over = max(color - TONEMAP_KNEE, 0.0);
+	vec3 shoulder = TONEMAP_KNEE + (1.0 - TONEMAP_KNEE) * (1.0 - exp(-over / (1.0 - TONEMAP_KNEE)));
+	return mix(color, shoulder, step(TONEMAP_KNEE, color));
+}
+
+void main()
+{
+	vec2 uv = varyUV * uUVScale;
+	vec3 center = tap(uv);
+	vec3 neighbours = tap(uv + vec2(uTexel.x, 0.0)) + tap(uv - vec2(uTexel.x, 0.0)) + tap(uv + vec2(0.0, uTexel.y)) + tap(uv - vec2(0.0, uTexel.y));
+
+	//Unsharp mask: restores the edges softened by the bilinear upscale
+	vec3 color = max(center + uSharpness * (4.0 * center - neighbours), 0.0);
+
+	if (uBloomIntensity > 0.0)
+	{
+		vec2 bloomUV = clamp(varyUV * uBloomUVScale, 0.5 * uBloomTexel, uBloomUVScale - 0.5 * uBloomTexel);
+		color += uBloomIntensity * texture(uBloom, bloomUV).rgb;
+	}
+	fragColor = vec4(tonemap(color), 1.0);
+}
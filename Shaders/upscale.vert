@@ -0,0 +1,11 @@
+#version 140
+
+out vec2 varyUV;
+
+void main()
+{
+	//Full screen triangle built from gl_VertexID, no vertex buffer needed
+	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	varyUV = corner;
+	gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
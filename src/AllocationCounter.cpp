@@ -0,0 +1,218 @@
+#include "AllocationCounter.h"
+
+#include "atomic"
+#include "new"
+#include "stdio.h"
+#include "stdlib.h"
+
+//relaxed : seuls les totaux comptent, pas l'ordre entre threads
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> allocationBytes(0);
+
+static void* countedAllocate(size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	return malloc(size > 0 ? size : 1);
+}
+
+#ifdef __cpp_aligned_new
+//types plus aligns que malloc (vecteurs SIMD, types aligns de glm) : allous  part, et librs avec la fonction qui va avec
+static void* countedAllocateAligned(size_t size, std::align_val_t alignment)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	allocationBytes.fetch_add(size, std::memory_order_relaxed);
+	size_t align = (size_t)alignment;
+	size = size > 0 ? size : 1;
+#ifdef _MSC_VER
+	return _aligned_malloc(size, align);
+#else
+	return aligned_alloc(align, (size + align - 1) / align * align); //la taille doit tre un multiple de l'alignement
+#endif
+}
+
+static void freeAligned(void* pointer)
+{
+#ifdef _MSC_VER
+	_aligned_free(pointer);
+#else
+	free(pointer);
+#endif
+}
+#endif
+
+void* operator new(size_t size)
+{
+	void* pointer = countedAllocate(size);
+	if (pointer == NULL) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size)
+{
+	void* pointer = countedAllocate(size);
+	if (pointer == NULL) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return countedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return countedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	free(pointer);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* pointer = countedAllocateAligned(size, alignment);
+	if (pointer == NULL) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	void* pointer = countedAllocateAligned(size, alignment);
+	if (pointer == NULL) {
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return countedAllocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return countedAllocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+	freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+	freeAligned(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+	freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept
+{
+	freeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	freeAligned(pointer);
+}
+#endif
+
+AllocationCount getAllocationCount()
+{
+	AllocationCount count = { allocationCount.load(std::memory_order_relaxed), allocationBytes.load(std::memory_order_relaxed) };
+	return count;
+}
+
+FrameAllocations::FrameAllocations(int warmupFrames) : m_warmupFrames(warmupFrames), m_frames(0), m_allocatingFrames(0), m_maxCount(0)
+{
+	m_begin.count = m_begin.bytes = 0;
+	m_warmup.count = m_warmup.bytes = 0;
+	m_steady.count = m_steady.bytes = 0;
+}
+
+void FrameAllocations::beginFrame()
+{
+	m_begin = getAllocationCount();
+}
+
+void FrameAllocations::endFrame(uint32_t frame)
+{
+	AllocationCount end = getAllocationCount();
+	uint64_t count = end.count - m_begin.count;
+	uint64_t bytes = end.bytes - m_begin.bytes;
+	m_frames++;
+	if ((int)m_frames <= m_warmupFrames)
+	{
+		m_warmup.count += count;
+		m_warmup.bytes += bytes;
+		return;
+	}
+
+	m_steady.count += count;
+	m_steady.bytes += bytes;
+	m_maxCount = count > m_maxCount ? count : m_maxCount;
+	if (count > 0)
+	{
+		m_allocatingFrames++;
+		if (m_allocatingFrames <= ALLOCATION_REPORTS) {
+			printf("Frame %u : %llu heap allocations, %llu bytes\n", frame, (unsigned long long)count, (unsigned long long)bytes);
+		}
+	}
+}
+
+void FrameAllocations::printSummary() const
+{
+	if (m_frames == 0) {
+		return;
+	}
+	int warmupFrames = (int)m_frames < m_warmupFrames ? (int)m_frames : m_warmupFrames;
+	uint32_t steadyFrames = m_frames - warmupFrames;
+	printf("Heap allocations : %llu (%.2f MB) during the %d warm-up frames\n", (unsigned long long)m_warmup.count, m_warmup.bytes / (1024.0 * 1024.0), warmupFrames);
+	if (steadyFrames > 0)
+	{
+		printf("                   %.2f per frame (%.0f bytes) over %u frames, %u frames allocated, at most %llu in one frame\n",
+			m_steady.count / (double)steadyFrames, m_steady.bytes / (double)steadyFrames, steadyFrames, m_allocatingFrames, (unsigned long long)m_maxCount);
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include "stdint.h"
+
+#define ALLOCATION_WARMUP_FRAMES 60 //images du dmarrage non comptes : rserves qui grandissent, variantes de shaders compiles  la demande...
+#define ALLOCATION_REPORTS 10 //images qui allouent signales au plus pendant l'excution, les suivantes ne sont que comptes
+
+//Allocations faites par operator new et new[] depuis le lancement, tous threads confondus, y compris les formes alignes de C++17.
+//operator new est remplac pour tout le programme par une version qui compte. Les appels directs  malloc,
+//ceux de la SDL et du pilote OpenGL ne passent pas par l et ne sont pas compts.
+struct AllocationCount {
+	uint64_t count;
+	uint64_t bytes;
+};
+
+AllocationCount getAllocationCount();
+
+//Allocations de chaque image de la boucle principale. Aprs l'chauffement, une image devrait ne rien allouer :
+//celles qui allouent sont signales au fil de l'excution avec leur numro, pour retrouver le coupable.
+class FrameAllocations
+{
+public:
+	FrameAllocations(int warmupFrames = ALLOCATION_WARMUP_FRAMES);
+
+	void beginFrame();
+	void endFrame(uint32_t frame);
+	//Affiche les allocations de l'chauffement et celles des images suivantes
+	void printSummary() const;
+
+private:
+	int m_warmupFrames;
+	AllocationCount m_begin;
+	uint32_t m_frames;
+	AllocationCount m_warmup;
+	AllocationCount m_steady;
+	uint32_t m_allocatingFrames; //images aprs l'chauffement qui ont allou
+	uint64_t m_maxCount; //plus grand nombre d'allocations d'une image aprs l'chauffement
+};
+
+#endif
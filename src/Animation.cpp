@@ -0,0 +1,189 @@
+#include "Animation.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "algorithm"
+#include "math.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define ANIMATION_SIMD
+#endif
+
+//Cherche la cl k telle que times[k] <= time < times[k+1] et le coefficient d'interpolation entre les deux
+static void findKey(const std::vector<float>& times, float time, int& k0, int& k1, float& alpha)
+{
+	int nbKeys = (int)times.size();
+	if (nbKeys == 1 || time <= times[0]) {
+		k0 = k1 = 0;
+		alpha = 0.f;
+		return;
+	}
+	if (time >= times[nbKeys - 1]) {
+		k0 = k1 = nbKeys - 1;
+		alpha = 0.f;
+		return;
+	}
+	k1 = (int)(std::upper_bound(times.begin(), times.end(), time) - times.begin());
+	k0 = k1 - 1;
+	alpha = (time - times[k0]) / (times[k1] - times[k0]);
+}
+
+//Interpolation linaire normalise, en prenant le plus court chemin entre les deux quaternions
+static glm::quat nlerp(const glm::quat& a, const glm::quat& b, float alpha)
+{
+	float sign = (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w) < 0.f ? -1.f : 1.f;
+	float x = a.x + (sign * b.x - a.x) * alpha;
+	float y = a.y + (sign * b.y - a.y) * alpha;
+	float z = a.z + (sign * b.z - a.z) * alpha;
+	float w = a.w + (sign * b.w - a.w) * alpha;
+	float invLength = 1.f / sqrtf(x * x + y * y + z * z + w * w);
+	return glm::quat(w * invLength, x * invLength, y * invLength, z * invLength);
+}
+
+template<typename T>
+static T sampleCurve(const Curve<T>& curve, float time, const T& rest)
+{
+	if (curve.values.empty()) {
+		return rest;
+	}
+	int k0, k1;
+	float alpha;
+	findKey(curve.times, time, k0, k1, alpha);
+	return glm::mix(curve.values[k0], curve.values[k1], alpha);
+}
+
+AnimationClip::AnimationClip(int nbJoints, float duration, bool loop) : m_tracks(nbJoints), m_duration(duration), m_loop(loop)
+{
+}
+
+void AnimationClip::addRotationKey(int joint, float time, const glm::quat& rotation)
+{
+	m_tracks[joint].rotation.times.push_back(time);
+	m_tracks[joint].rotation.values.push_back(rotation);
+}
+
+void AnimationClip::addTranslationKey(int joint, float time, const glm::vec3& translation)
+{
+	m_tracks[joint].translation.times.push_back(time);
+	m_tracks[joint].translation.values.push_back(translation);
+}
+
+void AnimationClip::addScaleKey(int joint, float time, const glm::vec3& scale)
+{
+	m_tracks[joint].scale.times.push_back(time);
+	m_tracks[joint].scale.values.push_back(scale);
+}
+
+float AnimationClip::wrapTime(float time) const
+{
+	if (!m_loop) {
+		return std::min(std::max(time, 0.f), m_duration);
+	}
+	time = fmodf(time, m_duration);
+	if (time < 0.f) {
+		time += m_duration;
+	}
+	return time;
+}
+
+void AnimationClip::sample(float time, std::vector<JointPose>& pose) const
+{
+	sampleBatch(&time, 1, pose);
+}
+
+void AnimationClip::sampleBatch(const float* times, int nbInstances, std::vector<JointPose>& poses) const
+{
+	int nbJoints = getNbJoints();
+	poses.resize(nbInstances * nbJoints);
+
+	for (int j = 0; j < nbJoints; j++)
+	{
+		const JointTrack& track = m_tracks[j];
+
+		//translations et scales : une simple interpolation linaire par instance
+		for (int i = 0; i < nbInstances; i++)
+		{
+			float time = wrapTime(times[i]);
+			poses[i * nbJoints + j].translation = sampleCurve(track.translation, time, glm::vec3(0.f, 0.f, 0.f));
+			poses[i * nbJoints + j].scale = sampleCurve(track.scale, time, glm::vec3(1.f, 1.f, 1.f));
+		}
+
+		const Curve<glm::quat>& curve = track.rotation;
+		if (curve.values.empty()) {
+			for (int i = 0; i < nbInstances; i++) {
+				poses[i * nbJoints + j].rotation = glm::quat(1.f, 0.f, 0.f, 0.f);
+			}
+			continue;
+		}
+
+		int i = 0;
+#ifdef ANIMATION_SIMD
+		//4 instances  la fois : on transpose les quaternions (x, y, z, w) en 4 registres x, y, z et w
+		//On suppose que glm::quat est stock dans l'ordre x, y, z, w (comportement par dfaut de glm)
+		for (; i + 4 <= nbInstances; i += 4)
+		{
+			__m128 a[4], b[4];
+			float alphas[4];
+			for (int lane = 0; lane < 4; lane++)
+			{
+				int k0, k1;
+				findKey(curve.times, wrapTime(times[i + lane]), k0, k1, alphas[lane]);
+				a[lane] = _mm_loadu_ps(&curve.values[k0].x);
+				b[lane] = _mm_loadu_ps(&curve.values[k1].x);
+			}
+			_MM_TRANSPOSE4_PS(a[0], a[1], a[2], a[3]);
+			_MM_TRANSPOSE4_PS(b[0], b[1], b[2], b[3]);
+
+			__m128 alpha = _mm_loadu_ps(alphas);
+			__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])),
+				_mm_add_ps(_mm_mul_ps(a[2], b[2]), _mm_mul_ps(a[3], b[3])));
+			__m128 sign = _mm_and_ps(dot, _mm_set1_ps(-0.f)); //bit de signe du produit scalaire
+
+			__m128 r[4];
+			__m128 length2 = _mm_setzero_ps();
+			for (int c = 0; c < 4; c++)
+			{
+				__m128 bc = _mm_xor_ps(b[c], sign);
+				r[c] = _mm_add_ps(a[c], _mm_mul_ps(_mm_sub_ps(bc, a[c]), alpha));
+				length2 = _mm_add_ps(length2, _mm_mul_ps(r[c], r[c]));
+			}
+			__m128 invLength = _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(length2));
+			for (int c = 0; c < 4; c++) {
+				r[c] = _mm_mul_ps(r[c], invLength);
+			}
+
+			_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+			for (int lane = 0; lane < 4; lane++) {
+				_mm_storeu_ps(&poses[(i + lane) * nbJoints + j].rotation.x, r[lane]);
+			}
+		}
+#endif
+		for (; i < nbInstances; i++)
+		{
+			int k0, k1;
+			float alpha;
+			findKey(curve.times, wrapTime(times[i]), k0, k1, alpha);
+			poses[i * nbJoints + j].rotation = nlerp(curve.values[k0], curve.values[k1], alpha);
+		}
+	}
+}
+
+void blendPoses(const std::vector<JointPose>& a, const std::vector<JointPose>& b, float weight, std::vector<JointPose>& out)
+{
+	out.resize(a.size());
+	for (size_t j = 0; j < a.size(); j++)
+	{
+		out[j].rotation = nlerp(a[j].rotation, b[j].rotation, weight);
+		out[j].translation = glm::mix(a[j].translation, b[j].translation, weight);
+		out[j].scale = glm::mix(a[j].scale, b[j].scale, weight);
+	}
+}
+
+glm::mat4 poseMatrix(const JointPose& pose)
+{
+	glm::mat4 matrix = glm::translate(glm::mat4(1.0f), pose.translation);
+	matrix = matrix * glm::mat4_cast(pose.rotation);
+	matrix = glm::scale(matrix, pose.scale);
+	return matrix;
+}
@@ -0,0 +1,66 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+//GML libraries
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "vector"
+
+//Pose locale d'une articulation. Par dfaut c'est la pose de repos (aucune transformation).
+struct JointPose {
+	glm::quat rotation = glm::quat(1.f, 0.f, 0.f, 0.f);
+	glm::vec3 translation = glm::vec3(0.f, 0.f, 0.f);
+	glm::vec3 scale = glm::vec3(1.f, 1.f, 1.f);
+};
+
+//Une courbe stocke sparment les temps des cls (tris) et leurs valeurs, pour que la recherche ne parcoure que les temps
+template<typename T>
+struct Curve {
+	std::vector<float> times;
+	std::vector<T> values;
+};
+
+//Les trois canaux d'une articulation. Un canal sans cl garde la valeur de repos.
+struct JointTrack {
+	Curve<glm::quat> rotation;
+	Curve<glm::vec3> translation;
+	Curve<glm::vec3> scale;
+};
+
+//Un clip d'animation : une piste par articulation, chantillonnable  n'importe quel instant.
+//Les rotations sont interpoles par nlerp, il faut donc des cls assez rapproches pour les grands angles.
+class AnimationClip
+{
+public:
+	AnimationClip(int nbJoints, float duration, bool loop = true);
+
+	//Les cls doivent tre ajoutes dans l'ordre chronologique pour chaque canal
+	void addRotationKey(int joint, float time, const glm::quat& rotation);
+	void addTranslationKey(int joint, float time, const glm::vec3& translation);
+	void addScaleKey(int joint, float time, const glm::vec3& scale);
+
+	//value la pose de toutes les articulations  l'instant time (en secondes)
+	void sample(float time, std::vector<JointPose>& pose) const;
+
+	//value le clip pour nbInstances personnages  la fois, poses[instance * nbJoints + joint]. Les rotations sont traites 4 par 4 en SIMD.
+	void sampleBatch(const float* times, int nbInstances, std::vector<JointPose>& poses) const;
+
+	int getNbJoints() const { return (int)m_tracks.size(); }
+	float getDuration() const { return m_duration; }
+
+private:
+	float wrapTime(float time) const;
+
+	std::vector<JointTrack> m_tracks;
+	float m_duration;
+	bool m_loop;
+};
+
+//Mlange deux poses (weight = 0 donne a, weight = 1 donne b)
+void blendPoses(const std::vector<JointPose>& a, const std::vector<JointPose>& b, float weight, std::vector<JointPose>& out);
+
+//Matrice locale translation * rotation * scale d'une pose
+glm::mat4 poseMatrix(const JointPose& pose);
+
+#endif
@@ -0,0 +1,340 @@
+#include "BallPhysics.h"
+
+#include "algorithm"
+#include "chrono"
+#include "math.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define PHYSICS_SIMD
+#endif
+
+#define PHYSICS_PADDING_POSITION 1e6f //position des balles de remplissage
+
+BoxCollider makeBoxCollider(const glm::mat4& model, float restitution, float grip, const glm::vec3& velocity)
+{
+	BoxCollider box;
+	box.center = glm::vec3(model[3]);
+	for (int i = 0; i < 3; i++)
+	{
+		glm::vec3 axis = glm::vec3(model[i]);
+		float length = glm::length(axis);
+		box.axes[i] = axis / length;
+		box.halfExtents[i] = 0.5f * length;
+	}
+	box.velocity = velocity;
+	box.restitution = restitution;
+	box.grip = grip;
+	return box;
+}
+
+BallPhysics::BallPhysics(const PhysicsParameters& parameters) : m_parameters(parameters), m_count(0), m_accumulator(0.f)
+{
+}
+
+int BallPhysics::addBall(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& spin)
+{
+	int ball = m_count++;
+	if (ball == (int)m_px.size())
+	{
+		//on ajoute 4 places d'un coup, les places libres sont des balles inertes
+		size_t size = m_px.size() + 4;
+		m_px.resize(size, PHYSICS_PADDING_POSITION); m_py.resize(size, PHYSICS_PADDING_POSITION); m_pz.resize(size, PHYSICS_PADDING_POSITION);
+		m_vx.resize(size, 0.f); m_vy.resize(size, 0.f); m_vz.resize(size, 0.f);
+		m_wx.resize(size, 0.f); m_wy.resize(size, 0.f); m_wz.resize(size, 0.f);
+	}
+	m_px[ball] = position.x; m_py[ball] = position.y; m_pz[ball] = position.z;
+	m_vx[ball] = velocity.x; m_vy[ball] = velocity.y; m_vz[ball] = velocity.z;
+	m_wx[ball] = spin.x; m_wy[ball] = spin.y; m_wz[ball] = spin.z;
+	return ball;
+}
+
+void BallPhysics::clear()
+{
+	m_px.clear(); m_py.clear(); m_pz.clear();
+	m_vx.clear(); m_vy.clear(); m_vz.clear();
+	m_wx.clear(); m_wy.clear(); m_wz.clear();
+	m_count = 0;
+	m_accumulator = 0.f;
+}
+
+int BallPhysics::update(float frameTime)
+{
+	m_accumulator += frameTime;
+	int steps = 0;
+	while (m_accumulator >= PHYSICS_TIMESTEP && steps < PHYSICS_MAX_STEPS)
+	{
+		step(PHYSICS_TIMESTEP);
+		m_accumulator -= PHYSICS_TIMESTEP;
+		steps++;
+	}
+	if (steps == PHYSICS_MAX_STEPS) {
+		m_accumulator = 0.f; //retard abandonn
+	}
+	return steps;
+}
+
+void BallPhysics::step(float dt)
+{
+#ifdef PHYSICS_SIMD
+	stepSimd(0, (int)m_px.size(), dt);
+#else
+	stepScalar(0, m_count, dt);
+#endif
+}
+
+//Version de rfrence, une balle  la fois. stepSimd() fait exactement les mmes calculs.
+void BallPhysics::stepScalar(int begin, int end, float dt)
+{
+	const PhysicsParameters& p = m_parameters;
+	float r = p.radius;
+	float spinFactor = std::max(0.f, 1.f - p.spinDamping * dt);
+
+	for (int i = begin; i < end; i++)
+	{
+		glm::vec3 pos(m_px[i], m_py[i], m_pz[i]);
+		glm::vec3 v(m_vx[i], m_vy[i], m_vz[i]);
+		glm::vec3 w(m_wx[i], m_wy[i], m_wz[i]);
+
+		//gravit, freinage de l'air et effet Magnus, puis Euler semi-implicite
+		float speed = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+		glm::vec3 magnus(w.y * v.z - w.z * v.y, w.z * v.x - w.x * v.z, w.x * v.y - w.y * v.x);
+		glm::vec3 a = v * (-p.drag * speed) + magnus * p.magnus;
+		a.y -= p.gravity;
+		v += a * dt;
+		pos += v * dt;
+		w *= spinFactor;
+
+		for (size_t c = 0; c < m_colliders.size(); c++)
+		{
+			const BoxCollider& box = m_colliders[c];
+			glm::vec3 d = pos - box.center;
+			float local[3], closest[3];
+			float dist2 = 0.f;
+			for (int k = 0; k < 3; k++)
+			{
+				local[k] = glm::dot(d, box.axes[k]);
+				closest[k] = std::min(std::max(local[k], -box.halfExtents[k]), box.halfExtents[k]);
+				dist2 += (local[k] - closest[k]) * (local[k] - closest[k]);
+			}
+			if (dist2 >= r * r) {
+				continue;
+			}
+
+			//normale et profondeur de pntration, dans le repre de la bote
+			float normal[3] = { 0.f, 0.f, 0.f };
+			float penetration;
+			if (dist2 > 0.f)
+			{
+				float dist = sqrtf(dist2);
+				for (int k = 0; k < 3; k++) {
+					normal[k] = (local[k] - closest[k]) / dist;
+				}
+				penetration = r - dist;
+			}
+			else
+			{
+				//centre dans la bote : on sort par la face la plus proche
+				float faceDistance[3];
+				for (int k = 0; k < 3; k++) {
+					faceDistance[k] = box.halfExtents[k] - fabsf(local[k]);
+				}
+				int k = faceDistance[0] <= faceDistance[1] && faceDistance[0] <= faceDistance[2] ? 0 : (faceDistance[1] <= faceDistance[2] ? 1 : 2);
+				normal[k] = local[k] < 0.f ? -1.f : 1.f;
+				penetration = faceDistance[k] + r;
+			}
+			glm::vec3 n = box.axes[0] * normal[0] + box.axes[1] * normal[1] + box.axes[2] * normal[2];
+			pos += n * penetration;
+
+			glm::vec3 relative = v - box.velocity;
+			float vn = glm::dot(relative, n);
+			if (vn >= 0.f) {
+				continue; //la balle s'loigne dj
+			}
+			//rebond, puis frottement au point de contact qui fait passer la balle du glissement au roulement (sphre pleine)
+			glm::vec3 tangent = relative - n * vn;
+			glm::vec3 wxn(w.y * n.z - w.z * n.y, w.z * n.x - w.x * n.z, w.x * n.y - w.y * n.x);
+			glm::vec3 u = tangent - wxn * r;
+			glm::vec3 nxu(n.y * u.z - n.z * u.y, n.z * u.x - n.x * u.z, n.x * u.y - n.y * u.x);
+			v -= n * ((1.f + box.restitution) * vn);
+			v -= u * (box.grip * 2.f / 7.f);
+			w += nxu * (box.grip * 5.f / (7.f * r));
+		}
+
+		m_px[i] = pos.x; m_py[i] = pos.y; m_pz[i] = pos.z;
+		m_vx[i] = v.x; m_vy[i] = v.y; m_vz[i] = v.z;
+		m_wx[i] = w.x; m_wy[i] = w.y; m_wz[i] = w.z;
+	}
+}
+
+#ifdef PHYSICS_SIMD
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+void BallPhysics::stepSimd(int begin, int end, float dt)
+{
+	const PhysicsParameters& p = m_parameters;
+	const __m128 dt4 = _mm_set1_ps(dt);
+	const __m128 drag = _mm_set1_ps(-p.drag);
+	const __m128 magnus = _mm_set1_ps(p.magnus);
+	const __m128 gravity = _mm_set1_ps(p.gravity);
+	const __m128 spinFactor = _mm_set1_ps(std::max(0.f, 1.f - p.spinDamping * dt));
+	const __m128 r = _mm_set1_ps(p.radius);
+	const __m128 r2 = _mm_set1_ps(p.radius * p.radius);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 signBit = _mm_set1_ps(-0.f);
+	const __m128 tiny = _mm_set1_ps(1e-20f);
+
+	for (int i = begin; i < end; i += 4)
+	{
+		__m128 px = _mm_loadu_ps(&m_px[i]), py = _mm_loadu_ps(&m_py[i]), pz = _mm_loadu_ps(&m_pz[i]);
+		__m128 vx = _mm_loadu_ps(&m_vx[i]), vy = _mm_loadu_ps(&m_vy[i]), vz = _mm_loadu_ps(&m_vz[i]);
+		__m128 wx = _mm_loadu_ps(&m_wx[i]), wy = _mm_loadu_ps(&m_wy[i]), wz = _mm_loadu_ps(&m_wz[i]);
+
+		//gravit, freinage de l'air et effet Magnus, puis Euler semi-implicite
+		__m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+		__m128 k = _mm_mul_ps(drag, speed);
+		__m128 ax = _mm_add_ps(_mm_mul_ps(vx, k), _mm_mul_ps(magnus, _mm_sub_ps(_mm_mul_ps(wy, vz), _mm_mul_ps(wz, vy))));
+		__m128 ay = _mm_add_ps(_mm_mul_ps(vy, k), _mm_mul_ps(magnus, _mm_sub_ps(_mm_mul_ps(wz, vx), _mm_mul_ps(wx, vz))));
+		__m128 az = _mm_add_ps(_mm_mul_ps(vz, k), _mm_mul_ps(magnus, _mm_sub_ps(_mm_mul_ps(wx, vy), _mm_mul_ps(wy, vx))));
+		ay = _mm_sub_ps(ay, gravity);
+		vx = _mm_add_ps(vx, _mm_mul_ps(ax, dt4));
+		vy = _mm_add_ps(vy, _mm_mul_ps(ay, dt4));
+		vz = _mm_add_ps(vz, _mm_mul_ps(az, dt4));
+		px = _mm_add_ps(px, _mm_mul_ps(vx, dt4));
+		py = _mm_add_ps(py, _mm_mul_ps(vy, dt4));
+		pz = _mm_add_ps(pz, _mm_mul_ps(vz, dt4));
+		wx = _mm_mul_ps(wx, spinFactor);
+		wy = _mm_mul_ps(wy, spinFactor);
+		wz = _mm_mul_ps(wz, spinFactor);
+
+		for (size_t c = 0; c < m_colliders.size(); c++)
+		{
+			const BoxCollider& box = m_colliders[c];
+			__m128 dx = _mm_sub_ps(px, _mm_set1_ps(box.center.x));
+			__m128 dy = _mm_sub_ps(py, _mm_set1_ps(box.center.y));
+			__m128 dz = _mm_sub_ps(pz, _mm_set1_ps(box.center.z));
+
+			__m128 local[3], outside[3];
+			__m128 dist2 = zero;
+			for (int a = 0; a < 3; a++)
+			{
+				local[a] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_set1_ps(box.axes[a].x)), _mm_mul_ps(dy, _mm_set1_ps(box.axes[a].y))), _mm_mul_ps(dz, _mm_set1_ps(box.axes[a].z)));
+				__m128 half = _mm_set1_ps(box.halfExtents[a]);
+				outside[a] = _mm_sub_ps(local[a], _mm_min_ps(_mm_max_ps(local[a], _mm_sub_ps(zero, half)), half));
+				dist2 = _mm_add_ps(dist2, _mm_mul_ps(outside[a], outside[a]));
+			}
+			__m128 hit = _mm_cmplt_ps(dist2, r2);
+			if (_mm_movemask_ps(hit) == 0) {
+				continue;
+			}
+
+			//normale et profondeur hors de la bote
+			__m128 inside = _mm_cmpeq_ps(dist2, zero);
+			__m128 invDist = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(dist2, tiny)));
+			__m128 penetration = _mm_sub_ps(r, _mm_mul_ps(dist2, invDist));
+
+			//centre dans la bote : on sort par la face la plus proche
+			__m128 face[3];
+			for (int a = 0; a < 3; a++) {
+				face[a] = _mm_sub_ps(_mm_set1_ps(box.halfExtents[a]), _mm_andnot_ps(signBit, local[a]));
+			}
+			__m128 pick0 = _mm_and_ps(_mm_cmple_ps(face[0], face[1]), _mm_cmple_ps(face[0], face[2]));
+			__m128 pick1 = _mm_andnot_ps(pick0, _mm_cmple_ps(face[1], face[2]));
+			__m128 pick2 = _mm_andnot_ps(_mm_or_ps(pick0, pick1), _mm_castsi128_ps(_mm_set1_epi32(-1)));
+			__m128 picks[3] = { pick0, pick1, pick2 };
+			__m128 insidePenetration = _mm_add_ps(select(pick0, face[0], select(pick1, face[1], face[2])), r);
+			penetration = select(inside, insidePenetration, penetration);
+
+			__m128 nx = zero, ny = zero, nz = zero;
+			for (int a = 0; a < 3; a++)
+			{
+				__m128 sign = _mm_or_ps(_mm_and_ps(signBit, local[a]), one);
+				__m128 normal = select(inside, _mm_and_ps(picks[a], sign), _mm_mul_ps(outside[a], invDist));
+				nx = _mm_add_ps(nx, _mm_mul_ps(normal, _mm_set1_ps(box.axes[a].x)));
+				ny = _mm_add_ps(ny, _mm_mul_ps(normal, _mm_set1_ps(box.axes[a].y)));
+				nz = _mm_add_ps(nz, _mm_mul_ps(normal, _mm_set1_ps(box.axes[a].z)));
+			}
+			penetration = _mm_and_ps(hit, penetration);
+			px = _mm_add_ps(px, _mm_mul_ps(nx, penetration));
+			py = _mm_add_ps(py, _mm_mul_ps(ny, penetration));
+			pz = _mm_add_ps(pz, _mm_mul_ps(nz, penetration));
+
+			__m128 rx = _mm_sub_ps(vx, _mm_set1_ps(box.velocity.x));
+			__m128 ry = _mm_sub_ps(vy, _mm_set1_ps(box.velocity.y));
+			__m128 rz = _mm_sub_ps(vz, _mm_set1_ps(box.velocity.z));
+			__m128 vn = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, nx), _mm_mul_ps(ry, ny)), _mm_mul_ps(rz, nz));
+			__m128 bounce = _mm_and_ps(hit, _mm_cmplt_ps(vn, zero));
+			if (_mm_movemask_ps(bounce) == 0) {
+				continue;
+			}
+
+			//rebond, puis frottement au point de contact qui fait passer la balle du glissement au roulement (sphre pleine)
+			__m128 ux = _mm_sub_ps(_mm_sub_ps(rx, _mm_mul_ps(nx, vn)), _mm_mul_ps(r, _mm_sub_ps(_mm_mul_ps(wy, nz), _mm_mul_ps(wz, ny))));
+			__m128 uy = _mm_sub_ps(_mm_sub_ps(ry, _mm_mul_ps(ny, vn)), _mm_mul_ps(r, _mm_sub_ps(_mm_mul_ps(wz, nx), _mm_mul_ps(wx, nz))));
+			__m128 uz = _mm_sub_ps(_mm_sub_ps(rz, _mm_mul_ps(nz, vn)), _mm_mul_ps(r, _mm_sub_ps(_mm_mul_ps(wx, ny), _mm_mul_ps(wy, nx))));
+			__m128 normalImpulse = _mm_and_ps(bounce, _mm_mul_ps(_mm_set1_ps(1.f + box.restitution), vn));
+			__m128 slide = _mm_and_ps(bounce, _mm_set1_ps(box.grip * 2.f / 7.f));
+			__m128 roll = _mm_and_ps(bounce, _mm_set1_ps(box.grip * 5.f / (7.f * p.radius)));
+			vx = _mm_sub_ps(vx, _mm_add_ps(_mm_mul_ps(nx, normalImpulse), _mm_mul_ps(ux, slide)));
+			vy = _mm_sub_ps(vy, _mm_add_ps(_mm_mul_ps(ny, normalImpulse), _mm_mul_ps(uy, slide)));
+			vz = _mm_sub_ps(vz, _mm_add_ps(_mm_mul_ps(nz, normalImpulse), _mm_mul_ps(uz, slide)));
+			wx = _mm_add_ps(wx, _mm_mul_ps(roll, _mm_sub_ps(_mm_mul_ps(ny, uz), _mm_mul_ps(nz, uy))));
+			wy = _mm_add_ps(wy, _mm_mul_ps(roll, _mm_sub_ps(_mm_mul_ps(nz, ux), _mm_mul_ps(nx, uz))));
+			wz = _mm_add_ps(wz, _mm_mul_ps(roll, _mm_sub_ps(_mm_mul_ps(nx, uy), _mm_mul_ps(ny, ux))));
+		}
+
+		_mm_storeu_ps(&m_px[i], px); _mm_storeu_ps(&m_py[i], py); _mm_storeu_ps(&m_pz[i], pz);
+		_mm_storeu_ps(&m_vx[i], vx); _mm_storeu_ps(&m_vy[i], vy); _mm_storeu_ps(&m_vz[i], vz);
+		_mm_storeu_ps(&m_wx[i], wx); _mm_storeu_ps(&m_wy[i], wy); _mm_storeu_ps(&m_wz[i], wz);
+	}
+}
+#else
+void BallPhysics::stepSimd(int begin, int end, float dt)
+{
+	stepScalar(begin, end, dt);
+}
+#endif
+
+void runPhysicsBenchmark(int nbBalls)
+{
+	BallPhysics physics;
+	for (int i = 0; i < nbBalls; i++)
+	{
+		glm::vec3 position(0.8f, 0.2f + 0.3f * rand() / RAND_MAX, -40.3f + 0.6f * rand() / RAND_MAX);
+		glm::vec3 velocity(-2.f - rand() % 100 / 100.f, 0.5f + rand() % 100 / 100.f, 0.3f - 0.6f * rand() / RAND_MAX);
+		glm::vec3 spin(0.f, 0.f, -50.f + rand() % 100);
+		physics.addBall(position, velocity, spin);
+	}
+
+	//table, filet et sol de la scne, et deux raquettes immobiles au bout de la table
+	std::vector<BoxCollider> colliders;
+	glm::mat4 table(1.f), net(1.f), floor(1.f), paddle1(1.f), paddle2(1.f);
+	table[0][0] = 1.8f; table[1][1] = 0.05f; table[2][2] = 1.f; table[3] = glm::vec4(0.f, 0.f, -40.f, 1.f);
+	net[0][0] = 0.02f; net[1][1] = 0.15f; net[2][2] = 0.98f; net[3] = glm::vec4(0.f, 0.075f, -40.f, 1.f);
+	floor[0][0] = 100.f; floor[1][1] = 1.f; floor[2][2] = 100.f; floor[3] = glm::vec4(0.f, -1.25f, -40.f, 1.f);
+	paddle1[0][0] = 0.02f; paddle1[1][1] = 0.2f; paddle1[2][2] = 0.2f; paddle1[3] = glm::vec4(-1.f, 0.2f, -40.f, 1.f);
+	paddle2[0][0] = 0.02f; paddle2[1][1] = 0.2f; paddle2[2][2] = 0.2f; paddle2[3] = glm::vec4(1.f, 0.2f, -40.f, 1.f);
+	colliders.push_back(makeBoxCollider(table, 0.9f, 1.f));
+	colliders.push_back(makeBoxCollider(net, 0.2f, 0.5f));
+	colliders.push_back(makeBoxCollider(floor, 0.7f, 1.f));
+	colliders.push_back(makeBoxCollider(paddle1, 0.85f, 1.f));
+	colliders.push_back(makeBoxCollider(paddle2, 0.85f, 1.f));
+	physics.setColliders(colliders);
+
+	const int nbSteps = 240;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < nbSteps; i++) {
+		physics.step(PHYSICS_TIMESTEP);
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+	double stepMs = ms / nbSteps;
+	printf("%d balls, %d colliders : %.3f ms per step, %.2f ns per ball and step, %.1f simulated seconds per second (fixed step %.2f ms)\n",
+		nbBalls, (int)colliders.size(), stepMs, stepMs * 1e6 / nbBalls, PHYSICS_TIMESTEP * 1000.0 / stepMs, PHYSICS_TIMESTEP * 1000.0);
+}
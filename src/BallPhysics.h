@@ -0,0 +1,74 @@
+#ifndef BALLPHYSICS_H
+#define BALLPHYSICS_H
+
+//GML libraries
+#include <glm/glm.hpp>
+
+#include "vector"
+
+#define PHYSICS_TIMESTEP (1.f / 240.f) //pas fixe de la simulation, en secondes
+#define PHYSICS_MAX_STEPS 8 //pas au plus par image, pour ne pas s'emballer si une image est trs longue
+
+//Paramtres physiques, dans les units de la scne (la table mesure 1.8 de long, soit environ 1.5 m par unit)
+struct PhysicsParameters {
+	float gravity = 6.45f;
+	float drag = 0.14f; //freinage de l'air : a = -drag * |v| * v
+	float magnus = 0.0034f; //effet : a = magnus * (spin x v)
+	float spinDamping = 0.2f; //perte de rotation par seconde
+	float radius = 0.0375f;
+};
+
+//Bote oriente contre laquelle rebondissent les balles (table, filet, raquettes, sol)
+struct BoxCollider {
+	glm::vec3 center;
+	glm::vec3 axes[3]; //axes unitaires de la bote
+	glm::vec3 halfExtents;
+	glm::vec3 velocity; //vitesse de la bote, transmise  la balle au contact
+	float restitution;
+	float grip; //0 : la balle glisse, 1 : elle roule sans glisser aprs le contact
+};
+
+//Bote occupe par le cube [-0.5, 0.5] transform par model
+BoxCollider makeBoxCollider(const glm::mat4& model, float restitution, float grip, const glm::vec3& velocity = glm::vec3(0.f, 0.f, 0.f));
+
+//Simulation d'un grand nombre de balles : position, vitesse et rotation ranges en tableaux spars (SoA)
+//et intgres 4 balles  la fois en SIMD, avec la gravit, le freinage de l'air, l'effet Magnus et les rebonds.
+class BallPhysics
+{
+public:
+	BallPhysics(const PhysicsParameters& parameters = PhysicsParameters());
+
+	int addBall(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& spin);
+	void clear();
+	int getCount() const { return m_count; }
+	glm::vec3 getPosition(int ball) const { return glm::vec3(m_px[ball], m_py[ball], m_pz[ball]); }
+	glm::vec3 getVelocity(int ball) const { return glm::vec3(m_vx[ball], m_vy[ball], m_vz[ball]); }
+	const PhysicsParameters& getParameters() const { return m_parameters; }
+
+	//Les collisionneurs sont remplacs  chaque appel, pour suivre les raquettes
+	void setColliders(const std::vector<BoxCollider>& colliders) { m_colliders = colliders; }
+
+	//Avance de frameTime secondes par pas fixes de PHYSICS_TIMESTEP, le reste est gard pour l'image suivante. Renvoie le nombre de pas.
+	int update(float frameTime);
+	void step(float dt);
+
+private:
+	//balles [begin, end[, begin et end multiples de 4 en SIMD
+	void stepScalar(int begin, int end, float dt);
+	void stepSimd(int begin, int end, float dt);
+
+	PhysicsParameters m_parameters;
+	std::vector<BoxCollider> m_colliders;
+
+	//tableaux complts jusqu' un multiple de 4 par des balles inertes trs loin de la scne
+	std::vector<float> m_px, m_py, m_pz;
+	std::vector<float> m_vx, m_vy, m_vz;
+	std::vector<float> m_wx, m_wy, m_wz;
+	int m_count;
+	float m_accumulator;
+};
+
+//Mesure le cot d'un pas pour nbBalls balles lances sur la table et l'affiche
+void runPhysicsBenchmark(int nbBalls);
+
+#endif
@@ -0,0 +1,188 @@
+#include "Bloom.h"
+
+#include "logger.h"
+
+#include "algorithm"
+#include "stdio.h"
+
+BloomChain::BloomChain(GpuResourceManager& resources) : m_resources(resources), m_sceneWidth(0), m_sceneHeight(0), m_uDownsampleSource(-1), m_uDownsampleUVScale(-1), m_uDownsampleTexel(-1), m_uDownsampleOffset(-1),
+	m_uThreshold(-1), m_uKnee(-1), m_uBlurSource(-1), m_uBlurUVScale(-1), m_uBlurTexel(-1), m_uDirection(-1), m_uAdded(-1), m_uAddedUVScale(-1), m_uAddedTexel(-1), m_uAddedWeight(-1)
+{
+}
+
+bool BloomChain::init(int sceneWidth, int sceneHeight)
+{
+	m_sceneWidth = sceneWidth;
+	m_sceneHeight = sceneHeight;
+	int width = std::max(1, sceneWidth / 2);
+	int height = std::max(1, sceneHeight / 2);
+	if (height > BLOOM_MAX_HEIGHT)
+	{
+		width = std::max(1, width * BLOOM_MAX_HEIGHT / height);
+		height = BLOOM_MAX_HEIGHT;
+	}
+	if (!initLevel(m_levels[0], width, height, "bloom half") || !initLevel(m_levels[1], std::max(1, width / 2), std::max(1, height / 2), "bloom quarter")) {
+		return false;
+	}
+
+	m_downsampleProgram = loadProgram("Shaders/bloom_downsample.frag", "bloom downsample");
+	m_blurProgram = loadProgram("Shaders/bloom_blur.frag", "bloom blur");
+	if (!m_downsampleProgram.isValid() || !m_blurProgram.isValid()) {
+		return false;
+	}
+	GLuint program = m_downsampleProgram.get();
+	m_uDownsampleSource = glGetUniformLocation(program, "uSource");
+	m_uDownsampleUVScale = glGetUniformLocation(program, "uUVScale");
+	m_uDownsampleTexel = glGetUniformLocation(program, "uTexel");
+	m_uDownsampleOffset = glGetUniformLocation(program, "uOffset");
+	m_uThreshold = glGetUniformLocation(program, "uThreshold");
+	m_uKnee = glGetUniformLocation(program, "uKnee");
+	program = m_blurProgram.get();
+	m_uBlurSource = glGetUniformLocation(program, "uSource");
+	m_uBlurUVScale = glGetUniformLocation(program, "uUVScale");
+	m_uBlurTexel = glGetUniformLocation(program, "uTexel");
+	m_uDirection = glGetUniformLocation(program, "uDirection");
+	m_uAdded = glGetUniformLocation(program, "uAdded");
+	m_uAddedUVScale = glGetUniformLocation(program, "uAddedUVScale");
+	m_uAddedTexel = glGetUniformLocation(program, "uAddedTexel");
+	m_uAddedWeight = glGetUniformLocation(program, "uAddedWeight");
+
+	m_vertexArray = m_resources.createVertexArray("bloom");
+	return m_vertexArray.isValid();
+}
+
+bool BloomChain::initLevel(Level& level, int width, int height, const char* label)
+{
+	level.width = width;
+	level.height = height;
+	level.usedWidth = width;
+	level.usedHeight = height;
+	for (int i = 0; i < 2; i++)
+	{
+		//flottants 11-11-10 : 4 octets par pixel comme la cible de la scne, sans canal alpha
+		level.textures[i] = m_resources.createTexture2D(width, height, GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, NULL, label);
+		level.framebuffers[i] = m_resources.createFramebuffer(label);
+		if (!level.textures[i].isValid() || !level.framebuffers[i].isValid()) {
+			return false;
+		}
+		glBindTexture(GL_TEXTURE_2D, level.textures[i].get());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, level.framebuffers[i].get());
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, level.textures[i].get(), 0);
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			ERROR("The %s framebuffer is incomplete (0x%x)\n", label, status);
+			return false;
+		}
+	}
+	return true;
+}
+
+//les passes dessinent le triangle plein cran de upscale.vert
+GpuProgram BloomChain::loadProgram(const char* fragPath, const char* label)
+{
+	FILE* vertFile = fopen("Shaders/upscale.vert", "r");
+	FILE* fragFile = fopen(fragPath, "r");
+	if (vertFile == NULL || fragFile == NULL)
+	{
+		ERROR("Could not open the %s shader files\n", label);
+		if (vertFile != NULL) {
+			fclose(vertFile);
+		}
+		if (fragFile != NULL) {
+			fclose(fragFile);
+		}
+		return GpuProgram();
+	}
+	GpuProgram program = m_resources.adoptProgram(Shader::loadFromFiles(vertFile, fragFile), label);
+
+	fclose(vertFile);
+	fclose(fragFile);
+	return program;
+}
+
+glm::vec2 BloomChain::getUVScale() const
+{
+	return glm::vec2(m_levels[0].usedWidth / (float)m_levels[0].width, m_levels[0].usedHeight / (float)m_levels[0].height);
+}
+
+glm::vec2 BloomChain::getTexel() const
+{
+	return glm::vec2(1.f / m_levels[0].width, 1.f / m_levels[0].height);
+}
+
+void BloomChain::apply(GLuint scene, int renderWidth, int renderHeight)
+{
+	//les niveaux suivent l'chelle de rendu : la zone crite garde la proportion de la zone rendue dans la cible de la scne
+	glBindVertexArray(m_vertexArray.get());
+	downsample(scene, m_sceneWidth, m_sceneHeight, renderWidth, renderHeight, m_levels[0], BLOOM_THRESHOLD);
+	downsample(m_levels[0].textures[0].get(), m_levels[0].width, m_levels[0].height, m_levels[0].usedWidth, m_levels[0].usedHeight, m_levels[1], 0.f);
+	blur(m_levels[1], NULL);
+	blur(m_levels[0], &m_levels[1]);
+
+	glBindVertexArray(0);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void BloomChain::downsample(GLuint source, int sourceWidth, int sourceHeight, int usedWidth, int usedHeight, Level& target, float threshold)
+{
+	target.usedWidth = std::max(1, (usedWidth * target.width + sourceWidth - 1) / sourceWidth);
+	target.usedHeight = std::max(1, (usedHeight * target.height + sourceHeight - 1) / sourceHeight);
+	glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffers[0].get());
+	glViewport(0, 0, target.usedWidth, target.usedHeight);
+
+	glUseProgram(m_downsampleProgram.get());
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, source);
+	glUniform1i(m_uDownsampleSource, 0);
+	glUniform2f(m_uDownsampleUVScale, usedWidth / (float)sourceWidth, usedHeight / (float)sourceHeight);
+	glUniform2f(m_uDownsampleTexel, 1.f / sourceWidth, 1.f / sourceHeight);
+	glUniform2f(m_uDownsampleOffset, 0.5f / target.width, 0.5f / target.height); //coins du texel crit, mme quand le niveau est born par BLOOM_MAX_HEIGHT
+	glUniform1f(m_uThreshold, threshold);
+	glUniform1f(m_uKnee, BLOOM_KNEE);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void BloomChain::blur(Level& level, const Level* added)
+{
+	glUseProgram(m_blurProgram.get());
+	glUniform1i(m_uBlurSource, 0);
+	glUniform1i(m_uAdded, 1);
+	glUniform2f(m_uBlurUVScale, level.usedWidth / (float)level.width, level.usedHeight / (float)level.height);
+	glUniform2f(m_uBlurTexel, 1.f / level.width, 1.f / level.height);
+	glViewport(0, 0, level.usedWidth, level.usedHeight);
+
+	//horizontal : textures[0] -> textures[1], sans ajout
+	glBindFramebuffer(GL_FRAMEBUFFER, level.framebuffers[1].get());
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, level.textures[0].get());
+	glUniform2f(m_uDirection, 1.f, 0.f);
+	glUniform1f(m_uAddedWeight, 0.f);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	//vertical : textures[1] -> textures[0], le niveau plus petit agrandi par le filtrage linaire
+	glBindFramebuffer(GL_FRAMEBUFFER, level.framebuffers[0].get());
+	glBindTexture(GL_TEXTURE_2D, level.textures[1].get());
+	glUniform2f(m_uDirection, 0.f, 1.f);
+	if (added != NULL)
+	{
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, added->textures[0].get());
+		glActiveTexture(GL_TEXTURE0);
+		glUniform2f(m_uAddedUVScale, added->usedWidth / (float)added->width, added->usedHeight / (float)added->height);
+		glUniform2f(m_uAddedTexel, 1.f / added->width, 1.f / added->height);
+		glUniform1f(m_uAddedWeight, 1.f);
+	}
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
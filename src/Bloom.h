@@ -0,0 +1,83 @@
+#ifndef BLOOM_H
+#define BLOOM_H
+
+//OpenGL Libraries
+#include <GL/glew.h>
+
+//GML libraries
+#include <glm/glm.hpp>
+
+#include "GpuResources.h"
+
+#define BLOOM_MAX_HEIGHT 540 //lignes du niveau  demi-rsolution au plus : au-del d'un cran 1080p, le cot du halo ne grandit plus
+#define BLOOM_THRESHOLD 1.f //luminosit  partir de laquelle un pixel diffuse. En HDR, seuls la balle, les reflets forts et les tincelles la dpassent.
+#define BLOOM_KNEE 0.5f //largeur de la transition douce autour du seuil
+#define BLOOM_INTENSITY 0.8f //poids du halo ajout  la scne avant le tonemapping
+
+//Halo des surfaces qui dpassent BLOOM_THRESHOLD dans l'image HDR de la scne. Les pixels brillants sont extraits en rduisant
+//la scne de moiti, rduits encore de moiti, puis chaque niveau est flout par un noyau gaussien sparable (horizontal puis vertical)
+//et le quart de rsolution est agrandi et ajout au flou de la demi-rsolution. Toutes les passes lisent au plus 5 texels filtrs,
+//et la taille des niveaux est borne par BLOOM_MAX_HEIGHT.
+//Comme la cible de la scne, les niveaux ne sont pas recrs quand l'chelle de rendu change : seul leur coin en bas  gauche sert.
+class BloomChain
+{
+public:
+	BloomChain(GpuResourceManager& resources);
+
+	//sceneWidth, sceneHeight : taille de la cible de la scne. Charge les shaders, renvoie false en cas d'chec.
+	bool init(int sceneWidth, int sceneHeight);
+
+	//calcule le halo de la zone [0, renderWidth] x [0, renderHeight] de la texture scene.
+	//Change de framebuffer, de viewport et de programme, le test de profondeur doit tre dsactiv.
+	void apply(GLuint scene, int renderWidth, int renderHeight);
+
+	//rsultat de apply(),  la demi-rsolution
+	GLuint getTexture() const { return m_levels[0].textures[0].get(); }
+	//partie utilise de getTexture() et taille d'un de ses texels
+	glm::vec2 getUVScale() const;
+	glm::vec2 getTexel() const;
+
+private:
+	//deux textures par niveau : le flou horizontal crit dans la seconde, le vertical revient dans la premire
+	struct Level {
+		GpuTexture textures[2];
+		GpuFramebuffer framebuffers[2];
+		int width; //taille des textures
+		int height;
+		int usedWidth; //zone crite  cette image
+		int usedHeight;
+	};
+
+	bool initLevel(Level& level, int width, int height, const char* label);
+	GpuProgram loadProgram(const char* fragPath, const char* label);
+	//rduction de moiti de source vers target, en gardant seulement ce qui dpasse threshold si threshold > 0
+	void downsample(GLuint source, int sourceWidth, int sourceHeight, int usedWidth, int usedHeight, Level& target, float threshold);
+	//flou horizontal puis vertical du niveau, auquel est ajout le niveau added agrandi (NULL sans ajout)
+	void blur(Level& level, const Level* added);
+
+	GpuResourceManager& m_resources;
+	int m_sceneWidth;
+	int m_sceneHeight;
+	Level m_levels[2]; //demi et quart de rsolution
+	GpuVertexArray m_vertexArray; //vide, le triangle plein cran vient de gl_VertexID
+
+	GpuProgram m_downsampleProgram;
+	GLint m_uDownsampleSource;
+	GLint m_uDownsampleUVScale;
+	GLint m_uDownsampleTexel;
+	GLint m_uDownsampleOffset;
+	GLint m_uThreshold;
+	GLint m_uKnee;
+
+	GpuProgram m_blurProgram;
+	GLint m_uBlurSource;
+	GLint m_uBlurUVScale;
+	GLint m_uBlurTexel;
+	GLint m_uDirection;
+	GLint m_uAdded;
+	GLint m_uAddedUVScale;
+	GLint m_uAddedTexel;
+	GLint m_uAddedWeight;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#include "DynamicResolution.h"
+
+#include "algorithm"
+#include "math.h"
+
+DynamicResolution::DynamicResolution(float budgetMs, float minScale, float maxScale, const ResolutionGains& gains) :
+	m_gains(gains), m_budget(budgetMs), m_minScale(minScale), m_maxScale(maxScale), m_scale(maxScale), m_filtered(-1.f), m_previousError(0.f), m_olderError(0.f)
+{
+}
+
+void DynamicResolution::setScale(float scale)
+{
+	m_scale = std::min(m_maxScale, std::max(m_minScale, scale));
+	m_previousError = 0.f;
+	m_olderError = 0.f;
+}
+
+float DynamicResolution::update(float frameMs)
+{
+	m_filtered = m_filtered < 0.f ? frameMs : m_filtered + m_gains.smoothing * (frameMs - m_filtered);
+
+	float error = (m_budget - m_filtered) / m_budget;
+	if (fabsf(error) < m_gains.deadZone) {
+		error = 0.f;
+	}
+
+	//forme incrmentale : on corrige l'aire de l'image prcdente, ce qui tient lieu d'intgrale
+	//et n'accumule rien tant que l'aire est bloque  une borne
+	float delta = m_gains.proportional * (error - m_previousError) + m_gains.integral * error
+		+ m_gains.derivative * (error - 2.f * m_previousError + m_olderError);
+	m_olderError = m_previousError;
+	m_previousError = error;
+
+	float area = m_scale * m_scale + delta;
+	area = std::min(m_maxScale * m_maxScale, std::max(m_minScale * m_minScale, area));
+	m_scale = sqrtf(area);
+	return m_scale;
+}
@@ -0,0 +1,41 @@
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+
+#define RESOLUTION_MIN_SCALE 0.5f //en dessous, l'image agrandie devient trop floue
+#define RESOLUTION_MAX_SCALE 1.f
+
+//Rglages du rgulateur PID. L'erreur est la marge relative sur le budget : (budget - dure) / budget.
+struct ResolutionGains {
+	float proportional = 0.2f;
+	float integral = 0.1f;
+	float derivative = 0.05f;
+	float smoothing = 0.2f; //poids de la nouvelle mesure dans la moyenne glissante des dures
+	float deadZone = 0.05f; //marge relative en dessous de laquelle l'chelle ne bouge pas
+};
+
+//Choisit l'chelle de rendu (largeur et hauteur relatives  la fentre) pour que la dure de rendu mesure reste sous le budget.
+//Le cot d'une image suit le nombre de pixels : le rgulateur agit sur l'aire, scale = sqrt(aire).
+class DynamicResolution
+{
+public:
+	//budgetMs : dure de rendu vise pour une image
+	DynamicResolution(float budgetMs, float minScale = RESOLUTION_MIN_SCALE, float maxScale = RESOLUTION_MAX_SCALE, const ResolutionGains& gains = ResolutionGains());
+
+	//prend en compte la dure de rendu de la dernire image et renvoie la nouvelle chelle
+	float update(float frameMs);
+	float getScale() const { return m_scale; }
+	//chelle impose, le rgulateur repart de l
+	void setScale(float scale);
+
+private:
+	ResolutionGains m_gains;
+	float m_budget;
+	float m_minScale;
+	float m_maxScale;
+	float m_scale;
+	float m_filtered; //dure moyenne, -1 avant la premire mesure
+	float m_previousError; //erreurs des deux mesures prcdentes
+	float m_olderError;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include "FrameArena.h"
+
+#include "algorithm"
+
+#define FRAME_ARENA_OVERFLOWS 16 //dpassements prvus en une image avant que la liste elle-mme ne grandisse
+
+FrameArena::FrameArena(size_t capacity) : m_block(new uint8_t[capacity]), m_capacity(capacity), m_used(0), m_requested(0), m_peak(0)
+{
+	m_overflow.reserve(FRAME_ARENA_OVERFLOWS);
+}
+
+FrameArena::~FrameArena()
+{
+	reset();
+	delete[] m_block;
+}
+
+void FrameArena::reset()
+{
+	for (size_t i = 0; i < m_overflow.size(); i++) {
+		delete[] m_overflow[i];
+	}
+	m_overflow.clear();
+
+	m_peak = std::max(m_peak, m_requested);
+	if (m_requested > m_capacity)
+	{
+		//une marge pour ne pas agrandir  chaque image qui en demande un peu plus
+		m_capacity = m_requested + m_requested / 2;
+		delete[] m_block;
+		m_block = new uint8_t[m_capacity];
+	}
+	m_used = 0;
+	m_requested = 0;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+	size_t offset = (m_used + alignment - 1) & ~(alignment - 1);
+	m_requested += size + alignment;
+	if (offset + size <= m_capacity)
+	{
+		m_used = offset + size;
+		return m_block + offset;
+	}
+
+	uint8_t* overflow = new uint8_t[size + alignment];
+	m_overflow.push_back(overflow);
+	return (void*)(((uintptr_t)overflow + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
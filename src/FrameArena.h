@@ -0,0 +1,42 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include "stddef.h"
+#include "stdint.h"
+#include "vector"
+
+#define FRAME_ARENA_SIZE (1 << 20) //taille initiale du bloc, en octets
+
+//Mmoire de travail d'une image : chaque allocation avance un pointeur dans un seul bloc, et reset() libre tout d'un coup.
+//Un dpassement est servi par le tas, puis le bloc est agrandi au reset() suivant  ce que l'image a utilis :
+//passes les premires images, plus rien n'est allou. Les objets n'y sont jamais dtruits, on n'y met que des types simples.
+//Un seul thread alloue  la fois, les autres peuvent lire ce qui a t allou.
+class FrameArena
+{
+public:
+	FrameArena(size_t capacity = FRAME_ARENA_SIZE);
+	~FrameArena();
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	//dbut d'image : tout ce qui a t allou depuis le reset() prcdent devient invalide
+	void reset();
+	//alignment : puissance de 2, au plus 16
+	void* allocate(size_t size, size_t alignment = 16);
+	template<typename T>
+	T* allocateArray(size_t count) { return (T*)allocate(count * sizeof(T), alignof(T)); }
+
+	size_t getCapacity() const { return m_capacity; }
+	//plus grande quantit utilise en une image
+	size_t getPeak() const { return m_peak; }
+
+private:
+	uint8_t* m_block;
+	size_t m_capacity;
+	size_t m_used; //dans le bloc
+	size_t m_requested; //depuis le dernier reset(), dpassements compris
+	size_t m_peak;
+	std::vector<uint8_t*> m_overflow; //allocations servies par le tas, libres au reset()
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include "FrameCapture.h"
+
+//SDL Libraries
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#include "logger.h"
+
+#include "algorithm"
+#include "string.h"
+
+FrameCapture::FrameCapture() : m_y4m(false), m_video(NULL), m_width(0), m_height(0), m_firstJob(0), m_nbJobs(0), m_submitted(0), m_nextWrite(0), m_failures(0), m_waits(0), m_stop(false)
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+	close();
+}
+
+bool FrameCapture::open(const char* path, int width, int height, int framerate, int nbThreads)
+{
+	m_path = path;
+	m_width = width;
+	m_height = height;
+	m_y4m = m_path.size() > 4 && m_path.compare(m_path.size() - 4, 4, ".y4m") == 0;
+	if (m_y4m)
+	{
+		m_video = fopen(path, "wb");
+		if (m_video == NULL) {
+			ERROR("Could not open the capture file %s\n", path);
+			return false;
+		}
+		//C420jpeg : chrominance sous-chantillonne 2x2, valeurs pleine chelle
+		fprintf(m_video, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, framerate);
+	}
+	else if (m_path.find('%') == std::string::npos)
+	{
+		ERROR("The capture path %s must end with .y4m or contain a frame number format like %%05d\n", path);
+		return false;
+	}
+
+	for (int i = 0; i < CAPTURE_BUFFERS; i++)
+	{
+		m_buffers.push_back(new uint8_t[4 * width * height]);
+		m_free.push_back(m_buffers.back());
+	}
+
+	if (nbThreads <= 0) {
+		nbThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	m_stop = false;
+	for (int i = 0; i < nbThreads; i++) {
+		m_workers.push_back(std::thread(&FrameCapture::workerLoop, this));
+	}
+	return true;
+}
+
+uint8_t* FrameCapture::acquireFrame()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (m_free.empty()) {
+		m_waits++;
+	}
+	m_released.wait(lock, [this] { return !m_free.empty(); });
+	uint8_t* pixels = m_free.back();
+	m_free.pop_back();
+	return pixels;
+}
+
+void FrameCapture::submitFrame(uint8_t* pixels, bool bottomUp)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Job job = { pixels, bottomUp, m_submitted++ };
+		m_jobs[(m_firstJob + m_nbJobs) % CAPTURE_BUFFERS] = job;
+		m_nbJobs++;
+	}
+	m_wake.notify_one();
+}
+
+void FrameCapture::close()
+{
+	if (m_workers.empty()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++) {
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	if (m_video != NULL) {
+		fclose(m_video);
+		m_video = NULL;
+	}
+	for (size_t i = 0; i < m_buffers.size(); i++) {
+		delete[] m_buffers[i];
+	}
+	m_buffers.clear();
+	m_free.clear();
+
+	printf("%u frames captured to %s, %u failed, render thread waited %u times for a free buffer\n", m_submitted, m_path.c_str(), m_failures, m_waits);
+}
+
+void FrameCapture::releaseBuffer(uint8_t* pixels)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_free.push_back(pixels);
+	}
+	m_released.notify_one();
+}
+
+//Chaque thread prend les images dans l'ordre de soumission. Pour la vido, il attend que l'image prcdente soit crite avant d'crire la sienne.
+void FrameCapture::workerLoop()
+{
+	std::vector<uint8_t> yuv;
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this] { return m_stop || m_nbJobs > 0; });
+			if (m_nbJobs == 0) {
+				return; //arrt demand et plus rien  encoder
+			}
+			job = m_jobs[m_firstJob];
+			m_firstJob = (m_firstJob + 1) % CAPTURE_BUFFERS;
+			m_nbJobs--;
+		}
+
+		bool ok = true;
+		if (m_y4m)
+		{
+			convertY4M(job, yuv);
+			releaseBuffer(job.pixels);
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_written.wait(lock, [this, &job] { return m_nextWrite == job.index; });
+			ok = fwrite("FRAME\n", 1, 6, m_video) == 6 && fwrite(&yuv[0], 1, yuv.size(), m_video) == yuv.size();
+			m_nextWrite++;
+			if (!ok) {
+				m_failures++;
+			}
+			lock.unlock();
+			m_written.notify_all();
+		}
+		else
+		{
+			ok = writePNG(job);
+			releaseBuffer(job.pixels);
+			if (!ok) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_failures++;
+			}
+		}
+	}
+}
+
+bool FrameCapture::writePNG(const Job& job)
+{
+	int pitch = 4 * m_width;
+	if (job.bottomUp)
+	{
+		//change des lignes sur place, sans tampon  allouer pour chaque image
+		for (int y = 0; y < m_height / 2; y++)
+		{
+			uint8_t* top = job.pixels + y * pitch;
+			std::swap_ranges(top, top + pitch, job.pixels + (m_height - 1 - y) * pitch);
+		}
+	}
+
+	char fileName[1024];
+	snprintf(fileName, sizeof(fileName), m_path.c_str(), job.index);
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(job.pixels, m_width, m_height, 32, pitch, SDL_PIXELFORMAT_RGBA32);
+	if (surface == NULL) {
+		return false;
+	}
+	bool ok = IMG_SavePNG(surface, fileName) == 0;
+	SDL_FreeSurface(surface);
+	if (!ok) {
+		ERROR("Could not write the capture %s : %s\n", fileName, SDL_GetError());
+	}
+	return ok;
+}
+
+//RGBA vers YCbCr BT.601 pleine chelle en virgule fixe (8 bits de fraction), la chrominance est la moyenne de chaque bloc 2x2
+void FrameCapture::convertY4M(const Job& job, std::vector<uint8_t>& yuv) const
+{
+	int chromaWidth = (m_width + 1) / 2;
+	int chromaHeight = (m_height + 1) / 2;
+	yuv.resize(m_width * m_height + 2 * chromaWidth * chromaHeight);
+	uint8_t* planeY = &yuv[0];
+	uint8_t* planeU = planeY + m_width * m_height;
+	uint8_t* planeV = planeU + chromaWidth * chromaHeight;
+
+	for (int cy = 0; cy < chromaHeight; cy++)
+	{
+		for (int cx = 0; cx < chromaWidth; cx++)
+		{
+			int sumR = 0, sumG = 0, sumB = 0, count = 0;
+			for (int dy = 0; dy < 2; dy++)
+			{
+				int y = std::min(2 * cy + dy, m_height - 1);
+				int sourceY = job.bottomUp ? m_height - 1 - y : y;
+				for (int dx = 0; dx < 2; dx++)
+				{
+					int x = std::min(2 * cx + dx, m_width - 1);
+					const uint8_t* p = job.pixels + 4 * (sourceY * m_width + x);
+					planeY[y * m_width + x] = (uint8_t)((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+					sumR += p[0];
+					sumG += p[1];
+					sumB += p[2];
+					count++;
+				}
+			}
+			int r = sumR / count, g = sumG / count, b = sumB / count;
+			planeU[cy * chromaWidth + cx] = (uint8_t)std::min(255, std::max(0, (-43 * r - 85 * g + 128 * b + 128) / 256 + 128));
+			planeV[cy * chromaWidth + cx] = (uint8_t)std::min(255, std::max(0, (128 * r - 107 * g - 21 * b + 128) / 256 + 128));
+		}
+	}
+}
@@ -0,0 +1,73 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include "stdint.h"
+#include "stdio.h"
+#include "string"
+#include "vector"
+#include "thread"
+#include "mutex"
+#include "condition_variable"
+
+#define CAPTURE_BUFFERS 8 //images en attente d'encodage au plus, au-del le rendu attend les threads d'encodage
+
+//Enregistre les images affiches, soit en squence de PNG (chemin contenant un format printf, ex : capture/frame%05d.png),
+//soit en vido Y4M non compresse (chemin se terminant par .y4m).
+//Le thread de rendu ne fait que copier les pixels dans un tampon libre, l'encodage est fait par des threads de travail.
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	//nbThreads = 0 utilise tous les coeurs
+	bool open(const char* path, int width, int height, int framerate, int nbThreads = 0);
+	bool isOpen() const { return !m_workers.empty(); }
+	int getWidth() const { return m_width; }
+	int getHeight() const { return m_height; }
+
+	//Renvoie un tampon RGBA8 de width * height pixels  remplir, attend si tous les tampons sont en cours d'encodage
+	uint8_t* acquireFrame();
+	//Confie le tampon aux threads d'encodage. bottomUp : la premire ligne est celle du bas, comme glReadPixels
+	void submitFrame(uint8_t* pixels, bool bottomUp);
+
+	//Attend la fin des encodages en cours et ferme le fichier
+	void close();
+
+private:
+	struct Job {
+		uint8_t* pixels;
+		bool bottomUp;
+		uint32_t index;
+	};
+
+	void workerLoop();
+	bool writePNG(const Job& job);
+	void convertY4M(const Job& job, std::vector<uint8_t>& yuv) const;
+	void releaseBuffer(uint8_t* pixels);
+
+	std::string m_path;
+	bool m_y4m;
+	FILE* m_video;
+	int m_width;
+	int m_height;
+
+	std::vector<uint8_t*> m_buffers; //tous les tampons, librs  la fermeture
+	std::vector<uint8_t*> m_free;
+	Job m_jobs[CAPTURE_BUFFERS]; //file circulaire : chaque image en attente tient un tampon, il n'y en a jamais plus que de tampons
+	int m_firstJob;
+	int m_nbJobs;
+	uint32_t m_submitted;
+	uint32_t m_nextWrite; //prochaine image  crire dans la vido, les conversions se font en parallle mais l'criture dans l'ordre
+	uint32_t m_failures;
+	uint32_t m_waits; //nombre de fois o le rendu a d attendre un tampon libre
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_wake; //nouvelle image  encoder
+	std::condition_variable m_released; //tampon libr
+	std::condition_variable m_written; //image crite dans la vido
+	bool m_stop;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "FramePacer.h"
+
+#include "algorithm"
+#include "math.h"
+#include "stdio.h"
+#include "string.h"
+
+FramePacer::FramePacer() : m_frequency((double)SDL_GetPerformanceFrequency()), m_period(0.0), m_deadline(0.0), m_rate(0.f), m_refreshRate(0), m_swapInterval(0),
+	m_waits(true), m_spin(0.0), m_lastWaitMs(0.f), m_lastPresent(0), m_intervals(0), m_missed(0), m_jitterSum(0.0), m_jitterSquares(0.0), m_maxJitter(0.0), m_maxOversleep(0.0)
+{
+	memset(m_histogram, 0, sizeof(m_histogram));
+}
+
+int FramePacer::configure(SDL_Window* window, float rate, int swapInterval)
+{
+	m_rate = rate;
+	m_period = m_frequency / rate;
+	m_spin = PACER_SPIN_MS * 1e-3 * m_frequency;
+	m_deadline = 0.0;
+
+	SDL_DisplayMode mode;
+	m_refreshRate = SDL_GetWindowDisplayMode(window, &mode) == 0 ? mode.refresh_rate : 0;
+	bool displayMatches = m_refreshRate > 0 && fabsf(m_refreshRate - rate) < 1.f;
+	if (swapInterval == SWAP_INTERVAL_AUTO) {
+		swapInterval = displayMatches ? 1 : 0;
+	}
+
+	if (SDL_GL_GetCurrentContext() != NULL)
+	{
+		if (SDL_GL_SetSwapInterval(swapInterval) != 0 && swapInterval == -1) {
+			SDL_GL_SetSwapInterval(1); //pas de synchronisation adaptative sur ce pilote
+		}
+		m_swapInterval = SDL_GL_GetSwapInterval();
+	}
+	else {
+		m_swapInterval = 0;
+	}
+	//synchronis sur un cran plus rapide ou plus lent, l'affichage attend aussi l'chance
+	m_waits = m_swapInterval == 0 || !displayMatches;
+	return m_swapInterval;
+}
+
+void FramePacer::waitForDeadline()
+{
+	Uint64 begin = SDL_GetPerformanceCounter();
+	m_lastWaitMs = 0.f;
+	if (m_deadline == 0.0 || !m_waits) {
+		return;
+	}
+	if (begin > m_deadline + m_period)
+	{
+		m_missed++;
+		m_deadline = (double)begin; //les chances repartent de cette image
+		return;
+	}
+
+	double sleep = m_deadline - m_spin - begin;
+	if (sleep > 0.0)
+	{
+		Uint32 sleepMs = (Uint32)(sleep * 1e3 / m_frequency);
+		if (sleepMs > 0)
+		{
+			SDL_Delay(sleepMs);
+			double oversleep = (SDL_GetPerformanceCounter() - begin) - sleepMs * 1e-3 * m_frequency;
+			m_maxOversleep = std::max(m_maxOversleep, oversleep * 1e3 / m_frequency);
+			if (oversleep > m_spin) {
+				m_spin = std::min(oversleep, m_period / 2.0);
+			}
+		}
+	}
+	while (SDL_GetPerformanceCounter() < m_deadline) {
+	}
+	m_lastWaitMs = (float)((SDL_GetPerformanceCounter() - begin) * 1e3 / m_frequency);
+}
+
+void FramePacer::framePresented()
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+	if (m_lastPresent != 0)
+	{
+		double jitter = (now - m_lastPresent) * 1e3 / m_frequency - 1e3 / m_rate;
+		m_intervals++;
+		m_jitterSum += jitter;
+		m_jitterSquares += jitter * jitter;
+		m_maxJitter = std::max(m_maxJitter, fabs(jitter));
+		int bucket = (int)floor(jitter * 1e3 / PACER_HISTOGRAM_US) + PACER_HISTOGRAM_BUCKETS / 2;
+		m_histogram[std::min(std::max(bucket, 0), PACER_HISTOGRAM_BUCKETS - 1)]++;
+	}
+	m_lastPresent = now;
+	m_deadline = m_deadline == 0.0 ? now + m_period : m_deadline + m_period;
+}
+
+void FramePacer::printReport() const
+{
+	if (m_intervals == 0) {
+		return;
+	}
+	double mean = m_jitterSum / m_intervals;
+	double deviation = sqrt(std::max(0.0, m_jitterSquares / m_intervals - mean * mean));
+	printf("Frame pacing at %.0f Hz (display %d Hz, swap interval %d, %s) : %u frames, mean interval %.3f ms, jitter %.3f ms std dev, %.3f ms max, %u missed deadlines, SDL_Delay oversleep up to %.2f ms\n",
+		m_rate, m_refreshRate, m_swapInterval, m_waits ? "timer" : "vsync", m_intervals, 1e3 / m_rate + mean, deviation, m_maxJitter, m_missed, m_maxOversleep);
+
+	uint32_t highest = *std::max_element(m_histogram, m_histogram + PACER_HISTOGRAM_BUCKETS);
+	for (int b = 0; b < PACER_HISTOGRAM_BUCKETS; b++)
+	{
+		if (m_histogram[b] == 0) {
+			continue;
+		}
+		char bar[51];
+		int length = (int)(50ull * m_histogram[b] / highest);
+		memset(bar, '#', length);
+		bar[length] = '\0';
+		double from = (b - PACER_HISTOGRAM_BUCKETS / 2) * PACER_HISTOGRAM_US * 1e-3;
+		const char* bound = b == 0 ? "<" : (b == PACER_HISTOGRAM_BUCKETS - 1 ? ">" : " "); //les intervalles extrmes comptent aussi les carts au-del
+		printf("  %s%+6.2f ms %8u %s\n", bound, b == 0 ? from + PACER_HISTOGRAM_US * 1e-3 : from, m_histogram[b], bar);
+	}
+}
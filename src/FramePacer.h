@@ -0,0 +1,58 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+//SDL Libraries
+#include <SDL2/SDL.h>
+
+#include "stdint.h"
+
+#define PACER_SPIN_MS 1.f //marge de dpart de l'attente active : SDL_Delay peut rendre la main plus tard que demand
+#define PACER_HISTOGRAM_US 250 //largeur d'un intervalle de l'histogramme de gigue
+#define PACER_HISTOGRAM_BUCKETS 40 //de -5  +5 ms autour de la priode, les carts plus grands vont dans les intervalles extrmes
+#define SWAP_INTERVAL_AUTO 2 //synchronisation verticale seulement si l'cran suit dj la frquence vise
+
+//Cadence d'affichage par chances absolues, mesures par SDL_GetPerformanceCounter : l'image k est affiche  dbut + k * priode.
+//Une image un peu en retard ne dcale pas les suivantes ; avec plus d'une priode de retard, les chances repartent de maintenant
+//au lieu d'enchaner des images pour rattraper. L'attente dort avec SDL_Delay jusqu' peu avant l'chance et finit en boucle active,
+//la marge suit le pire retard observ de SDL_Delay. Quand la synchronisation verticale tient dj la frquence, le pacer ne fait que mesurer.
+//La gigue est l'cart entre la dure d'un affichage au suivant et la priode.
+class FramePacer
+{
+public:
+	FramePacer();
+
+	//rate : images par seconde. swapInterval : 0 sans synchronisation verticale, 1 avec, -1 adaptative, ou SWAP_INTERVAL_AUTO.
+	//Sans contexte OpenGL, la fentre n'est pas synchronise. Renvoie l'intervalle obtenu.
+	int configure(SDL_Window* window, float rate, int swapInterval);
+
+	//appel par le moteur juste avant d'afficher l'image
+	void waitForDeadline();
+	//appel par le moteur juste aprs l'affichage
+	void framePresented();
+
+	//dure passe  attendre l'chance pour la dernire image, en ms
+	float getLastWaitMs() const { return m_lastWaitMs; }
+	void printReport() const;
+
+private:
+	double m_frequency; //ticks de SDL_GetPerformanceCounter par seconde
+	double m_period; //en ticks
+	double m_deadline; //0 avant la premire image
+	float m_rate;
+	int m_refreshRate; //de l'cran, 0 s'il n'est pas connu
+	int m_swapInterval;
+	bool m_waits; //false quand la synchronisation verticale suffit
+	double m_spin; //marge d'attente active en ticks
+	float m_lastWaitMs;
+
+	Uint64 m_lastPresent; //0 avant le premier affichage
+	uint32_t m_intervals;
+	uint32_t m_missed; //chances rates de plus d'une priode
+	double m_jitterSum; //en ms
+	double m_jitterSquares;
+	double m_maxJitter; //en valeur absolue
+	double m_maxOversleep; //pire retard de SDL_Delay, en ms
+	uint32_t m_histogram[PACER_HISTOGRAM_BUCKETS];
+};
+
+#endif
@@ -0,0 +1,925 @@
+#include "GLBackend.h"
+#include "FrameCapture.h"
+#include "FramePacer.h"
+#include "ParticleSystem.h"
+#include "Skybox.h"
+
+#include "logger.h"
+
+//GML libraries
+#include <glm/gtc/type_ptr.hpp>
+
+#include "algorithm"
+#include "stddef.h"
+#include "string.h"
+
+#define INDICE_TO_PTR(x) ((void*)(x))
+
+//les shaders d'une passe de la scne lisent les matrices des yeux au point 1
+static void bindStereoBlock(GLuint program)
+{
+	GLuint block = glGetUniformBlockIndex(program, "StereoBlock");
+	if (block != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program, block, 1);
+	}
+}
+
+GLBackend::GLBackend(SDL_Window* window, size_t vramBudget) : m_window(window), m_resources(vramBudget), m_stream(m_resources), m_width(0), m_height(0), m_nbEyes(1),
+	m_variants(m_resources), m_residency(m_resources), m_vPosition(-1), m_vNormal(-1), m_vUV(-1), m_uniformAlignment(256), m_vDepthPosition(-1), m_culler(m_resources), m_occlusionCulling(true),
+	m_shadows(m_resources), m_shadowLight(false),
+	m_vParticle(-1), m_vParticleColor(-1), m_uViewProjection(-1), m_uPointSize(-1), m_stereoOffset(0), m_stereoUploaded(false), m_skybox(-1), m_uSkybox(-1), m_uInverseViewProjection(-1),
+	m_uScene(-1), m_uUVScale(-1), m_uTexel(-1), m_uSharpness(-1), m_bloom(m_resources), m_bloomEnabled(true), m_uBloom(-1), m_uBloomUVScale(-1), m_uBloomTexel(-1), m_uBloomIntensity(-1),
+	m_renderScale(1.f), m_nextRenderScale(1.f), m_renderWidth(0), m_renderHeight(0),
+	m_timersIssued(0), m_timersRead(0), m_timing(false), m_renderTime(-1.f), m_capture(NULL), m_captureIssued(0), m_pacer(NULL)
+{
+	for (int i = 0; i < NB_MATERIAL_VARIANTS; i++) {
+		m_pageSamplers[i] = false;
+	}
+}
+
+GLBackend::~GLBackend()
+{
+	setCapture(NULL);
+}
+
+bool GLBackend::init()
+{
+	//On charge les fichiers relatifs aux shaders. Les variantes sont compiles  leur premire utilisation,
+	//sauf la plus complte qui vrifie tout de suite que les sources compilent.
+	const char* attributes[] = { "vPosition", "vNormal", "vUV", NULL };
+	const char* blocks[] = { "DrawBlock", "StereoBlock", NULL };
+	if (!m_variants.load("Shaders/color.vert", "Shaders/color.frag", "color", attributes, blocks)
+		|| m_variants.get(MATERIAL_TEXTURED | MATERIAL_DIFFUSE | MATERIAL_SPECULAR) == 0) {
+		return false;
+	}
+
+	//les attributs ont les mmes indices dans toutes les variantes, un VAO sert pour toutes
+	m_vPosition = m_variants.getAttribute("vPosition");
+	m_vNormal = m_variants.getAttribute("vNormal");
+	m_vUV = m_variants.getAttribute("vUV");
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_uniformAlignment);
+	if (!initParticles() || !initSkybox() || !initStereo()) {
+		return false;
+	}
+
+	//shader de la pr-passe de profondeur, il lit le mme DrawBlock
+	FILE* vertFile = fopen("Shaders/depth.vert", "r");
+	FILE* fragFile = fopen("Shaders/depth.frag", "r");
+	if (vertFile == NULL || fragFile == NULL) {
+		ERROR("Could not open the depth shader files\n");
+		return false;
+	}
+	m_depthProgram = m_resources.adoptProgram(Shader::loadFromFiles(vertFile, fragFile), "depth");
+
+	fclose(vertFile);
+	fclose(fragFile);
+	if (!m_depthProgram.isValid()) {
+		return false;
+	}
+	m_vDepthPosition = glGetAttribLocation(m_depthProgram.get(), "vPosition");
+	glUniformBlockBinding(m_depthProgram.get(), glGetUniformBlockIndex(m_depthProgram.get(), "DrawBlock"), 0);
+	bindStereoBlock(m_depthProgram.get());
+
+	return initSceneTarget() && m_culler.init() && m_shadows.init() && m_stream.init() && m_residency.init();
+}
+
+bool GLBackend::initParticles()
+{
+	FILE* vertFile = fopen("Shaders/particle.vert", "r");
+	FILE* fragFile = fopen("Shaders/particle.frag", "r");
+	if (vertFile == NULL || fragFile == NULL) {
+		ERROR("Could not open the particle shader files\n");
+		return false;
+	}
+	m_particleProgram = m_resources.adoptProgram(Shader::loadFromFiles(vertFile, fragFile), "particle");
+
+	fclose(vertFile);
+	fclose(fragFile);
+	if (!m_particleProgram.isValid()) {
+		return false;
+	}
+
+	GLuint program = m_particleProgram.get();
+	m_vParticle = glGetAttribLocation(program, "vParticle");
+	m_vParticleColor = glGetAttribLocation(program, "vColor");
+	m_uViewProjection = glGetUniformLocation(program, "uViewProjection");
+	m_uPointSize = glGetUniformLocation(program, "uPointSize");
+	bindStereoBlock(program);
+	m_particleVertexArray = m_resources.createVertexArray("particles");
+	return m_particleVertexArray.isValid();
+}
+
+bool GLBackend::initSkybox()
+{
+	FILE* vertFile = fopen("Shaders/skybox.vert", "r");
+	FILE* fragFile = fopen("Shaders/skybox.frag", "r");
+	if (vertFile == NULL || fragFile == NULL) {
+		ERROR("Could not open the skybox shader files\n");
+		return false;
+	}
+	m_skyboxProgram = m_resources.adoptProgram(Shader::loadFromFiles(vertFile, fragFile), "skybox");
+
+	fclose(vertFile);
+	fclose(fragFile);
+	if (!m_skyboxProgram.isValid()) {
+		return false;
+	}
+	m_uSkybox = glGetUniformLocation(m_skyboxProgram.get(), "uSkybox");
+	m_uInverseViewProjection = glGetUniformLocation(m_skyboxProgram.get(), "uInverseViewProjection");
+	bindStereoBlock(m_skyboxProgram.get());
+	return true;
+}
+
+bool GLBackend::initStereo()
+{
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	m_stereoOffset = ((GLintptr)sizeof(StereoBlock) + alignment - 1) / alignment * alignment;
+	m_stereoBuffer = m_resources.createBuffer(GL_UNIFORM_BUFFER, m_stereoOffset + sizeof(StereoBlock), NULL, GL_DYNAMIC_DRAW, "stereo");
+	if (!m_stereoBuffer.isValid()) {
+		return false;
+	}
+
+	//vue unique : une seule instance, sans transformation, et un plan de coupe que tous les sommets visibles (w > 0) respectent
+	StereoBlock mono;
+	for (int eye = 0; eye < 2; eye++)
+	{
+		mono.eyes[eye] = glm::mat4(1.f);
+		mono.planes[eye] = glm::vec4(0.f, 0.f, 0.f, 1.f);
+		mono.layouts[eye] = glm::vec4(1.f, 0.f, 1.f, 0.f);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, m_stereoBuffer.get());
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(StereoBlock), &mono);
+	glBufferSubData(GL_UNIFORM_BUFFER, m_stereoOffset, sizeof(StereoBlock), &mono);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	return true;
+}
+
+bool GLBackend::setStereo(const StereoViews* views)
+{
+	m_nbEyes = views != NULL ? 2 : 1;
+	if (views == NULL || (m_stereoUploaded && memcmp(views, &m_stereoViews, sizeof(StereoViews)) == 0)) {
+		return true;
+	}
+
+	m_stereoViews = *views;
+	m_stereoUploaded = true;
+	StereoBlock block;
+	for (int eye = 0; eye < 2; eye++)
+	{
+		block.eyes[eye] = views->eyes[eye];
+		block.planes[eye] = views->clipPlanes[eye];
+		block.layouts[eye] = views->layouts[eye];
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, m_stereoBuffer.get());
+	glBufferSubData(GL_UNIFORM_BUFFER, m_stereoOffset, sizeof(StereoBlock), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	return true;
+}
+
+bool GLBackend::initSceneTarget()
+{
+	SDL_GL_GetDrawableSize(m_window, &m_width, &m_height);
+	m_renderWidth = m_width;
+	m_renderHeight = m_height;
+
+	//flottants 11-11-10 : les couleurs au-dessus de 1 alimentent le bloom, pour la mme mmoire que RGBA8
+	m_sceneColor = m_resources.createTexture2D(m_width, m_height, GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, NULL, "scene color");
+	m_sceneDepth = m_resources.createTexture2D(m_width, m_height, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, NULL, "scene depth");
+	m_sceneFramebuffer = m_resources.createFramebuffer("scene");
+	if (!m_sceneColor.isValid() || !m_sceneDepth.isValid() || !m_sceneFramebuffer.isValid()) {
+		return false;
+	}
+
+	//filtrage linaire pour l'agrandissement, les lectures hors de la zone rendue sont bornes dans upscale.frag
+	glBindTexture(GL_TEXTURE_2D, m_sceneColor.get());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, m_sceneDepth.get());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_sceneFramebuffer.get());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_sceneColor.get(), 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_sceneDepth.get(), 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		ERROR("The scene framebuffer is incomplete (0x%x)\n", status);
+		return false;
+	}
+
+	FILE* vertFile = fopen("Shaders/upscale.vert", "r");
+	FILE* fragFile = fopen("Shaders/upscale.frag", "r");
+	if (vertFile == NULL || fragFile == NULL) {
+		ERROR("Could not open the upscale shader files\n");
+		return false;
+	}
+	m_upscaleProgram = m_resources.adoptProgram(Shader::loadFromFiles(vertFile, fragFile), "upscale");
+
+	fclose(vertFile);
+	fclose(fragFile);
+	if (!m_upscaleProgram.isValid()) {
+		return false;
+	}
+	GLuint program = m_upscaleProgram.get();
+	m_uScene = glGetUniformLocation(program, "uScene");
+	m_uUVScale = glGetUniformLocation(program, "uUVScale");
+	m_uTexel = glGetUniformLocation(program, "uTexel");
+	m_uSharpness = glGetUniformLocation(program, "uSharpness");
+	m_uBloom = glGetUniformLocation(program, "uBloom");
+	m_uBloomUVScale = glGetUniformLocation(program, "uBloomUVScale");
+	m_uBloomTexel = glGetUniformLocation(program, "uBloomTexel");
+	m_uBloomIntensity = glGetUniformLocation(program, "uBloomIntensity");
+	m_upscaleVertexArray = m_resources.createVertexArray("upscale");
+	if (!m_bloom.init(m_width, m_height)) {
+		return false;
+	}
+
+	if (GLEW_ARB_timer_query)
+	{
+		for (int i = 0; i < GPU_TIMER_QUERIES; i++) {
+			m_timers[i] = m_resources.createQuery("frame timer");
+		}
+	}
+	return m_upscaleVertexArray.isValid();
+}
+
+int GLBackend::createMesh(const float* positions, const float* normals, const float* uvs, int nbVertices)
+{
+	QuantizedMesh quantized;
+	quantizeMesh(positions, normals, uvs, nbVertices, quantized);
+
+	Mesh mesh;
+	mesh.nbVertices = nbVertices;
+	mesh.boxMin = quantized.boxMin;
+	mesh.boxMax = quantized.boxMin + quantized.boxExtent;
+	int index = (int)m_meshes.size();
+	std::string label = "mesh " + std::to_string(index);
+
+	mesh.vertices = m_resources.createBuffer(GL_ARRAY_BUFFER, sizeof(QuantizedVertex) * nbVertices, quantized.vertices.data(), GL_STATIC_DRAW, label.c_str());
+	if (!mesh.vertices.isValid()) {
+		return -1;
+	}
+
+	//le VAO retient une fois pour toutes le format de chaque attribut : positions normalises sur [0, 1] dans la bote,
+	//normales en entiers (diviss dans color.vert, la conversion des entiers normaliss signs a chang avec OpenGL 4.2)
+	GLsizei stride = sizeof(QuantizedVertex);
+	mesh.vertexArray = m_resources.createVertexArray(label.c_str());
+	glBindVertexArray(mesh.vertexArray.get());
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertices.get());
+	glVertexAttribPointer(m_vPosition, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, INDICE_TO_PTR(offsetof(QuantizedVertex, position)));
+	glEnableVertexAttribArray(m_vPosition);
+	glVertexAttribPointer(m_vNormal, 2, GL_BYTE, GL_FALSE, stride, INDICE_TO_PTR(offsetof(QuantizedVertex, normal)));
+	glEnableVertexAttribArray(m_vNormal);
+	glVertexAttribPointer(m_vUV, 2, GL_HALF_FLOAT, GL_FALSE, stride, INDICE_TO_PTR(offsetof(QuantizedVertex, uv)));
+	glEnableVertexAttribArray(m_vUV);
+
+	mesh.depthVertexArray = m_resources.createVertexArray(label.c_str());
+	glBindVertexArray(mesh.depthVertexArray.get());
+	glVertexAttribPointer(m_vDepthPosition, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, INDICE_TO_PTR(offsetof(QuantizedVertex, position)));
+	glEnableVertexAttribArray(m_vDepthPosition);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_meshes.push_back(std::move(mesh));
+	return index;
+}
+
+//les textures de la scne sont toutes cres avant la premire image : elles sont ranges ensemble au beginFrame() suivant
+int GLBackend::createTexture(const uint8_t* pixels, int width, int height)
+{
+	NewTexture texture;
+	texture.pixels.assign(pixels, pixels + 4 * (size_t)width * height);
+	texture.width = width;
+	texture.height = height;
+	m_newTextures.push_back(std::move(texture));
+	return (int)(m_texturePlacements.size() + m_newTextures.size()) - 1;
+}
+
+void GLBackend::uploadTextures()
+{
+	std::vector<TextureImage> images(m_newTextures.size());
+	for (size_t i = 0; i < m_newTextures.size(); i++)
+	{
+		images[i].pixels = &m_newTextures[i].pixels[0];
+		images[i].width = m_newTextures[i].width;
+		images[i].height = m_newTextures[i].height;
+	}
+	GLint maxSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+
+	std::vector<TexturePage> pages;
+	std::vector<TexturePlacement> placements;
+	int firstPage = m_residency.getPageCount();
+	if (!packTextures(images, TEXTURE_PAGES - firstPage, maxSize, pages, placements)) {
+		ERROR("The textures do not fit in the %d texture pages, the figures are drawn without them\n", TEXTURE_PAGES);
+	}
+	for (size_t p = 0; p < pages.size(); p++)
+	{
+		const TexturePage& page = pages[p];
+		std::string label = "texture page " + std::to_string(firstPage + p);
+		//seuls les petits niveaux sont chargs ici, les autres arrivent quand une figure les demande.
+		//Une page manquante garde sa place pour que les indices des suivantes ne changent pas.
+		int index = m_residency.addPage(page, label.c_str());
+		if (m_residency.getTexture(index) == 0) {
+			ERROR("The texture page %d does not fit in the memory budget\n", index);
+		}
+	}
+	for (size_t i = 0; i < placements.size(); i++)
+	{
+		if (placements[i].page >= 0)
+		{
+			placements[i].page += firstPage;
+			if (m_residency.getTexture(placements[i].page) == 0) {
+				placements[i].page = -1;
+			}
+		}
+		m_texturePlacements.push_back(placements[i]);
+	}
+	m_newTextures.clear();
+}
+
+//le panorama est converti une fois pour toutes, la carte graphique n'chantillonne ensuite que la cube map
+int GLBackend::createSkybox(const uint8_t* pixels, int width, int height)
+{
+	CubeMap cubeMap;
+	equirectangularToCubeMap(pixels, width, height, SKYBOX_FACE_SIZE, cubeMap);
+	const void* faces[6];
+	for (int i = 0; i < 6; i++) {
+		faces[i] = &cubeMap.faces[i][0];
+	}
+	std::string label = "skybox " + std::to_string(m_skyboxes.size());
+	GpuTexture texture = m_resources.createTextureCube(cubeMap.size, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, faces, label.c_str());
+	if (!texture.isValid()) {
+		return -1;
+	}
+
+	glBindTexture(GL_TEXTURE_CUBE_MAP, texture.get());
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+	m_skyboxes.push_back(std::move(texture));
+	return (int)m_skyboxes.size() - 1;
+}
+
+void GLBackend::beginFrame()
+{
+	if (!m_newTextures.empty()) {
+		uploadTextures();
+	}
+	beginScene();
+	m_stream.beginFrame();
+	m_pending.clear();
+	m_casters.clear();
+	m_shadowLight = false;
+	m_shadows.beginStaticCasters();
+}
+
+void GLBackend::drawSkybox(int skybox, const glm::mat4& viewProjection)
+{
+	m_skybox = skybox;
+	m_skyInverse = glm::inverse(viewProjection);
+}
+
+//les particules sont copies dans l'anneau ds l'appel, le draw call est fait dans presentFrame() aprs les figures
+void GLBackend::drawParticles(const ParticleBatch& batch)
+{
+	if (batch.count <= 0) {
+		return;
+	}
+	PendingParticles pending = { 0, 0, batch.count, batch.size, batch.viewProjection };
+	float* vertices = (float*)m_stream.allocate(4 * sizeof(float) * batch.count, 16, pending.offset);
+	uint32_t* colors = (uint32_t*)m_stream.allocate(sizeof(uint32_t) * batch.count, 4, pending.colorOffset);
+	if (vertices == NULL || colors == NULL) {
+		return; //anneau plein, il sera agrandi  l'image suivante
+	}
+	interleaveParticles(batch, vertices);
+	memcpy(colors, batch.colors, sizeof(uint32_t) * batch.count);
+	m_pendingParticles.push_back(pending);
+}
+
+//draw crit les paramtres de la figure directement dans le buffer mapp, sans appel  OpenGL
+void GLBackend::draw(int mesh, int texture, const glm::mat4& mvp, const Material& m, const Light& l)
+{
+	PendingDraw pending = { mesh, texture, 0, mvp, 0.f, m.getFeatures() };
+	TexturePlacement placement = { -1, 0, 1.f, 1.f, 0.f, 0.f };
+	if (texture >= 0 && texture < (int)m_texturePlacements.size()) {
+		placement = m_texturePlacements[texture];
+	}
+	if (placement.page < 0) {
+		pending.features &= ~MATERIAL_TEXTURED;
+	}
+	DrawBlock* block = (DrawBlock*)m_stream.allocate(sizeof(DrawBlock), m_uniformAlignment, pending.offset);
+	if (block == NULL) {
+		return; //anneau plein, il sera agrandi  l'image suivante
+	}
+	block->mvp = mvp;
+	block->modelView = mvp;
+	block->k = glm::vec4(m.ka, m.kd, m.ks, m.alpha);
+	block->color = glm::vec4(m.color, 0.f);
+	block->lightColor = glm::vec4(l.color, 0.f);
+	block->lightPosition = glm::vec4(l.position, 0.f);
+	block->cameraPosition = glm::vec4(0.f, 0.f, 0.f, 0.f);
+	block->textureRect = glm::vec4(placement.scaleU, placement.scaleV, placement.offsetU, placement.offsetV);
+	block->textureSlot = glm::vec4((float)placement.page, (float)placement.layer, 0.f, 0.f);
+	const Mesh& g = m_meshes[mesh];
+	block->boxMin = glm::vec4(g.boxMin, 0.f);
+	block->boxExtent = glm::vec4(g.boxMax - g.boxMin, 0.f);
+	block->shadow = m_shadowLight ? m_shadowReceiver * mvp : glm::mat4(0.f); //w nul : color.frag ne lit pas la carte
+	m_pending.push_back(pending);
+}
+
+bool GLBackend::setShadowLight(const glm::vec3& position, const glm::vec3& target, const glm::mat4& viewProjection)
+{
+	m_shadows.setLight(position, target);
+	//le repre de chaque figure est retrouv  partir de sa mvp : une inversion par image, pas une par figure
+	m_shadowReceiver = m_shadows.getViewProjection() * glm::inverse(viewProjection);
+	m_shadowLight = true;
+	return true;
+}
+
+void GLBackend::drawShadowCaster(int mesh, const glm::mat4& model, bool isStatic)
+{
+	if (!m_shadowLight) {
+		return;
+	}
+	if (isStatic) {
+		m_shadows.addStaticCaster(mesh, model);
+	}
+	PendingCaster caster = { mesh, 0, isStatic };
+	DrawBlock* block = (DrawBlock*)m_stream.allocate(sizeof(DrawBlock), m_uniformAlignment, caster.offset);
+	if (block == NULL)
+	{
+		if (isStatic) {
+			m_shadows.invalidateStatic();
+		}
+		return;
+	}
+	const Mesh& g = m_meshes[mesh];
+	block->mvp = m_shadows.getViewProjection() * model;
+	block->boxMin = glm::vec4(g.boxMin, 0.f);
+	block->boxExtent = glm::vec4(g.boxMax - g.boxMin, 0.f);
+	m_casters.push_back(caster);
+}
+
+void GLBackend::endFrame()
+{
+	m_stream.flush();
+	renderShadows();
+	prepareDraws();
+
+	//les niveaux arrivs avant les draw calls servent ds cette image.
+	//Toutes les pages pour toute l'image, la page de chaque figure est choisie dans color.frag.
+	m_residency.update();
+	for (int p = 0; p < m_residency.getPageCount(); p++)
+	{
+		glActiveTexture(GL_TEXTURE0 + (GLenum)p);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_residency.getTexture(p));
+	}
+	glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_shadows.getTexture());
+	GLuint currentProgram = 0;
+	for (size_t i = 0; i < m_order.size(); i++)
+	{
+		const PendingDraw& pending = m_pending[m_order[i]];
+		const Mesh& g = m_meshes[pending.mesh];
+
+		//l'ordre de la plus proche  la plus lointaine est gard, le programme ne change que si la variante change
+		GLuint program = m_variants.get(pending.features);
+		if (program == 0) {
+			continue;
+		}
+		if (program != currentProgram)
+		{
+			glUseProgram(program);
+			currentProgram = program;
+			if (!m_pageSamplers[pending.features])
+			{
+				GLint units[TEXTURE_PAGES];
+				for (int p = 0; p < TEXTURE_PAGES; p++) {
+					units[p] = p;
+				}
+				glUniform1iv(glGetUniformLocation(program, "uTextures"), TEXTURE_PAGES, units);
+				glUniform1i(glGetUniformLocation(program, "uShadowMap"), SHADOW_MAP_UNIT);
+				m_pageSamplers[pending.features] = true;
+			}
+		}
+
+		glBindBufferRange(GL_UNIFORM_BUFFER, 0, m_stream.getBuffer(), pending.offset, sizeof(DrawBlock));
+		glBindVertexArray(g.vertexArray.get());
+		glDrawArraysInstanced(GL_TRIANGLES, 0, g.nbVertices, m_nbEyes);
+	}
+	glBindVertexArray(0);
+	for (int p = 0; p < m_residency.getPageCount(); p++)
+	{
+		glActiveTexture(GL_TEXTURE0 + (GLenum)p);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+	glActiveTexture(GL_TEXTURE0 + SHADOW_MAP_UNIT);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glDepthFunc(GL_LESS);
+
+	presentFrame();
+}
+
+//vue unique depuis la lumire, avec le shader de la pr-passe de profondeur
+void GLBackend::renderShadows()
+{
+	if (!m_shadowLight) {
+		return;
+	}
+	glUseProgram(m_depthProgram.get());
+	glBindBufferRange(GL_UNIFORM_BUFFER, 1, m_stereoBuffer.get(), 0, sizeof(StereoBlock));
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(SHADOW_OFFSET_FACTOR, SHADOW_OFFSET_UNITS);
+
+	if (m_shadows.beginStatic())
+	{
+		drawCasters(true);
+		m_shadows.endStatic();
+	}
+	m_shadows.beginDynamic();
+	int nbDynamic = drawCasters(false);
+	m_shadows.endDynamic(nbDynamic);
+
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindBufferRange(GL_UNIFORM_BUFFER, 1, m_stereoBuffer.get(), m_nbEyes == 2 ? m_stereoOffset : 0, sizeof(StereoBlock));
+	glBindVertexArray(0);
+}
+
+int GLBackend::drawCasters(bool isStatic)
+{
+	int count = 0;
+	for (size_t i = 0; i < m_casters.size(); i++)
+	{
+		const PendingCaster& caster = m_casters[i];
+		if (caster.isStatic != isStatic) {
+			continue;
+		}
+		const Mesh& g = m_meshes[caster.mesh];
+		glBindBufferRange(GL_UNIFORM_BUFFER, 0, m_stream.getBuffer(), caster.offset, sizeof(DrawBlock));
+		glBindVertexArray(g.depthVertexArray.get());
+		glDrawArrays(GL_TRIANGLES, 0, g.nbVertices);
+		count++;
+	}
+	return count;
+}
+
+void GLBackend::prepareDraws()
+{
+	m_order.clear();
+	m_occluders.clear();
+	if (!m_occlusionCulling)
+	{
+		for (int i = 0; i < (int)m_pending.size(); i++)
+		{
+			const PendingDraw& pending = m_pending[i];
+			const Mesh& g = m_meshes[pending.mesh];
+			ScreenBox box;
+			requestTextureLevel(pending, projectDraw(g.boxMin, g.boxMax, pending.mvp, box) ? &box : NULL);
+			m_order.push_back(i);
+		}
+		return;
+	}
+
+	//la pyramide vient de la dernire profondeur des occultants dj relue
+	m_culler.update();
+	int culled = 0;
+	for (int i = 0; i < (int)m_pending.size(); i++)
+	{
+		PendingDraw& pending = m_pending[i];
+		const Mesh& g = m_meshes[pending.mesh];
+		ScreenBox box;
+		if (!projectDraw(g.boxMin, g.boxMax, pending.mvp, box))
+		{
+			//la bote entoure la camra ou passe derrire elle : dessine en dernier, sans test
+			pending.depth = 1.f;
+			requestTextureLevel(pending, NULL);
+			m_order.push_back(i);
+			continue;
+		}
+		if (box.maxX < 0.f || box.minX > 1.f || box.maxY < 0.f || box.minY > 1.f || box.minDepth > 1.f || m_culler.isOccluded(box)) {
+			culled++;
+			continue;
+		}
+		pending.depth = box.minDepth;
+		requestTextureLevel(pending, &box);
+		m_order.push_back(i);
+
+		float area = (std::min(box.maxX, 1.f) - std::max(box.minX, 0.f)) * (std::min(box.maxY, 1.f) - std::max(box.minY, 0.f));
+		if (area >= HIZ_OCCLUDER_AREA) {
+			m_occluders.push_back(i);
+		}
+	}
+	m_culler.count((int)m_pending.size(), culled);
+
+	//de la plus proche  la plus lointaine : le test de profondeur rejette les pixels cachs avant color.frag
+	std::sort(m_order.begin(), m_order.end(), [this](int a, int b) { return m_pending[a].depth < m_pending[b].depth; });
+	std::sort(m_occluders.begin(), m_occluders.end(), [this](int a, int b) { return m_pending[a].depth < m_pending[b].depth; });
+	if (m_occluders.empty()) {
+		return;
+	}
+
+	//pr-passe dans l'image, pour chaque oeil, puis dans la petite image qui donnera la pyramide des images suivantes,
+	//toujours vue par la camra centrale
+	glUseProgram(m_depthProgram.get());
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	drawOccluders(m_nbEyes);
+	glBindBufferRange(GL_UNIFORM_BUFFER, 1, m_stereoBuffer.get(), 0, sizeof(StereoBlock));
+	m_culler.beginOccluders();
+	drawOccluders(1);
+	m_culler.endOccluders();
+	glBindBufferRange(GL_UNIFORM_BUFFER, 1, m_stereoBuffer.get(), m_nbEyes == 2 ? m_stereoOffset : 0, sizeof(StereoBlock));
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glBindVertexArray(0);
+
+	//les occultants repassent avec exactement la mme profondeur (invariant gl_Position)
+	glDepthFunc(GL_LEQUAL);
+}
+
+//La pyramide est celle de la camra centrale : la bote est projete comme en vue unique, puis largie en x
+//du dcalage des yeux  sa profondeur, pour couvrir ce que voit chacun des deux yeux
+bool GLBackend::projectDraw(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::mat4& mvp, ScreenBox& box) const
+{
+	if (!OcclusionCuller::projectBox(boxMin, boxMax, mvp, box)) {
+		return false;
+	}
+	if (m_nbEyes == 1) {
+		return true;
+	}
+	//w est affine dans la bote : ses extrmes sont aux coins, pris axe par axe
+	float minW = mvp[3][3];
+	float maxW = mvp[3][3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float a = mvp[axis][3] * boxMin[axis];
+		float b = mvp[axis][3] * boxMax[axis];
+		minW += std::min(a, b);
+		maxW += std::max(a, b);
+	}
+	//projectBox a dj refus les botes qui passent derrire la camra : minW > 0
+	float inverseDepth = std::max(fabsf(1.f / minW - m_stereoViews.parallax.y), fabsf(1.f / maxW - m_stereoViews.parallax.y));
+	float shift = 0.5f * m_stereoViews.parallax.x * inverseDepth; //coordonnes normalises -> [0, 1]
+	box.minX -= shift;
+	box.maxX += shift;
+	return true;
+}
+
+void GLBackend::requestTextureLevel(const PendingDraw& pending, const ScreenBox* box)
+{
+	if (!(pending.features & MATERIAL_TEXTURED)) {
+		return;
+	}
+	const TexturePlacement& placement = m_texturePlacements[pending.texture];
+	if (box == NULL)
+	{
+		m_residency.request(placement.page, placement.scaleU, placement.scaleV, 1e30f, 1e30f);
+		return;
+	}
+	m_residency.request(placement.page, placement.scaleU, placement.scaleV, (box->maxX - box->minX) * m_renderWidth, (box->maxY - box->minY) * m_renderHeight);
+}
+
+void GLBackend::drawOccluders(GLsizei instances)
+{
+	for (size_t i = 0; i < m_occluders.size(); i++)
+	{
+		const PendingDraw& pending = m_pending[m_occluders[i]];
+		const Mesh& g = m_meshes[pending.mesh];
+		glBindBufferRange(GL_UNIFORM_BUFFER, 0, m_stream.getBuffer(), pending.offset, sizeof(DrawBlock));
+		glBindVertexArray(g.depthVertexArray.get());
+		glDrawArraysInstanced(GL_TRIANGLES, 0, g.nbVertices, instances);
+	}
+}
+
+void GLBackend::setRenderScale(float scale)
+{
+	m_nextRenderScale = std::min(1.f, std::max(0.1f, scale));
+}
+
+void GLBackend::beginScene()
+{
+	readTimers();
+	m_timing = m_timers[0].isValid() && m_timersIssued - m_timersRead < GPU_TIMER_QUERIES;
+	if (m_timing) {
+		glBeginQuery(GL_TIME_ELAPSED, m_timers[m_timersIssued % GPU_TIMER_QUERIES].get());
+	}
+
+	m_renderScale = m_nextRenderScale;
+	m_renderWidth = std::max(1, (int)(m_width * m_renderScale + 0.5f));
+	m_renderHeight = std::max(1, (int)(m_height * m_renderScale + 0.5f));
+	glBindFramebuffer(GL_FRAMEBUFFER, m_sceneFramebuffer.get());
+	glViewport(0, 0, m_renderWidth, m_renderHeight);
+
+	//les deux yeux se partagent la zone rendue, le plan de coupe empche les triangles d'un oeil de dborder chez l'autre
+	glBindBufferRange(GL_UNIFORM_BUFFER, 1, m_stereoBuffer.get(), m_nbEyes == 2 ? m_stereoOffset : 0, sizeof(StereoBlock));
+	if (m_nbEyes == 2) {
+		glEnable(GL_CLIP_DISTANCE0);
+	}
+
+	//Clear the screen : the depth buffer and the color buffer
+	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+}
+
+//les mesures arrivent dans l'ordre, on lit toutes celles qui sont prtes sans jamais attendre
+void GLBackend::readTimers()
+{
+	while (m_timersRead < m_timersIssued)
+	{
+		GLuint query = m_timers[m_timersRead % GPU_TIMER_QUERIES].get();
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			return;
+		}
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+		m_renderTime = nanoseconds / 1e6f;
+		m_timersRead++;
+	}
+}
+
+void GLBackend::upscaleScene()
+{
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CLIP_DISTANCE0); //upscale.vert n'crit pas gl_ClipDistance
+	if (m_bloomEnabled) {
+		m_bloom.apply(m_sceneColor.get(), m_renderWidth, m_renderHeight);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, m_width, m_height);
+
+	glUseProgram(m_upscaleProgram.get());
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_sceneColor.get());
+	glUniform1i(m_uScene, 0);
+	glUniform2f(m_uUVScale, m_renderWidth / (float)m_width, m_renderHeight / (float)m_height);
+	glUniform2f(m_uTexel, 1.f / m_width, 1.f / m_height);
+	glUniform1f(m_uSharpness, m_renderWidth < m_width ? UPSCALE_SHARPNESS : 0.f);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, m_bloomEnabled ? m_bloom.getTexture() : 0);
+	glUniform1i(m_uBloom, 1);
+	glm::vec2 bloomUVScale = m_bloom.getUVScale();
+	glm::vec2 bloomTexel = m_bloom.getTexel();
+	glUniform2f(m_uBloomUVScale, bloomUVScale.x, bloomUVScale.y);
+	glUniform2f(m_uBloomTexel, bloomTexel.x, bloomTexel.y);
+	glUniform1f(m_uBloomIntensity, m_bloomEnabled ? BLOOM_INTENSITY : 0.f);
+	glBindVertexArray(m_upscaleVertexArray.get());
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glEnable(GL_DEPTH_TEST);
+}
+
+void GLBackend::drawSky()
+{
+	if (m_skybox < 0) {
+		return;
+	}
+	glUseProgram(m_skyboxProgram.get());
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_skyboxes[m_skybox].get());
+	glUniform1i(m_uSkybox, 0);
+	glUniformMatrix4fv(m_uInverseViewProjection, 1, GL_FALSE, glm::value_ptr(m_skyInverse));
+	glDepthFunc(GL_EQUAL);
+	glDepthMask(GL_FALSE);
+	glBindVertexArray(m_upscaleVertexArray.get()); //vide lui aussi
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 3, m_nbEyes);
+	glBindVertexArray(0);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	m_skybox = -1;
+}
+
+void GLBackend::presentFrame()
+{
+	//le fond aprs les figures : ses pixels couverts sont rejets par le test de profondeur avant skybox.frag
+	drawSky();
+
+	//un draw call en points par metteur, sans crire dans le depth buffer pour que les particules ne se cachent pas entre elles
+	if (!m_pendingParticles.empty())
+	{
+		glUseProgram(m_particleProgram.get());
+		glBindVertexArray(m_particleVertexArray.get());
+		glBindBuffer(GL_ARRAY_BUFFER, m_stream.getBuffer());
+		glEnableVertexAttribArray(m_vParticle);
+		glEnableVertexAttribArray(m_vParticleColor);
+		glEnable(GL_PROGRAM_POINT_SIZE);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+		glDepthMask(GL_FALSE);
+		for (size_t i = 0; i < m_pendingParticles.size(); i++)
+		{
+			const PendingParticles& pending = m_pendingParticles[i];
+			glVertexAttribPointer(m_vParticle, 4, GL_FLOAT, GL_FALSE, 0, INDICE_TO_PTR(pending.offset));
+			glVertexAttribPointer(m_vParticleColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, INDICE_TO_PTR(pending.colorOffset));
+			glUniformMatrix4fv(m_uViewProjection, 1, GL_FALSE, glm::value_ptr(pending.viewProjection));
+			glUniform1f(m_uPointSize, pending.size * m_renderHeight / m_height); //taille donne pour la fentre
+			glDrawArraysInstanced(GL_POINTS, 0, pending.count, m_nbEyes);
+		}
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+		m_pendingParticles.clear();
+	}
+
+	upscaleScene();
+	if (m_timing)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_timersIssued++;
+	}
+
+	glUseProgram(0);
+	m_stream.endFrame();
+
+	if (m_capture != NULL) {
+		readBackFrame();
+	}
+
+	//Display on screen (swap the buffer on screen and the buffer you are drawing on)
+	if (m_pacer != NULL) {
+		m_pacer->waitForDeadline();
+	}
+	SDL_GL_SwapWindow(m_window);
+	if (m_pacer != NULL) {
+		m_pacer->framePresented();
+	}
+}
+
+void GLBackend::setCapture(FrameCapture* capture)
+{
+	//les images encore dans l'anneau sont transmises  l'ancienne capture
+	if (m_capture != NULL)
+	{
+		uint32_t first = m_captureIssued > CAPTURE_PBO_COUNT ? m_captureIssued - CAPTURE_PBO_COUNT : 0;
+		for (uint32_t frame = first; frame < m_captureIssued; frame++) {
+			mapCapturedFrame(frame);
+		}
+	}
+
+	m_capture = capture;
+	m_captureIssued = 0;
+	for (int i = 0; i < CAPTURE_PBO_COUNT; i++) {
+		m_pbos[i].reset();
+	}
+	if (capture == NULL) {
+		return;
+	}
+
+	for (int i = 0; i < CAPTURE_PBO_COUNT; i++)
+	{
+		m_pbos[i] = m_resources.createBuffer(GL_PIXEL_PACK_BUFFER, 4 * capture->getWidth() * capture->getHeight(), NULL, GL_STREAM_READ, "capture");
+		if (!m_pbos[i].isValid()) {
+			ERROR("Not enough GPU memory for the capture, it is disabled\n");
+			m_capture = NULL;
+			return;
+		}
+	}
+}
+
+//glReadPixels vers un PBO rend la main tout de suite : la copie se fait sur la carte graphique.
+//On ne lit le PBO que CAPTURE_PBO_COUNT images plus tard, quand il est prt, juste avant de le rutiliser.
+void GLBackend::readBackFrame()
+{
+	if (m_captureIssued >= CAPTURE_PBO_COUNT) {
+		mapCapturedFrame(m_captureIssued - CAPTURE_PBO_COUNT);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[m_captureIssued % CAPTURE_PBO_COUNT].get());
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_capture->getWidth(), m_capture->getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_captureIssued++;
+}
+
+void GLBackend::mapCapturedFrame(uint32_t frame)
+{
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[frame % CAPTURE_PBO_COUNT].get());
+	const uint8_t* mapped = (const uint8_t*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	if (mapped != NULL)
+	{
+		uint8_t* pixels = m_capture->acquireFrame();
+		memcpy(pixels, mapped, 4 * m_capture->getWidth() * m_capture->getHeight());
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		m_capture->submitFrame(pixels, true);
+	}
+	else {
+		ERROR("Could not map the capture buffer\n");
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
@@ -0,0 +1,275 @@
+#ifndef GLBACKEND_H
+#define GLBACKEND_H
+
+//SDL Libraries
+#include <SDL2/SDL.h>
+
+//OpenGL Libraries
+#include <GL/glew.h>
+
+#include "Shader.h"
+#include "RenderBackend.h"
+#include "GpuResources.h"
+#include "StreamBuffer.h"
+#include "OcclusionCuller.h"
+#include "Bloom.h"
+#include "ShadowMaps.h"
+#include "ShaderVariants.h"
+#include "StereoCamera.h"
+#include "TexturePacker.h"
+#include "TextureResidency.h"
+#include "VertexQuantization.h"
+
+#include "vector"
+
+#define GPU_TIMER_QUERIES 4 //mesures de dure en vol, lues sans attendre quand elles sont prtes
+#define SHADOW_MAP_UNIT TEXTURE_PAGES //unit de texture de la carte d'ombre, aprs les pages
+#define CAPTURE_PBO_COUNT 3 //une image capture est relue CAPTURE_PBO_COUNT images plus tard, quand la copie par la carte graphique est finie
+
+//Rendu OpenGL : un VBO de sommets quantifis par figure (QuantizedVertex, dcods par color.vert), dans un VAO dessin avec la variante
+//du shader color qui correspond aux termes d'clairage du matriau.
+//Les textures sont ranges dans quelques pages (tableaux de textures et atlas), toutes lies une fois par image : chaque figure
+//ne donne que sa page, sa couche et son rectangle, sans changer de texture entre deux draw calls. Les mipmaps des pages sont
+//chargs et librs par TextureResidency selon la taille  l'cran des figures qui les utilisent.
+//Tous les objets OpenGL passent par le gestionnaire de ressources, qui compte la mmoire utilise.
+//draw() crit les paramtres de la figure dans l'anneau de donnes par image, les draw calls sont faits dans endFrame() :
+//les figures caches d'aprs la pyramide de profondeur sont cartes, les grands occultants sont dessins en profondeur seule,
+//puis les autres figures sont dessines de la plus proche  la plus lointaine pour que color.frag ne tourne que sur les pixels visibles.
+//En stro, chaque draw call est instanci une fois par oeil : les vertex shaders lisent la matrice de l'oeil dans le bloc StereoBlock.
+//Les ombres de la lumire de setShadowLight() viennent de ShadowMaps : les figures fixes y sont gardes, seules les mobiles sont redessines.
+//La scne est rendue en HDR : le halo des pixels plus brillants que BLOOM_THRESHOLD et le tonemapping sont appliqus  l'agrandissement.
+class GLBackend : public RenderBackend
+{
+public:
+	//vramBudget en octets, 0 = illimit
+	GLBackend(SDL_Window* window, size_t vramBudget = 0);
+	~GLBackend();
+
+	//charge les shaders, renvoie false en cas d'chec
+	virtual bool init();
+
+	int createMesh(const float* positions, const float* normals, const float* uvs, int nbVertices);
+	int createTexture(const uint8_t* pixels, int width, int height);
+	int createSkybox(const uint8_t* pixels, int width, int height);
+
+	void beginFrame();
+	void draw(int mesh, int texture, const glm::mat4& mvp, const Material& material, const Light& light);
+	void drawParticles(const ParticleBatch& batch);
+	void drawSkybox(int skybox, const glm::mat4& viewProjection);
+	bool setShadowLight(const glm::vec3& position, const glm::vec3& target, const glm::mat4& viewProjection);
+	void drawShadowCaster(int mesh, const glm::mat4& model, bool isStatic);
+	void endFrame();
+
+	void setCapture(FrameCapture* capture);
+	void setFramePacer(FramePacer* pacer) { m_pacer = pacer; }
+
+	void setRenderScale(float scale);
+	float getRenderScale() const { return m_renderScale; }
+	//dure mesure sur la carte graphique (GL_TIME_ELAPSED), -1 sans ARB_timer_query
+	float getRenderTime() const { return m_renderTime; }
+
+	bool setStereo(const StereoViews* views);
+
+	void printMemoryReport(const char* title) const
+	{
+		m_resources.printReport(title);
+		m_residency.printReport();
+	}
+
+	//octets de mipmaps des pages de textures gards sur la carte graphique, 0 = illimit
+	void setTextureBudget(size_t bytes) { m_residency.setBudget(bytes); }
+
+	//sans occlusion culling, les figures sont dessines dans l'ordre des draw(), sans pr-passe de profondeur
+	void setOcclusionCulling(bool enabled) { m_occlusionCulling = enabled; }
+	//sans bloom, l'image HDR est seulement tonemappe
+	void setBloom(bool enabled) { m_bloomEnabled = enabled; }
+
+protected:
+	//charge le shader particle, renvoie false en cas d'chec
+	bool initParticles();
+	//charge le shader skybox, renvoie false en cas d'chec
+	bool initSkybox();
+	//cre la cible de rendu de la scne, la chane de bloom et charge le shader upscale
+	bool initSceneTarget();
+	//cre le buffer du bloc StereoBlock, avec les valeurs de la vue unique
+	bool initStereo();
+	//mesure de dure, puis cible de rendu de la scne  la rsolution de l'image, efface
+	void beginScene();
+	//fond et particules de l'image, agrandissement  la taille de la fentre, capture puis affichage
+	void presentFrame();
+
+	SDL_Window* m_window;
+	GpuResourceManager m_resources; //dclar en premier pour tre dtruit aprs tous les handles
+	StreamBuffer m_stream;
+	int m_width; //taille de la fentre
+	int m_height;
+	int m_nbEyes; //instances de chaque draw call : 1, ou 2 en stro
+
+private:
+	//tri, occlusion culling et pr-passe de profondeur. m_order reoit les draws  colorer, dans l'ordre.
+	void prepareDraws();
+	//range les textures cres depuis la dernire image dans de nouvelles pages
+	void uploadTextures();
+	//bote de la figure  l'cran, runion de celles des deux yeux en stro. false si elle traverse le plan near.
+	bool projectDraw(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::mat4& mvp, ScreenBox& box) const;
+	//profondeur seule des draws de m_occluders, instances draw calls pour chacun
+	void drawOccluders(GLsizei instances);
+	//triangle plein cran sur le plan far, aprs les figures
+	void drawSky();
+	//carte fixe si elle a chang, puis figures mobiles dans la carte d'ombre de l'image
+	void renderShadows();
+	//renvoie le nombre de figures dessines
+	int drawCasters(bool isStatic);
+
+	//halo, puis dessine la scne rduite sur toute la fentre
+	void upscaleScene();
+	void readTimers();
+
+	void readBackFrame();
+	//transmet  la capture l'image lue dans le PBO de rang frame
+	void mapCapturedFrame(uint32_t frame);
+
+	struct Mesh {
+		GpuBuffer vertices; //QuantizedVertex entrelacs
+		GpuVertexArray vertexArray;
+		GpuVertexArray depthVertexArray; //positions seules, pour le shader depth
+		int nbVertices;
+		glm::vec3 boxMin; //bote englobante dans le repre de la figure
+		glm::vec3 boxMax;
+	};
+
+	//mme disposition que le bloc DrawBlock (std140) de color.vert et color.frag, les vec3 y occupent 16 octets
+	struct DrawBlock {
+		glm::mat4 mvp;
+		glm::mat4 modelView;
+		glm::vec4 k;
+		glm::vec4 color;
+		glm::vec4 lightColor;
+		glm::vec4 lightPosition;
+		glm::vec4 cameraPosition;
+		glm::vec4 textureRect; //xy : chelle des uv, zw : dcalage dans la page
+		glm::vec4 textureSlot; //x : page, y : couche
+		glm::vec4 boxMin; //dcodage des positions quantifies de la figure
+		glm::vec4 boxExtent;
+		glm::mat4 shadow; //position dans la carte d'ombre, nulle sans ombre
+	};
+
+	struct PendingDraw {
+		int mesh;
+		int texture; //pour la demande de niveau de mipmaps, -1 sans texture
+		GLintptr offset; //position du DrawBlock dans l'anneau
+		glm::mat4 mvp; //copie pour le culling, l'anneau n'est fait que pour l'criture
+		float depth; //profondeur la plus proche de la bote, cl du tri
+		int features; //variante de color, voir MaterialFeature
+	};
+
+	struct PendingCaster {
+		int mesh;
+		GLintptr offset; //DrawBlock dont seules mvp et la bote servent
+		bool isStatic;
+	};
+
+	//demande le niveau de mipmaps qui suffit  la figure, box NULL si sa taille  l'cran n'est pas connue
+	void requestTextureLevel(const PendingDraw& pending, const ScreenBox* box);
+
+	//mme disposition que le bloc StereoBlock (std140) des vertex shaders
+	struct StereoBlock {
+		glm::mat4 eyes[2];
+		glm::vec4 planes[2];
+		glm::vec4 layouts[2];
+	};
+
+	//particules d'un metteur, copies dans l'anneau : (x, y, z, vie) puis couleurs RGBA8
+	struct PendingParticles {
+		GLintptr offset;
+		GLintptr colorOffset;
+		int count;
+		float size;
+		glm::mat4 viewProjection;
+	};
+
+	ShaderVariants m_variants; //color.vert et color.frag, compils une fois par combinaison de MaterialFeature utilise
+	std::vector<Mesh> m_meshes;
+	//pixels copis par createTexture() jusqu' leur rangement dans les pages
+	struct NewTexture {
+		std::vector<uint8_t> pixels;
+		int width;
+		int height;
+	};
+	std::vector<NewTexture> m_newTextures;
+	TextureResidency m_residency; //pages GL_TEXTURE_2D_ARRAY, la page i sur l'unit de texture i
+	std::vector<TexturePlacement> m_texturePlacements; //une par texture cre, page -1 si elle n'a pas pu tre range
+	bool m_pageSamplers[NB_MATERIAL_VARIANTS]; //uTextures[i] = i et uShadowMap ont t donns au programme de la variante
+	std::vector<PendingDraw> m_pending;
+	GLint m_vPosition;
+	GLint m_vNormal;
+	GLint m_vUV;
+	GLint m_uniformAlignment;
+
+	GpuProgram m_depthProgram;
+	GLint m_vDepthPosition;
+	OcclusionCuller m_culler;
+	bool m_occlusionCulling;
+	std::vector<int> m_order;
+	std::vector<int> m_occluders;
+
+	ShadowMaps m_shadows;
+	bool m_shadowLight; //setShadowLight() a t appel pour cette image
+	glm::mat4 m_shadowReceiver; //mvp de la camra -> carte d'ombre
+	std::vector<PendingCaster> m_casters;
+
+	GpuProgram m_particleProgram;
+	GpuVertexArray m_particleVertexArray;
+	std::vector<PendingParticles> m_pendingParticles;
+	GLint m_vParticle;
+	GLint m_vParticleColor;
+	GLint m_uViewProjection;
+	GLint m_uPointSize;
+
+	//bloc de la vue unique au dbut du buffer, bloc stro  m_stereoOffset : setStereo() ne fait que choisir lequel est li
+	GpuBuffer m_stereoBuffer;
+	GLintptr m_stereoOffset;
+	StereoViews m_stereoViews; //dernires vues envoyes, le buffer n'est rcrit que si elles changent
+	bool m_stereoUploaded;
+
+	GpuProgram m_skyboxProgram;
+	std::vector<GpuTexture> m_skyboxes; //cube maps
+	int m_skybox; //fond de l'image en cours, -1 sans fond
+	glm::mat4 m_skyInverse;
+	GLint m_uSkybox;
+	GLint m_uInverseViewProjection;
+
+	//la scne est rendue dans le coin en bas  gauche d'une cible HDR de la taille de la fentre, rien n'est recr quand l'chelle change
+	GpuTexture m_sceneColor;
+	GpuTexture m_sceneDepth;
+	GpuFramebuffer m_sceneFramebuffer;
+	GpuProgram m_upscaleProgram;
+	GpuVertexArray m_upscaleVertexArray; //vide, le triangle plein cran vient de gl_VertexID
+	GLint m_uScene;
+	GLint m_uUVScale;
+	GLint m_uTexel;
+	GLint m_uSharpness;
+	BloomChain m_bloom;
+	bool m_bloomEnabled;
+	GLint m_uBloom;
+	GLint m_uBloomUVScale;
+	GLint m_uBloomTexel;
+	GLint m_uBloomIntensity;
+	float m_renderScale;
+	float m_nextRenderScale;
+	int m_renderWidth;
+	int m_renderHeight;
+
+	GpuQuery m_timers[GPU_TIMER_QUERIES];
+	uint32_t m_timersIssued;
+	uint32_t m_timersRead;
+	bool m_timing; //une mesure est en cours pour cette image
+	float m_renderTime;
+
+	FrameCapture* m_capture;
+	GpuBuffer m_pbos[CAPTURE_PBO_COUNT]; //anneau de pixel buffer objects pour la lecture asynchrone des images
+	uint32_t m_captureIssued; //nombre de glReadPixels lancs depuis setCapture()
+	FramePacer* m_pacer;
+};
+
+#endif
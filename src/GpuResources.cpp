@@ -0,0 +1,247 @@
+#include "GpuResources.h"
+
+#include "logger.h"
+
+static const char* const typeNames[NB_GPU_RESOURCE_TYPES] = { "buffers", "textures", "vertex arrays", "programs", "framebuffers", "queries" };
+
+GpuResourceManager::GpuResourceManager(size_t budget) : m_peakBytes(0), m_budget(budget)
+{
+	for (int i = 0; i < NB_GPU_RESOURCE_TYPES; i++) {
+		m_bytes[i] = 0;
+	}
+}
+
+GpuResourceManager::~GpuResourceManager()
+{
+	int leaks = 0;
+	for (int type = 0; type < NB_GPU_RESOURCE_TYPES; type++)
+	{
+		for (std::map<GLuint, Record>::const_iterator it = m_records[type].begin(); it != m_records[type].end(); ++it)
+		{
+			ERROR("GPU leak : %s %u (%s, %u bytes) is still alive at shutdown\n", typeNames[type], it->first, it->second.label.c_str(), (unsigned)it->second.bytes);
+			destroy((GpuResourceType)type, it->first, it->second);
+			leaks++;
+		}
+		m_records[type].clear();
+	}
+	if (leaks == 0) {
+		printf("GPU resources : no leak, peak %.2f MB\n", m_peakBytes / (1024.0 * 1024.0));
+	}
+}
+
+size_t GpuResourceManager::getTotalBytes() const
+{
+	size_t total = 0;
+	for (int i = 0; i < NB_GPU_RESOURCE_TYPES; i++) {
+		total += m_bytes[i];
+	}
+	return total;
+}
+
+bool GpuResourceManager::reserve(size_t bytes, const char* label)
+{
+	if (m_budget != 0 && getTotalBytes() + bytes > m_budget)
+	{
+		ERROR("GPU budget exceeded : %s needs %u bytes, %u of %u already used\n", label, (unsigned)bytes, (unsigned)getTotalBytes(), (unsigned)m_budget);
+		return false;
+	}
+	return true;
+}
+
+void GpuResourceManager::track(GpuResourceType type, GLuint id, size_t bytes, const char* label, Shader* shader)
+{
+	Record record = { bytes, label, shader };
+	m_records[type][id] = record;
+	m_bytes[type] += bytes;
+	if (getTotalBytes() > m_peakBytes) {
+		m_peakBytes = getTotalBytes();
+	}
+}
+
+GpuBuffer GpuResourceManager::createBuffer(GLenum target, size_t size, const void* data, GLenum usage, const char* label)
+{
+	if (!reserve(size, label)) {
+		return GpuBuffer();
+	}
+	GLuint id;
+	glGenBuffers(1, &id);
+	glBindBuffer(target, id);
+	glBufferData(target, size, data, usage);
+	glBindBuffer(target, 0);
+	track(GPU_BUFFER, id, size, label);
+	return GpuBuffer(this, id);
+}
+
+GpuBuffer GpuResourceManager::createStorageBuffer(GLenum target, size_t size, GLbitfield flags, const char* label)
+{
+	if (!reserve(size, label)) {
+		return GpuBuffer();
+	}
+	GLuint id;
+	glGenBuffers(1, &id);
+	glBindBuffer(target, id);
+	glBufferStorage(target, size, NULL, flags);
+	glBindBuffer(target, 0);
+	track(GPU_BUFFER, id, size, label);
+	return GpuBuffer(this, id);
+}
+
+GpuTexture GpuResourceManager::createTexture2D(int width, int height, GLenum internalFormat, GLenum format, GLenum type, const void* pixels, const char* label)
+{
+	size_t bytes = 4 * (size_t)width * height;
+	if (!reserve(bytes, label)) {
+		return GpuTexture();
+	}
+	GLuint id;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D, id);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, pixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	track(GPU_TEXTURE, id, bytes, label);
+	return GpuTexture(this, id);
+}
+
+GpuTexture GpuResourceManager::createTexture2DArray(int width, int height, int layers, GLenum internalFormat, GLenum format, GLenum type, const void* pixels, const char* label)
+{
+	size_t bytes = 4 * (size_t)width * height * layers;
+	if (!reserve(bytes, label)) {
+		return GpuTexture();
+	}
+	GLuint id;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat, width, height, layers, 0, format, type, pixels);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	track(GPU_TEXTURE, id, bytes, label);
+	return GpuTexture(this, id);
+}
+
+GpuTexture GpuResourceManager::createTextureCube(int size, GLenum internalFormat, GLenum format, GLenum type, const void* const faces[6], const char* label)
+{
+	size_t bytes = 4 * (size_t)size * size * 6;
+	if (!reserve(bytes, label)) {
+		return GpuTexture();
+	}
+	GLuint id;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, id);
+	for (int i = 0; i < 6; i++) {
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, size, size, 0, format, type, faces[i]);
+	}
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	track(GPU_TEXTURE, id, bytes, label);
+	return GpuTexture(this, id);
+}
+
+GpuTexture GpuResourceManager::createEmptyTexture(const char* label)
+{
+	GLuint id;
+	glGenTextures(1, &id);
+	track(GPU_TEXTURE, id, 0, label);
+	return GpuTexture(this, id);
+}
+
+bool GpuResourceManager::resizeTexture(const GpuTexture& texture, size_t bytes)
+{
+	std::map<GLuint, Record>::iterator it = m_records[GPU_TEXTURE].find(texture.get());
+	if (it == m_records[GPU_TEXTURE].end()) {
+		return false;
+	}
+	Record& record = it->second;
+	if (bytes > record.bytes && !reserve(bytes - record.bytes, record.label.c_str())) {
+		return false;
+	}
+	m_bytes[GPU_TEXTURE] = m_bytes[GPU_TEXTURE] - record.bytes + bytes;
+	record.bytes = bytes;
+	if (getTotalBytes() > m_peakBytes) {
+		m_peakBytes = getTotalBytes();
+	}
+	return true;
+}
+
+GpuVertexArray GpuResourceManager::createVertexArray(const char* label)
+{
+	GLuint id;
+	glGenVertexArrays(1, &id);
+	track(GPU_VERTEX_ARRAY, id, 0, label);
+	return GpuVertexArray(this, id);
+}
+
+GpuFramebuffer GpuResourceManager::createFramebuffer(const char* label)
+{
+	GLuint id;
+	glGenFramebuffers(1, &id);
+	track(GPU_FRAMEBUFFER, id, 0, label);
+	return GpuFramebuffer(this, id);
+}
+
+GpuQuery GpuResourceManager::createQuery(const char* label)
+{
+	GLuint id;
+	glGenQueries(1, &id);
+	track(GPU_QUERY, id, 0, label);
+	return GpuQuery(this, id);
+}
+
+GpuProgram GpuResourceManager::adoptProgram(Shader* shader, const char* label)
+{
+	if (shader == NULL) {
+		return GpuProgram();
+	}
+	GLuint id = shader->getProgramID();
+	track(GPU_PROGRAM, id, 0, label, shader);
+	return GpuProgram(this, id);
+}
+
+void GpuResourceManager::release(GpuResourceType type, GLuint id)
+{
+	std::map<GLuint, Record>::iterator it = m_records[type].find(id);
+	if (it == m_records[type].end())
+	{
+		ERROR("GPU %s %u released twice or not created by the manager\n", typeNames[type], id);
+		return;
+	}
+	destroy(type, id, it->second);
+	m_bytes[type] -= it->second.bytes;
+	m_records[type].erase(it);
+}
+
+void GpuResourceManager::destroy(GpuResourceType type, GLuint id, const Record& record)
+{
+	switch (type)
+	{
+	case GPU_BUFFER:
+		glDeleteBuffers(1, &id);
+		break;
+	case GPU_TEXTURE:
+		glDeleteTextures(1, &id);
+		break;
+	case GPU_VERTEX_ARRAY:
+		glDeleteVertexArrays(1, &id);
+		break;
+	case GPU_PROGRAM:
+		delete(record.shader);
+		break;
+	case GPU_FRAMEBUFFER:
+		glDeleteFramebuffers(1, &id);
+		break;
+	case GPU_QUERY:
+		glDeleteQueries(1, &id);
+		break;
+	default:
+		break;
+	}
+}
+
+void GpuResourceManager::printReport(const char* title) const
+{
+	printf("GPU memory (%s) :\n", title);
+	for (int type = 0; type < NB_GPU_RESOURCE_TYPES; type++) {
+		printf("  %-14s %5d objects %10.2f MB\n", typeNames[type], getCount((GpuResourceType)type), m_bytes[type] / (1024.0 * 1024.0));
+	}
+	printf("  total %.2f MB, peak %.2f MB", getTotalBytes() / (1024.0 * 1024.0), m_peakBytes / (1024.0 * 1024.0));
+	if (m_budget != 0) {
+		printf(", budget %.2f MB", m_budget / (1024.0 * 1024.0));
+	}
+	printf("\n");
+}
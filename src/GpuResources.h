@@ -0,0 +1,128 @@
+#ifndef GPURESOURCES_H
+#define GPURESOURCES_H
+
+//OpenGL Libraries
+#include <GL/glew.h>
+
+#include "Shader.h"
+
+#include "stddef.h"
+#include "string"
+#include "map"
+
+enum GpuResourceType { GPU_BUFFER, GPU_TEXTURE, GPU_VERTEX_ARRAY, GPU_PROGRAM, GPU_FRAMEBUFFER, GPU_QUERY, NB_GPU_RESOURCE_TYPES };
+
+class GpuResourceManager;
+
+//Possde un objet OpenGL et le rend au gestionnaire  sa destruction. Il se dplace mais ne se copie pas.
+template<GpuResourceType TYPE>
+class GpuHandle
+{
+public:
+	GpuHandle() : m_manager(NULL), m_id(0) {}
+	GpuHandle(GpuResourceManager* manager, GLuint id) : m_manager(manager), m_id(id) {}
+	GpuHandle(GpuHandle&& other) : m_manager(other.m_manager), m_id(other.m_id) { other.m_id = 0; }
+	GpuHandle& operator=(GpuHandle&& other);
+	GpuHandle(const GpuHandle&) = delete;
+	GpuHandle& operator=(const GpuHandle&) = delete;
+	~GpuHandle() { reset(); }
+
+	GLuint get() const { return m_id; }
+	bool isValid() const { return m_id != 0; }
+	void reset();
+
+private:
+	GpuResourceManager* m_manager;
+	GLuint m_id;
+};
+
+typedef GpuHandle<GPU_BUFFER> GpuBuffer;
+typedef GpuHandle<GPU_TEXTURE> GpuTexture;
+typedef GpuHandle<GPU_VERTEX_ARRAY> GpuVertexArray;
+typedef GpuHandle<GPU_PROGRAM> GpuProgram;
+typedef GpuHandle<GPU_FRAMEBUFFER> GpuFramebuffer;
+typedef GpuHandle<GPU_QUERY> GpuQuery;
+
+//Cre les objets OpenGL et compte la mmoire qu'ils occupent par catgorie.
+//Au-del du budget (en octets, 0 = illimit), les crations chouent et renvoient un handle vide.
+//Les objets encore vivants  la destruction du gestionnaire sont signals comme des fuites, puis librs.
+class GpuResourceManager
+{
+public:
+	GpuResourceManager(size_t budget = 0);
+	~GpuResourceManager();
+
+	void setBudget(size_t budget) { m_budget = budget; }
+	size_t getBudget() const { return m_budget; }
+
+	GpuBuffer createBuffer(GLenum target, size_t size, const void* data, GLenum usage, const char* label);
+	//buffer de taille fixe cr par glBufferStorage (ARB_buffer_storage), pour les mappings persistants
+	GpuBuffer createStorageBuffer(GLenum target, size_t size, GLbitfield flags, const char* label);
+	//texture 2D sur 4 octets par pixel, sans mipmaps
+	GpuTexture createTexture2D(int width, int height, GLenum internalFormat, GLenum format, GLenum type, const void* pixels, const char* label);
+	//tableau de textures 2D de mme taille, 4 octets par pixel, sans mipmaps
+	GpuTexture createTexture2DArray(int width, int height, int layers, GLenum internalFormat, GLenum format, GLenum type, const void* pixels, const char* label);
+	//cube map de size pixels de ct, faces dans l'ordre de GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 4 octets par pixel, sans mipmaps
+	GpuTexture createTextureCube(int size, GLenum internalFormat, GLenum format, GLenum type, const void* const faces[6], const char* label);
+	//texture sans image : ses niveaux sont dfinis ensuite par l'appelant, qui dclare leur taille avec resizeTexture()
+	GpuTexture createEmptyTexture(const char* label);
+	//change la mmoire compte pour la texture aprs le chargement ou la libration de niveaux. Renvoie false, sans rien changer,
+	//si l'augmentation dpasse le budget.
+	bool resizeTexture(const GpuTexture& texture, size_t bytes);
+	GpuVertexArray createVertexArray(const char* label);
+	//les attachements restent compts avec leurs textures
+	GpuFramebuffer createFramebuffer(const char* label);
+	GpuQuery createQuery(const char* label);
+	//le programme garde son shader, qui est dtruit avec lui
+	GpuProgram adoptProgram(Shader* shader, const char* label);
+
+	size_t getBytes(GpuResourceType type) const { return m_bytes[type]; }
+	size_t getTotalBytes() const;
+	int getCount(GpuResourceType type) const { return (int)m_records[type].size(); }
+
+	//Affiche le nombre d'objets et la mmoire par catgorie, ainsi que le pic
+	void printReport(const char* title) const;
+
+	//appel par les handles
+	void release(GpuResourceType type, GLuint id);
+
+private:
+	struct Record {
+		size_t bytes;
+		std::string label;
+		Shader* shader; //programmes uniquement
+	};
+
+	bool reserve(size_t bytes, const char* label);
+	void track(GpuResourceType type, GLuint id, size_t bytes, const char* label, Shader* shader = NULL);
+	void destroy(GpuResourceType type, GLuint id, const Record& record);
+
+	std::map<GLuint, Record> m_records[NB_GPU_RESOURCE_TYPES];
+	size_t m_bytes[NB_GPU_RESOURCE_TYPES];
+	size_t m_peakBytes;
+	size_t m_budget;
+};
+
+template<GpuResourceType TYPE>
+GpuHandle<TYPE>& GpuHandle<TYPE>::operator=(GpuHandle&& other)
+{
+	if (this != &other)
+	{
+		reset();
+		m_manager = other.m_manager;
+		m_id = other.m_id;
+		other.m_id = 0;
+	}
+	return *this;
+}
+
+template<GpuResourceType TYPE>
+void GpuHandle<TYPE>::reset()
+{
+	if (m_id != 0 && m_manager != NULL) {
+		m_manager->release(TYPE, m_id);
+	}
+	m_id = 0;
+}
+
+#endif
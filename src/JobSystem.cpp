@@ -0,0 +1,334 @@
+#include "JobSystem.h"
+
+#include "logger.h"
+
+#include "chrono"
+#include "stdio.h"
+
+//JobSystem et indice du thread courant : les threads trangers au JobSystem utilisent la file du thread principal
+static thread_local const JobSystem* t_system = NULL;
+static thread_local int t_thread = 0;
+
+JobSystem::JobSystem(int nbThreads) : m_queued(0), m_sleeping(0), m_stop(false), m_steals(0)
+{
+	if (nbThreads <= 0) {
+		nbThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+	}
+	m_queues.reset(new Queue[nbThreads]);
+	for (int i = 0; i < nbThreads; i++)
+	{
+		m_queues[i].head = 0;
+		m_queues[i].tail = 0;
+	}
+	//le thread principal travaille aussi, dans wait()
+	for (int i = 1; i < nbThreads; i++) {
+		m_workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++) {
+		m_workers[i].join();
+	}
+}
+
+int JobSystem::currentThread() const
+{
+	return t_system == this ? t_thread : 0;
+}
+
+void JobSystem::execute(const Job& job)
+{
+	job.function(job.data, job.begin, job.end);
+	if (job.counter != NULL) {
+		job.counter->fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
+
+void JobSystem::push(const Job& job)
+{
+	enqueue(job);
+	wake(false);
+}
+
+void JobSystem::enqueue(const Job& job)
+{
+	Queue& queue = m_queues[currentThread()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tail - queue.head < JOB_QUEUE_SIZE)
+		{
+			queue.jobs[queue.tail % JOB_QUEUE_SIZE] = job;
+			queue.tail++;
+			m_queued++;
+			return;
+		}
+	}
+	execute(job); //file pleine
+}
+
+//m_queued est incrment avant de lire m_sleeping, et un thread qui s'endort incrmente m_sleeping avant de relire m_queued :
+//l'un des deux voit toujours l'autre, aucun rveil n'est perdu
+void JobSystem::wake(bool all)
+{
+	if (m_sleeping.load() == 0) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(m_sleepMutex);
+	if (all) {
+		m_wake.notify_all();
+	}
+	else {
+		m_wake.notify_one();
+	}
+}
+
+bool JobSystem::pop(int thread, Job& job)
+{
+	Queue& queue = m_queues[thread];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.tail == queue.head) {
+		return false;
+	}
+	queue.tail--;
+	job = queue.jobs[queue.tail % JOB_QUEUE_SIZE];
+	m_queued--;
+	return true;
+}
+
+bool JobSystem::steal(int thief, Job& job)
+{
+	int nbThreads = getThreadCount();
+	for (int i = 1; i < nbThreads; i++)
+	{
+		Queue& queue = m_queues[(thief + i) % nbThreads];
+		std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock); //une file occupe sera revue au tour suivant
+		if (!lock.owns_lock() || queue.tail == queue.head) {
+			continue;
+		}
+		job = queue.jobs[queue.head % JOB_QUEUE_SIZE];
+		queue.head++;
+		m_queued--;
+		m_steals++;
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::runOne(int thread)
+{
+	Job job;
+	if (!pop(thread, job) && !steal(thread, job)) {
+		return false;
+	}
+	execute(job);
+	return true;
+}
+
+void JobSystem::wait(const JobCounter& counter)
+{
+	int thread = currentThread();
+	while (counter.load(std::memory_order_acquire) > 0)
+	{
+		if (!runOne(thread)) {
+			std::this_thread::yield(); //les dernires tches tournent sur d'autres threads
+		}
+	}
+}
+
+void JobSystem::workerLoop(int thread)
+{
+	t_system = this;
+	t_thread = thread;
+	int idle = 0;
+	while (!m_stop)
+	{
+		if (runOne(thread))
+		{
+			idle = 0;
+			continue;
+		}
+		if (++idle < JOB_SPIN_ROUNDS)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleeping++;
+		m_wake.wait(lock, [this] { return m_stop || m_queued.load() > 0; });
+		m_sleeping--;
+		idle = 0;
+	}
+}
+
+TaskGraph::TaskGraph() : m_remainingSize(0), m_checked(true), m_jobs(NULL), m_counter(0)
+{
+}
+
+int TaskGraph::add(const char* name, const std::function<void()>& work)
+{
+	Task task;
+	task.name = name;
+	task.work = work;
+	task.dependencies = 0;
+	m_tasks.push_back(task);
+	return (int)m_tasks.size() - 1;
+}
+
+void TaskGraph::depends(int task, int before)
+{
+	m_tasks[before].successors.push_back(task);
+	m_tasks[task].dependencies++;
+	m_checked = false;
+}
+
+//tri topologique : chaque tche doit pouvoir tre lance une fois ses dpendances finies
+bool TaskGraph::checkAcyclic() const
+{
+	std::vector<int> remaining(m_tasks.size());
+	std::vector<int> ready;
+	for (size_t i = 0; i < m_tasks.size(); i++)
+	{
+		remaining[i] = m_tasks[i].dependencies;
+		if (remaining[i] == 0) {
+			ready.push_back((int)i);
+		}
+	}
+	size_t done = 0;
+	while (done < ready.size())
+	{
+		const Task& task = m_tasks[ready[done++]];
+		for (size_t s = 0; s < task.successors.size(); s++)
+		{
+			if (--remaining[task.successors[s]] == 0) {
+				ready.push_back(task.successors[s]);
+			}
+		}
+	}
+	return done == m_tasks.size();
+}
+
+bool TaskGraph::run(JobSystem& jobs)
+{
+	if (m_tasks.empty()) {
+		return true;
+	}
+	if (!m_checked)
+	{
+		if (!checkAcyclic())
+		{
+			ERROR("The task graph has a cycle\n");
+			return false;
+		}
+		m_checked = true;
+	}
+	if (m_remainingSize != (int)m_tasks.size())
+	{
+		m_remaining.reset(new std::atomic<int>[m_tasks.size()]);
+		m_remainingSize = (int)m_tasks.size();
+	}
+
+	m_jobs = &jobs;
+	m_counter = (int)m_tasks.size();
+	for (size_t i = 0; i < m_tasks.size(); i++) {
+		m_remaining[i] = m_tasks[i].dependencies;
+	}
+	for (size_t i = 0; i < m_tasks.size(); i++)
+	{
+		if (m_tasks[i].dependencies == 0)
+		{
+			Job job = { &TaskGraph::runTask, this, (int)i, 0, &m_counter };
+			jobs.push(job);
+		}
+	}
+	jobs.wait(m_counter);
+	return true;
+}
+
+//les successeurs sont pousss avant que la tche ne dcrmente m_counter : il ne tombe  0 qu'une fois tout le graphe fini
+void TaskGraph::runTask(void* data, int task, int)
+{
+	TaskGraph* graph = (TaskGraph*)data;
+	const Task& current = graph->m_tasks[task];
+	current.work();
+	for (size_t s = 0; s < current.successors.size(); s++)
+	{
+		int successor = current.successors[s];
+		if (graph->m_remaining[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			Job job = { &TaskGraph::runTask, graph, successor, 0, &graph->m_counter };
+			graph->m_jobs->push(job);
+		}
+	}
+}
+
+//dure moyenne de fn sur plusieurs rptitions, en nanosecondes par tche
+template<typename F>
+static double nanosecondsPerTask(int count, const F& fn)
+{
+	const int nbRepeats = 20;
+	fn(); //chauffement : threads rveills, caches remplis
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int r = 0; r < nbRepeats; r++) {
+		fn();
+	}
+	double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+	return ns / nbRepeats / count;
+}
+
+void runJobBenchmark(int count)
+{
+	std::atomic<int> sink(0);
+	int maxThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+	//puissances de 2, puis tous les coeurs en dernier s'ils n'en sont pas une
+	std::vector<int> threadCounts;
+	for (int nbThreads = 1; nbThreads <= maxThreads; nbThreads *= 2) {
+		threadCounts.push_back(nbThreads);
+	}
+	if (threadCounts.back() != maxThreads) {
+		threadCounts.push_back(maxThreads);
+	}
+	for (size_t run = 0; run < threadCounts.size(); run++)
+	{
+		int nbThreads = threadCounts[run];
+		JobSystem jobs(nbThreads);
+
+		//tches vides pousses une  une, par lots qui tiennent dans une file
+		Job empty = { [](void* data, int, int) { ((std::atomic<int>*)data)->fetch_add(1, std::memory_order_relaxed); }, &sink, 0, 0, NULL };
+		double emptyNs = nanosecondsPerTask(count, [&]() {
+			for (int begin = 0; begin < count; begin += JOB_QUEUE_SIZE / 2)
+			{
+				//le compteur baisse pendant qu'on pousse : le nombre de tches est fix avant
+				int n = std::min(JOB_QUEUE_SIZE / 2, count - begin);
+				JobCounter counter(n);
+				empty.counter = &counter;
+				for (int i = 0; i < n; i++) {
+					jobs.push(empty);
+				}
+				jobs.wait(counter);
+			}
+		});
+
+		TaskGraph chain, fan;
+		int root = fan.add("root", [&]() { sink++; });
+		for (int i = 0; i < count; i++)
+		{
+			int task = chain.add("chain", [&]() { sink++; });
+			if (i > 0) {
+				chain.depends(task, task - 1);
+			}
+			fan.depends(fan.add("fan", [&]() { sink++; }), root);
+		}
+		double chainNs = nanosecondsPerTask(count, [&]() { chain.run(jobs); });
+		double fanNs = nanosecondsPerTask(count, [&]() { fan.run(jobs); });
+
+		printf("%d threads, %d tasks : empty jobs %.1f ns per task, task graph chain %.1f ns per task, fan-out %.1f ns per task, %llu steals\n",
+			nbThreads, count, emptyNs, chainNs, fanNs, (unsigned long long)jobs.getSteals());
+	}
+}
@@ -0,0 +1,140 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include "stdint.h"
+#include "algorithm"
+#include "atomic"
+#include "condition_variable"
+#include "functional"
+#include "memory"
+#include "mutex"
+#include "thread"
+#include "vector"
+
+#define JOB_QUEUE_SIZE 4096 //tches en attente par thread au plus, au-del une tche pousse est excute tout de suite
+#define JOB_SPIN_ROUNDS 256 //tentatives de vol d'un thread sans travail avant qu'il ne s'endorme
+
+//Nombre de tches pas encore termines : chaque tche le dcrmente quand elle finit, wait() attend qu'il tombe  0
+typedef std::atomic<int> JobCounter;
+
+//Tche sans allocation : function(data, begin, end), par exemple une tranche [begin, end) d'un parallelFor
+struct Job {
+	void (*function)(void* data, int begin, int end);
+	void* data;
+	int begin;
+	int end;
+	JobCounter* counter; //peut tre NULL
+};
+
+//Ordonnanceur par vol de tches. Chaque thread a sa file : il y pousse ses tches et reprend la plus rcente (la plus chaude en cache),
+//les threads sans travail volent la plus ancienne de la file d'un autre, celle qui a le plus de chances d'tre grosse.
+//Le thread qui a cr le JobSystem est le thread 0 : il n'excute des tches que lorsqu'il attend dans wait().
+//Les files sont des tampons circulaires fixes protgs chacun par son mutex : pousser ou prendre une tche n'alloue jamais.
+class JobSystem
+{
+public:
+	//nbThreads = 0 utilise tous les coeurs, le thread principal compris
+	JobSystem(int nbThreads = 0);
+	~JobSystem();
+
+	int getThreadCount() const { return (int)m_workers.size() + 1; }
+	uint64_t getSteals() const { return m_steals; }
+
+	//pousse une tche sur la file du thread appelant, le compteur doit dj la compter
+	void push(const Job& job);
+	//excute des tches, les siennes puis celles des autres, jusqu' ce que le compteur tombe  0
+	void wait(const JobCounter& counter);
+
+	//body(begin, end) sur des tranches d'au plus grain indices de [0, count), rend la main quand toutes sont faites.
+	//body ne doit pas crire ailleurs que dans sa tranche, et peut lui-mme lancer des parallelFor.
+	template<typename F>
+	void parallelFor(int count, int grain, const F& body)
+	{
+		grain = std::max(grain, 1);
+		if (count <= grain || m_workers.empty())
+		{
+			if (count > 0) {
+				body(0, count);
+			}
+			return;
+		}
+		JobCounter counter((count + grain - 1) / grain);
+		for (int begin = 0; begin < count; begin += grain)
+		{
+			Job job = { &invokeRange<F>, const_cast<F*>(&body), begin, std::min(begin + grain, count), &counter };
+			enqueue(job);
+		}
+		wake(true);
+		wait(counter);
+	}
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		Job jobs[JOB_QUEUE_SIZE];
+		uint32_t head; //plus ancienne tche, vole par les autres threads
+		uint32_t tail; //aprs la plus rcente, reprise par le propritaire
+	};
+
+	template<typename F>
+	static void invokeRange(void* data, int begin, int end) { (*(const F*)data)(begin, end); }
+	static void execute(const Job& job);
+
+	int currentThread() const;
+	void enqueue(const Job& job);
+	void wake(bool all);
+	bool pop(int thread, Job& job);
+	bool steal(int thief, Job& job);
+	bool runOne(int thread);
+	void workerLoop(int thread);
+
+	std::unique_ptr<Queue[]> m_queues;
+	std::vector<std::thread> m_workers;
+	std::atomic<int> m_queued; //tches dans les files, pour que les threads endormis sachent s'il y a du travail
+	std::atomic<int> m_sleeping;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::atomic<bool> m_stop;
+	std::atomic<uint64_t> m_steals;
+};
+
+//Graphe de tches construit une fois et relanc  chaque image. Chaque tche garde le nombre de ses dpendances :
+//quand une tche finit, elle dcrmente celui de ses successeurs et pousse ceux qui n'attendent plus rien.
+//Relancer le graphe n'alloue rien.
+class TaskGraph
+{
+public:
+	TaskGraph();
+
+	//renvoie l'indice de la tche
+	int add(const char* name, const std::function<void()>& work);
+	//task ne commence qu'aprs la fin de before
+	void depends(int task, int before);
+
+	//excute tout le graphe et rend la main quand toutes les tches sont finies, false s'il a un cycle
+	bool run(JobSystem& jobs);
+	int getTaskCount() const { return (int)m_tasks.size(); }
+
+private:
+	struct Task {
+		const char* name;
+		std::function<void()> work;
+		std::vector<int> successors;
+		int dependencies;
+	};
+
+	static void runTask(void* data, int task, int unused);
+	bool checkAcyclic() const;
+
+	std::vector<Task> m_tasks;
+	std::unique_ptr<std::atomic<int>[]> m_remaining; //dpendances pas encore finies de chaque tche pendant run()
+	int m_remainingSize;
+	bool m_checked; //le graphe n'a pas chang depuis la dernire recherche de cycle
+	JobSystem* m_jobs;
+	JobCounter m_counter;
+};
+
+//Mesure le cot d'ordonnancement par tche : tches vides en parallelFor, puis graphes en chane et en ventail de count tches
+void runJobBenchmark(int count);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+//GML libraries
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//Termes d'clairage dont un matriau a besoin. Chaque combinaison donne une variante compile de color.vert et color.frag,
+//o les termes absents n'existent pas du tout au lieu d'tre multiplis par zro.
+enum MaterialFeature {
+	MATERIAL_TEXTURED = 1, //couleur lue dans la texture, sinon la couleur du matriau
+	MATERIAL_DIFFUSE = 2,
+	MATERIAL_SPECULAR = 4,
+	MATERIAL_EMISSIVE = 8, //ni diffus ni spculaire : seul le terme ambiant, sans normale ni position
+	NB_MATERIAL_VARIANTS = 16
+};
+
+//On dfinit ici les paramtres ncessaires pour crer un matriau. La couleur n'est utilise que par les figures sans texture.
+struct Material {
+	glm::vec3 color;
+	float ka;
+	float kd;
+	float ks;
+	float alpha;
+
+	//combinaison de MaterialFeature dduite des coefficients, une figure sans texture retire MATERIAL_TEXTURED
+	int getFeatures() const
+	{
+		int features = MATERIAL_TEXTURED;
+		if (kd > 0.f) {
+			features |= MATERIAL_DIFFUSE;
+		}
+		if (ks > 0.f) {
+			features |= MATERIAL_SPECULAR;
+		}
+		if (kd <= 0.f && ks <= 0.f) {
+			features |= MATERIAL_EMISSIVE;
+		}
+		return features;
+	}
+};
+
+//On dfinit les paramtres ncessaires pour crer une lumire. On a donn une valeur par dfaut  chaque paramtres car ceux de nos diffrentes lumires varient peu.
+struct Light {
+	glm::vec3 position = glm::vec3(0.f,0.4f,-46.f);
+	glm::mat4 Coordinates = glm::translate(glm::mat4(1.0f), position);
+	glm::vec3 color = glm::vec3(0.7f, 0.65f, 0.8f);
+};
+
+#endif
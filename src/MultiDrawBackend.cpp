@@ -0,0 +1,225 @@
+#include "MultiDrawBackend.h"
+
+#include "logger.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "algorithm"
+#include "string"
+#include "unordered_map"
+#include "string.h"
+#include "math.h"
+
+#define INDICE_TO_PTR(x) ((void*)(x))
+
+MultiDrawBackend::MultiDrawBackend(SDL_Window* window, size_t vramBudget) : GLBackend(window, vramBudget),
+	m_uTextures(-1), m_storageAlignment(256), m_nbLayers(0), m_sceneDirty(false), m_drawOffset(0), m_nbDraws(0)
+{
+}
+
+bool MultiDrawBackend::init()
+{
+	if (!GLEW_ARB_multi_draw_indirect || !GLEW_ARB_shader_storage_buffer_object || !GLEW_ARB_shader_draw_parameters)
+	{
+		ERROR("The multi draw renderer needs OpenGL 4.3 and ARB_shader_draw_parameters\n");
+		return false;
+	}
+
+	FILE* vertFile = fopen("Shaders/color_multidraw.vert", "r");
+	FILE* fragFile = fopen("Shaders/color_multidraw.frag", "r");
+	if (vertFile == NULL || fragFile == NULL) {
+		ERROR("Could not open the shader files\n");
+		return false;
+	}
+	m_program = m_resources.adoptProgram(Shader::loadFromFiles(vertFile, fragFile), "color_multidraw");
+
+	fclose(vertFile);
+	fclose(fragFile);
+	if (!m_program.isValid()) {
+		return false;
+	}
+	m_uTextures = glGetUniformLocation(m_program.get(), "uTextures");
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &m_storageAlignment);
+	m_vertexArray = m_resources.createVertexArray("scene");
+	if (!initParticles() || !initSkybox() || !initStereo()) {
+		return false;
+	}
+	return initSceneTarget() && m_stream.init();
+}
+
+//Les sommets sont quantifis comme dans GLBackend, puis les sommets identiques sont fusionns pour que les figures soient dessines par indices
+int MultiDrawBackend::createMesh(const float* positions, const float* normals, const float* uvs, int nbVertices)
+{
+	QuantizedMesh quantized;
+	quantizeMesh(positions, normals, uvs, nbVertices, quantized);
+
+	MeshRange range;
+	range.firstIndex = (GLuint)m_indices.size();
+	range.nbIndices = (GLuint)nbVertices;
+	range.baseVertex = (GLint)m_vertices.size();
+	range.decode = glm::scale(glm::translate(glm::mat4(1.f), quantized.boxMin), quantized.boxExtent);
+
+	std::unordered_map<std::string, GLuint> welded;
+	for (int i = 0; i < nbVertices; i++)
+	{
+		const QuantizedVertex& v = quantized.vertices[i];
+		std::string key((const char*)&v, sizeof(QuantizedVertex));
+		std::unordered_map<std::string, GLuint>::iterator it = welded.find(key);
+		if (it == welded.end())
+		{
+			GLuint index = (GLuint)(m_vertices.size() - range.baseVertex);
+			welded[key] = index;
+			m_vertices.push_back(v);
+			m_indices.push_back(index);
+		}
+		else {
+			m_indices.push_back(it->second);
+		}
+	}
+
+	m_ranges.push_back(range);
+	m_sceneDirty = true;
+	return (int)m_ranges.size() - 1;
+}
+
+//L'image est rchantillonne (bilinaire) dans une couche de MULTIDRAW_LAYER_SIZE pixels de ct
+int MultiDrawBackend::createTexture(const uint8_t* pixels, int width, int height)
+{
+	size_t layerBytes = 4 * MULTIDRAW_LAYER_SIZE * MULTIDRAW_LAYER_SIZE;
+	m_layers.resize(m_layers.size() + layerBytes);
+	uint8_t* layer = &m_layers[m_layers.size() - layerBytes];
+
+	for (int y = 0; y < MULTIDRAW_LAYER_SIZE; y++)
+	{
+		float fy = std::max(0.f, (y + 0.5f) * height / MULTIDRAW_LAYER_SIZE - 0.5f);
+		int y0 = std::min((int)fy, height - 1);
+		int y1 = std::min(y0 + 1, height - 1);
+		float ay = fy - y0;
+		for (int x = 0; x < MULTIDRAW_LAYER_SIZE; x++)
+		{
+			float fx = std::max(0.f, (x + 0.5f) * width / MULTIDRAW_LAYER_SIZE - 0.5f);
+			int x0 = std::min((int)fx, width - 1);
+			int x1 = std::min(x0 + 1, width - 1);
+			float ax = fx - x0;
+			for (int c = 0; c < 4; c++)
+			{
+				float top = pixels[4 * (y0 * width + x0) + c] * (1 - ax) + pixels[4 * (y0 * width + x1) + c] * ax;
+				float bottom = pixels[4 * (y1 * width + x0) + c] * (1 - ax) + pixels[4 * (y1 * width + x1) + c] * ax;
+				layer[4 * (y * MULTIDRAW_LAYER_SIZE + x) + c] = (uint8_t)(top * (1 - ay) + bottom * ay + 0.5f);
+			}
+		}
+	}
+
+	m_sceneDirty = true;
+	return m_nbLayers++;
+}
+
+bool MultiDrawBackend::uploadScene()
+{
+	if (!m_sceneDirty) {
+		return m_vertexArena.isValid();
+	}
+	m_sceneDirty = false;
+
+	m_vertexArena = m_resources.createBuffer(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(QuantizedVertex), &m_vertices[0], GL_STATIC_DRAW, "vertex arena");
+	m_indexArena = m_resources.createBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLuint), &m_indices[0], GL_STATIC_DRAW, "index arena");
+	if (m_nbLayers > 0)
+	{
+		m_textureArray = m_resources.createTexture2DArray(MULTIDRAW_LAYER_SIZE, MULTIDRAW_LAYER_SIZE, m_nbLayers, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, &m_layers[0], "texture array");
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray.get());
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+	if (!m_vertexArena.isValid() || !m_indexArena.isValid() || (m_nbLayers > 0 && !m_textureArray.isValid()))
+	{
+		ERROR("The scene does not fit in the memory budget\n");
+		return false;
+	}
+
+	//positions, normales et uvs aux emplacements fixs par les layout(location) de color_multidraw.vert, dans le mme format que GLBackend
+	GLsizei stride = sizeof(QuantizedVertex);
+	glBindVertexArray(m_vertexArray.get());
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexArena.get());
+	glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, INDICE_TO_PTR(offsetof(QuantizedVertex, position)));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 2, GL_BYTE, GL_FALSE, stride, INDICE_TO_PTR(offsetof(QuantizedVertex, normal)));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, INDICE_TO_PTR(offsetof(QuantizedVertex, uv)));
+	glEnableVertexAttribArray(2);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexArena.get());
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return true;
+}
+
+void MultiDrawBackend::beginFrame()
+{
+	beginScene();
+
+	m_stream.beginFrame();
+	m_nbDraws = 0;
+	m_commands.clear();
+}
+
+//draw() crit directement dans l'anneau, rien n'est envoy  OpenGL avant endFrame()
+void MultiDrawBackend::draw(int mesh, int texture, const glm::mat4& mvp, const Material& m, const Light& l)
+{
+	const MeshRange& range = m_ranges[mesh];
+
+	//DrawData fait un multiple de 16 octets : les entres suivantes restent contigus
+	GLintptr offset;
+	DrawData* data = (DrawData*)m_stream.allocate(sizeof(DrawData), m_nbDraws == 0 ? m_storageAlignment : 16, offset);
+	if (data == NULL) {
+		return; //anneau plein, il sera agrandi  l'image suivante
+	}
+	if (m_nbDraws == 0) {
+		m_drawOffset = offset;
+	}
+	m_nbDraws++;
+
+	//le dcodage des positions par la bote est repli dans la mvp, la matrice des normales reste celle de la figure
+	data->mvp = mvp * range.decode;
+	data->normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(mvp))));
+	data->k = glm::vec4(m.ka, m.kd, m.ks, m.alpha);
+	data->color = glm::vec4(m.color, (float)texture);
+	data->lightColor = glm::vec4(l.color, 0.f);
+	data->lightPosition = glm::vec4(l.position, 1.f);
+
+	//une instance par oeil, color_multidraw.vert choisit la matrice de l'oeil avec gl_InstanceID
+	DrawElementsCommand command = { range.nbIndices, (GLuint)m_nbEyes, range.firstIndex, range.baseVertex, 0 };
+	m_commands.push_back(command);
+}
+
+void MultiDrawBackend::endFrame()
+{
+	//les commandes sont ajoutes aprs les DrawData, qui sont alors toutes crites
+	GLintptr commandOffset = 0;
+	size_t commandBytes = m_commands.size() * sizeof(DrawElementsCommand);
+	void* commands = m_commands.empty() ? NULL : m_stream.allocate(commandBytes, 4, commandOffset);
+	if (commands != NULL && uploadScene())
+	{
+		memcpy(commands, &m_commands[0], commandBytes);
+		m_stream.flush();
+
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_stream.getBuffer(), m_drawOffset, m_nbDraws * sizeof(DrawData));
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_stream.getBuffer());
+
+		glUseProgram(m_program.get());
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureArray.get());
+		glUniform1i(m_uTextures, 0);
+		glBindVertexArray(m_vertexArray.get());
+
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, INDICE_TO_PTR(commandOffset), (GLsizei)m_commands.size(), 0);
+
+		glBindVertexArray(0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	//capture et affichage
+	presentFrame();
+}
@@ -0,0 +1,84 @@
+#ifndef MULTIDRAWBACKEND_H
+#define MULTIDRAWBACKEND_H
+
+#include "GLBackend.h"
+
+#define MULTIDRAW_LAYER_SIZE 512 //taille des couches du tableau de textures, les images y sont rchantillonnes
+
+//Rendu OpenGL 4.3 pilot par la carte graphique : toutes les figures partagent un buffer de sommets et un buffer d'indices,
+//les donnes de chaque draw() (matrices, matriau, lumire, couche de texture) sont crites dans l'anneau de donnes par image
+//et lues comme un shader storage buffer avec gl_DrawID, et toute la scne part en un seul glMultiDrawElementsIndirect.
+//Le cot ct processeur ne dpend plus du nombre de figures.
+class MultiDrawBackend : public GLBackend
+{
+public:
+	MultiDrawBackend(SDL_Window* window, size_t vramBudget = 0);
+
+	//vrifie les extensions et charge les shaders color_multidraw, renvoie false en cas d'chec
+	bool init();
+
+	int createMesh(const float* positions, const float* normals, const float* uvs, int nbVertices);
+	int createTexture(const uint8_t* pixels, int width, int height);
+
+	void beginFrame();
+	void draw(int mesh, int texture, const glm::mat4& mvp, const Material& material, const Light& light);
+	void endFrame();
+
+	//les DrawData n'ont pas de matrice d'ombre : pas d'ombres dans le rendu indirect
+	bool setShadowLight(const glm::vec3&, const glm::vec3&, const glm::mat4&) { return false; }
+	void drawShadowCaster(int, const glm::mat4&, bool) {}
+
+private:
+	//emplacement d'une figure dans les buffers communs, dont les sommets sont des QuantizedVertex
+	struct MeshRange {
+		GLuint firstIndex;
+		GLuint nbIndices;
+		GLint baseVertex;
+		glm::mat4 decode; //bote englobante : positions quantifies -> repre de la figure, applique avant la mvp
+	};
+
+	//mme disposition que DrawData en std430 dans les shaders
+	struct DrawData {
+		glm::mat4 mvp;
+		glm::mat4 normalMatrix;
+		glm::vec4 k;
+		glm::vec4 color; //w : couche de la texture
+		glm::vec4 lightColor;
+		glm::vec4 lightPosition;
+	};
+
+	//commande lue par glMultiDrawElementsIndirect
+	struct DrawElementsCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	//envoie les figures et les textures cres depuis la dernire image
+	bool uploadScene();
+
+	GpuProgram m_program;
+	GpuVertexArray m_vertexArray;
+	GpuBuffer m_vertexArena;
+	GpuBuffer m_indexArena;
+	GpuTexture m_textureArray;
+	GLint m_uTextures;
+	GLint m_storageAlignment;
+
+	//copie des donnes ct processeur, envoye en une fois quand la scne change
+	std::vector<QuantizedVertex> m_vertices;
+	std::vector<GLuint> m_indices;
+	std::vector<uint8_t> m_layers;
+	int m_nbLayers;
+	bool m_sceneDirty;
+
+	std::vector<MeshRange> m_ranges;
+	//les DrawData de l'image se suivent dans l'anneau  partir de m_drawOffset, pour tre indexs par gl_DrawID
+	GLintptr m_drawOffset;
+	int m_nbDraws;
+	std::vector<DrawElementsCommand> m_commands;
+};
+
+#endif
@@ -0,0 +1,207 @@
+#include "OcclusionCuller.h"
+
+#include "logger.h"
+
+#include "algorithm"
+#include "math.h"
+
+OcclusionCuller::OcclusionCuller(GpuResourceManager& resources) : m_resources(resources), m_issued(0), m_consumed(0), m_previousFramebuffer(0), m_hasPyramid(false),
+	m_tested(0), m_culled(0), m_frames(0)
+{
+	for (int i = 0; i < HIZ_READBACKS; i++) {
+		m_fences[i] = NULL;
+	}
+	for (int i = 0; i < 4; i++) {
+		m_viewport[i] = 0;
+	}
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+	for (int i = 0; i < HIZ_READBACKS; i++)
+	{
+		if (m_fences[i] != NULL) {
+			glDeleteSync(m_fences[i]);
+		}
+	}
+	if (m_frames > 0) {
+		printf("Occlusion culling : %.1f draws tested per frame, %.1f%% hidden\n", m_tested / (double)m_frames, m_tested > 0 ? 100.0 * m_culled / m_tested : 0.0);
+	}
+}
+
+bool OcclusionCuller::init()
+{
+	m_depth = m_resources.createTexture2D(HIZ_SIZE, HIZ_SIZE, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, NULL, "hi-z depth");
+	m_framebuffer = m_resources.createFramebuffer("hi-z");
+	for (int i = 0; i < HIZ_READBACKS; i++) {
+		m_pbos[i] = m_resources.createBuffer(GL_PIXEL_PACK_BUFFER, sizeof(float) * HIZ_SIZE * HIZ_SIZE, NULL, GL_STREAM_READ, "hi-z readback");
+		if (!m_pbos[i].isValid()) {
+			return false;
+		}
+	}
+	if (!m_depth.isValid() || !m_framebuffer.isValid()) {
+		return false;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, m_depth.get());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	//profondeur seule : pas d'attachement couleur
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer.get());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depth.get(), 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		ERROR("The hi-z framebuffer is incomplete (0x%x)\n", status);
+		return false;
+	}
+
+	m_levels.clear();
+	for (int size = HIZ_SIZE; size >= 1; size /= 2) {
+		m_levels.push_back(std::vector<float>(size * size, 1.f));
+	}
+	return true;
+}
+
+bool OcclusionCuller::projectBox(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::mat4& mvp, ScreenBox& box)
+{
+	box.minX = box.minY = box.minDepth = 1e30f;
+	box.maxX = box.maxY = -1e30f;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec4 p(corner & 1 ? boxMax.x : boxMin.x, corner & 2 ? boxMax.y : boxMin.y, corner & 4 ? boxMax.z : boxMin.z, 1.f);
+		glm::vec4 clip = mvp * p;
+		if (clip.w <= 1e-5f) {
+			return false;
+		}
+		float invW = 1.f / clip.w;
+		float x = clip.x * invW * 0.5f + 0.5f;
+		float y = clip.y * invW * 0.5f + 0.5f;
+		box.minX = std::min(box.minX, x);
+		box.maxX = std::max(box.maxX, x);
+		box.minY = std::min(box.minY, y);
+		box.maxY = std::max(box.maxY, y);
+		box.minDepth = std::min(box.minDepth, clip.z * invW * 0.5f + 0.5f);
+	}
+	return true;
+}
+
+void OcclusionCuller::update()
+{
+	//de la lecture la plus rcente  la plus ancienne encore en vol, la premire arrive remplace la pyramide
+	for (uint32_t frame = m_issued; frame-- > m_consumed; )
+	{
+		GLsync fence = m_fences[frame % HIZ_READBACKS];
+		GLenum status = glClientWaitSync(fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			continue;
+		}
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[frame % HIZ_READBACKS].get());
+		const float* depth = (const float*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+		if (depth != NULL)
+		{
+			buildPyramid(depth);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			m_hasPyramid = true;
+		}
+		else {
+			ERROR("Could not map the hi-z readback buffer\n");
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		//les lectures plus anciennes ne servent plus
+		for (uint32_t old = m_consumed; old <= frame; old++)
+		{
+			glDeleteSync(m_fences[old % HIZ_READBACKS]);
+			m_fences[old % HIZ_READBACKS] = NULL;
+		}
+		m_consumed = frame + 1;
+		return;
+	}
+}
+
+void OcclusionCuller::buildPyramid(const float* depth)
+{
+	std::copy(depth, depth + HIZ_SIZE * HIZ_SIZE, m_levels[0].begin());
+	for (size_t level = 1; level < m_levels.size(); level++)
+	{
+		const std::vector<float>& source = m_levels[level - 1];
+		std::vector<float>& target = m_levels[level];
+		int sourceSize = HIZ_SIZE >> (level - 1);
+		int size = HIZ_SIZE >> level;
+		for (int y = 0; y < size; y++)
+		{
+			const float* row0 = &source[2 * y * sourceSize];
+			const float* row1 = row0 + sourceSize;
+			for (int x = 0; x < size; x++) {
+				target[y * size + x] = std::max(std::max(row0[2 * x], row0[2 * x + 1]), std::max(row1[2 * x], row1[2 * x + 1]));
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::isOccluded(const ScreenBox& box) const
+{
+	if (!m_hasPyramid) {
+		return false;
+	}
+	int x0 = std::max(0, (int)floorf(box.minX * HIZ_SIZE) - HIZ_MARGIN);
+	int y0 = std::max(0, (int)floorf(box.minY * HIZ_SIZE) - HIZ_MARGIN);
+	int x1 = std::min(HIZ_SIZE - 1, (int)floorf(box.maxX * HIZ_SIZE) + HIZ_MARGIN);
+	int y1 = std::min(HIZ_SIZE - 1, (int)floorf(box.maxY * HIZ_SIZE) + HIZ_MARGIN);
+	if (x0 > x1 || y0 > y1) {
+		return false;
+	}
+
+	//niveau o le rectangle ne couvre plus que 2 ou 3 texels de ct
+	int level = 0;
+	while (level + 1 < (int)m_levels.size() && (std::max(x1 - x0, y1 - y0) >> level) >= 2) {
+		level++;
+	}
+	int size = HIZ_SIZE >> level;
+	const std::vector<float>& depth = m_levels[level];
+	float farthest = 0.f;
+	for (int y = y0 >> level; y <= y1 >> level; y++) {
+		for (int x = x0 >> level; x <= x1 >> level; x++) {
+			farthest = std::max(farthest, depth[y * size + x]);
+		}
+	}
+	return box.minDepth > farthest;
+}
+
+void OcclusionCuller::beginOccluders()
+{
+	glGetIntegerv(GL_VIEWPORT, m_viewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_previousFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer.get());
+	glViewport(0, 0, HIZ_SIZE, HIZ_SIZE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+//glReadPixels vers un PBO rend la main tout de suite, la copie est lue par update() quand sa fence est passe
+void OcclusionCuller::endOccluders()
+{
+	int slot = m_issued % HIZ_READBACKS;
+	if (m_fences[slot] != NULL)
+	{
+		//la lecture de cet emplacement n'est jamais arrive  temps : on l'abandonne
+		glDeleteSync(m_fences[slot]);
+		m_fences[slot] = NULL;
+		m_consumed = std::max(m_consumed, m_issued - HIZ_READBACKS + 1);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[slot].get());
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, HIZ_SIZE, HIZ_SIZE, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_issued++;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_previousFramebuffer);
+	glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+}
@@ -0,0 +1,73 @@
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+//OpenGL Libraries
+#include <GL/glew.h>
+
+//GML libraries
+#include <glm/glm.hpp>
+
+#include "GpuResources.h"
+
+#include "stdint.h"
+#include "vector"
+
+#define HIZ_SIZE 256 //rsolution de la passe de profondeur des occultants, niveau 0 de la pyramide
+#define HIZ_READBACKS 3 //lectures de la profondeur en vol : la pyramide utilise est la plus rcente dj arrive
+#define HIZ_OCCLUDER_AREA 0.03f //part de l'cran que doit couvrir la bote d'une figure pour servir d'occultant
+#define HIZ_MARGIN 2 //texels ajouts autour des botes testes, la pyramide ayant au moins une image de retard
+
+//Bote englobante projete : rectangle en coordonnes normalises [0, 1], origine en bas  gauche, et profondeur la plus proche
+struct ScreenBox {
+	float minX, minY, maxX, maxY;
+	float minDepth;
+};
+
+//Occlusion culling par pyramide de profondeur (Hi-Z). Les grands occultants sont dessins en profondeur seule dans une petite
+//image de HIZ_SIZE pixels, relue de faon asynchrone par un anneau de PBO, puis rduite sur le processeur en niveaux de plus en plus
+//petits qui gardent la profondeur la plus lointaine. Une figure dont la bote est derrire tous les texels qu'elle couvre est cache.
+//La pyramide vient d'une image prcdente : une figure qui rapparat peut manquer pendant une image, mais rien n'attend la carte graphique.
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(GpuResourceManager& resources);
+	~OcclusionCuller();
+
+	bool init();
+
+	//projette la bote [boxMin, boxMax] du repre de la figure. Renvoie false si elle traverse le plan near : la figure est alors garde.
+	static bool projectBox(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::mat4& mvp, ScreenBox& box);
+
+	//rcupre la dernire profondeur arrive et reconstruit la pyramide,  appeler avant les tests de l'image
+	void update();
+	bool isOccluded(const ScreenBox& box) const;
+
+	//les draw calls faits entre ces deux appels remplissent la profondeur des occultants
+	void beginOccluders();
+	void endOccluders();
+
+	//statistiques affiches  la destruction
+	void count(int tested, int culled) { m_tested += tested; m_culled += culled; m_frames++; }
+
+private:
+	void buildPyramid(const float* depth);
+
+	GpuResourceManager& m_resources;
+	GpuTexture m_depth;
+	GpuFramebuffer m_framebuffer;
+	GpuBuffer m_pbos[HIZ_READBACKS];
+	GLsync m_fences[HIZ_READBACKS];
+	uint32_t m_issued; //lectures lances
+	uint32_t m_consumed; //lectures plus anciennes que celle de la pyramide, dj exploites ou abandonnes
+	GLint m_viewport[4]; //viewport et framebuffer de l'image, rtablis aprs la passe des occultants
+	GLint m_previousFramebuffer;
+
+	std::vector<std::vector<float> > m_levels; //profondeur maximale, le niveau 0 fait HIZ_SIZE x HIZ_SIZE
+	bool m_hasPyramid;
+
+	uint64_t m_tested;
+	uint64_t m_culled;
+	uint32_t m_frames;
+};
+
+#endif
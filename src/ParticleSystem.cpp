@@ -0,0 +1,208 @@
+#include "ParticleSystem.h"
+
+#include "algorithm"
+#include "chrono"
+#include "stdio.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define PARTICLES_SIMD
+#endif
+
+ParticleEmitter::ParticleEmitter(const ParticleSettings& settings, uint32_t seed) : m_settings(settings), m_count(0), m_random(seed != 0 ? seed : 1)
+{
+	size_t padded = (std::max(settings.capacity, 0) + 3) & ~3;
+	m_px.assign(padded, 0.f);
+	m_py.assign(padded, 0.f);
+	m_pz.assign(padded, 0.f);
+	m_vx.assign(padded, 0.f);
+	m_vy.assign(padded, 0.f);
+	m_vz.assign(padded, 0.f);
+	m_life.assign(padded, 0.f);
+	m_colors.assign(padded, 0);
+}
+
+//xorshift32 : rapide, et indpendant de rand() pour ne pas dcaler les autres tirages de la scne
+float ParticleEmitter::random()
+{
+	m_random ^= m_random << 13;
+	m_random ^= m_random >> 17;
+	m_random ^= m_random << 5;
+	return (m_random >> 8) * (2.f / 16777216.f) - 1.f;
+}
+
+int ParticleEmitter::emit(int count, const glm::vec3& position, const glm::vec3& velocity, float spread, const glm::vec3& color)
+{
+	count = std::min(count, m_settings.capacity - m_count);
+	if (count <= 0) {
+		return 0;
+	}
+	uint32_t rgba = (uint32_t)(glm::clamp(color.r, 0.f, 1.f) * 255.f) | (uint32_t)(glm::clamp(color.g, 0.f, 1.f) * 255.f) << 8
+		| (uint32_t)(glm::clamp(color.b, 0.f, 1.f) * 255.f) << 16 | 0xFF000000u;
+	for (int i = m_count; i < m_count + count; i++)
+	{
+		m_px[i] = position.x;
+		m_py[i] = position.y;
+		m_pz[i] = position.z;
+		m_vx[i] = velocity.x + spread * random();
+		m_vy[i] = velocity.y + spread * random();
+		m_vz[i] = velocity.z + spread * random();
+		m_life[i] = 0.875f + 0.125f * random(); //des morts tales sur la fin de vie plutt qu'en une seule image
+		m_colors[i] = rgba;
+	}
+	m_count += count;
+	return count;
+}
+
+void ParticleEmitter::update(float dt)
+{
+	int end = (m_count + 3) & ~3;
+#ifdef PARTICLES_SIMD
+	updateSimd(0, end, dt);
+#else
+	updateScalar(0, end, dt);
+#endif
+	compact();
+}
+
+void ParticleEmitter::updateScalar(int begin, int end, float dt)
+{
+	float damping = std::max(0.f, 1.f - m_settings.drag * dt);
+	float fade = dt / m_settings.lifetime;
+	glm::vec3 g = m_settings.gravity * dt;
+	for (int i = begin; i < end; i++)
+	{
+		m_vx[i] = (m_vx[i] + g.x) * damping;
+		m_vy[i] = (m_vy[i] + g.y) * damping;
+		m_vz[i] = (m_vz[i] + g.z) * damping;
+		m_px[i] += m_vx[i] * dt;
+		m_py[i] += m_vy[i] * dt;
+		m_pz[i] += m_vz[i] * dt;
+		m_life[i] -= fade;
+	}
+}
+
+void ParticleEmitter::updateSimd(int begin, int end, float dt)
+{
+#ifdef PARTICLES_SIMD
+	const __m128 damping = _mm_set1_ps(std::max(0.f, 1.f - m_settings.drag * dt));
+	const __m128 fade = _mm_set1_ps(dt / m_settings.lifetime);
+	const __m128 gx = _mm_set1_ps(m_settings.gravity.x * dt);
+	const __m128 gy = _mm_set1_ps(m_settings.gravity.y * dt);
+	const __m128 gz = _mm_set1_ps(m_settings.gravity.z * dt);
+	const __m128 step = _mm_set1_ps(dt);
+	float* px = &m_px[0];
+	float* py = &m_py[0];
+	float* pz = &m_pz[0];
+	float* vx = &m_vx[0];
+	float* vy = &m_vy[0];
+	float* vz = &m_vz[0];
+	float* life = &m_life[0];
+	for (int i = begin; i < end; i += 4)
+	{
+		__m128 x = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(vx + i), gx), damping);
+		__m128 y = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(vy + i), gy), damping);
+		__m128 z = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(vz + i), gz), damping);
+		_mm_storeu_ps(vx + i, x);
+		_mm_storeu_ps(vy + i, y);
+		_mm_storeu_ps(vz + i, z);
+		_mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(x, step)));
+		_mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(y, step)));
+		_mm_storeu_ps(pz + i, _mm_add_ps(_mm_loadu_ps(pz + i), _mm_mul_ps(z, step)));
+		_mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), fade));
+	}
+#else
+	updateScalar(begin, end, dt);
+#endif
+}
+
+//chaque particule morte est remplace par la dernire : l'ordre change, ce qui est sans effet avec un mlange additif
+void ParticleEmitter::compact()
+{
+	int i = 0;
+	while (i < m_count)
+	{
+		if (m_life[i] > 0.f) {
+			i++;
+			continue;
+		}
+		int last = --m_count;
+		m_px[i] = m_px[last];
+		m_py[i] = m_py[last];
+		m_pz[i] = m_pz[last];
+		m_vx[i] = m_vx[last];
+		m_vy[i] = m_vy[last];
+		m_vz[i] = m_vz[last];
+		m_life[i] = m_life[last];
+		m_colors[i] = m_colors[last];
+	}
+}
+
+ParticleBatch ParticleEmitter::getBatch(const glm::mat4& viewProjection, float pixelScale) const
+{
+	ParticleBatch batch;
+	batch.x = &m_px[0];
+	batch.y = &m_py[0];
+	batch.z = &m_pz[0];
+	batch.life = &m_life[0];
+	batch.colors = &m_colors[0];
+	batch.count = m_count;
+	batch.size = m_settings.size * pixelScale;
+	batch.viewProjection = viewProjection;
+	return batch;
+}
+
+void interleaveParticles(const ParticleBatch& batch, float* out)
+{
+	int i = 0;
+#ifdef PARTICLES_SIMD
+	//4 particules lues en colonnes (x, y, z, vie) et crites en lignes
+	for (; i + 4 <= batch.count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(batch.x + i);
+		__m128 y = _mm_loadu_ps(batch.y + i);
+		__m128 z = _mm_loadu_ps(batch.z + i);
+		__m128 life = _mm_loadu_ps(batch.life + i);
+		_MM_TRANSPOSE4_PS(x, y, z, life);
+		_mm_storeu_ps(out + 4 * i, x);
+		_mm_storeu_ps(out + 4 * i + 4, y);
+		_mm_storeu_ps(out + 4 * i + 8, z);
+		_mm_storeu_ps(out + 4 * i + 12, life);
+	}
+#endif
+	for (; i < batch.count; i++)
+	{
+		out[4 * i] = batch.x[i];
+		out[4 * i + 1] = batch.y[i];
+		out[4 * i + 2] = batch.z[i];
+		out[4 * i + 3] = batch.life[i];
+	}
+}
+
+void runParticleBenchmark(int nbParticles)
+{
+	//des tincelles qui vivent 2 secondes : environ 1/120 des particules meurent et sont relances  chaque image
+	ParticleSettings settings;
+	settings.capacity = nbParticles;
+	settings.lifetime = 2.f;
+	ParticleEmitter emitter(settings);
+	emitter.emit(nbParticles, glm::vec3(0.f, 0.4f, -40.f), glm::vec3(0.f, 1.f, 0.f), 2.f, glm::vec3(1.f, 0.6f, 0.2f));
+	std::vector<float> vertices(4 * (size_t)nbParticles);
+
+	const int nbFrames = 240;
+	double updateMs = 0.0, interleaveMs = 0.0;
+	for (int frame = 0; frame < nbFrames; frame++)
+	{
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		emitter.update(1.f / 60.f);
+		emitter.emit(nbParticles - emitter.getCount(), glm::vec3(0.f, 0.4f, -40.f), glm::vec3(0.f, 1.f, 0.f), 2.f, glm::vec3(1.f, 0.6f, 0.2f));
+		std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+		interleaveParticles(emitter.getBatch(glm::mat4(1.f), 1.f), &vertices[0]);
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		updateMs += std::chrono::duration<double, std::milli>(middle - begin).count();
+		interleaveMs += std::chrono::duration<double, std::milli>(end - middle).count();
+	}
+
+	printf("%d particles : update and respawn %.3f ms, vertex packing %.3f ms, total %.3f ms per frame (%.2f ns per particle)\n",
+		nbParticles, updateMs / nbFrames, interleaveMs / nbFrames, (updateMs + interleaveMs) / nbFrames, (updateMs + interleaveMs) * 1e6 / nbFrames / nbParticles);
+}
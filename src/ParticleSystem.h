@@ -0,0 +1,67 @@
+#ifndef PARTICLESYSTEM_H
+#define PARTICLESYSTEM_H
+
+//GML libraries
+#include <glm/glm.hpp>
+
+#include "RenderBackend.h"
+
+#include "stdint.h"
+#include "vector"
+
+//Rglages d'un metteur, dans les units de la scne
+struct ParticleSettings {
+	int capacity = 4096; //particules vivantes au plus, rserves une fois pour toutes
+	float lifetime = 1.f; //dure de vie en secondes
+	glm::vec3 gravity = glm::vec3(0.f, -6.45f, 0.f);
+	float drag = 1.f; //perte de vitesse par seconde : v *= 1 - drag * dt
+	float size = 0.02f; //diamtre d'une particule
+};
+
+//Rserve de particules de taille fixe, ranges en tableaux spars (SoA) et mises  jour 4  la fois en SIMD.
+//Aucune allocation aprs la construction : emit() s'arrte quand la rserve est pleine et les particules mortes
+//sont remplaces par les dernires du tableau. Tout l'metteur est dessin en un seul appel  drawParticles().
+class ParticleEmitter
+{
+public:
+	//seed rend le tirage des vitesses reproductible pour le rejeu
+	ParticleEmitter(const ParticleSettings& settings, uint32_t seed = 1);
+
+	//lance count particules depuis position,  velocity plus une vitesse alatoire d'au plus spread dans chaque direction.
+	//Renvoie le nombre de particules rellement lances.
+	int emit(int count, const glm::vec3& position, const glm::vec3& velocity, float spread, const glm::vec3& color);
+	void update(float dt);
+	void clear() { m_count = 0; }
+
+	int getCount() const { return m_count; }
+	int getCapacity() const { return m_settings.capacity; }
+
+	//pixelScale : taille en pixels d'un objet de taille 1  distance 1 de la camra
+	ParticleBatch getBatch(const glm::mat4& viewProjection, float pixelScale) const;
+
+private:
+	//particules [begin, end[, multiples de 4 en SIMD
+	void updateScalar(int begin, int end, float dt);
+	void updateSimd(int begin, int end, float dt);
+	//retire les particules mortes
+	void compact();
+	//nombre alatoire dans [-1, 1]
+	float random();
+
+	ParticleSettings m_settings;
+	//tableaux de capacit arrondie au multiple de 4 suprieur, pour que le SIMD puisse dpasser m_count
+	std::vector<float> m_px, m_py, m_pz;
+	std::vector<float> m_vx, m_vy, m_vz;
+	std::vector<float> m_life; //1  la naissance, mort  0
+	std::vector<uint32_t> m_colors; //RGBA8
+	int m_count;
+	uint32_t m_random; //tat du xorshift
+};
+
+//Entrelace les positions et la vie de batch en (x, y, z, vie), 4 floats par particule, pour un vertex buffer
+void interleaveParticles(const ParticleBatch& batch, float* out);
+
+//Mesure le cot par image de nbParticles particules vivantes (mise  jour et entrelacement) et l'affiche
+void runParticleBenchmark(int nbParticles);
+
+#endif
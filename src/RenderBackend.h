@@ -0,0 +1,77 @@
+#ifndef RENDERBACKEND_H
+#define RENDERBACKEND_H
+
+#include "Material.h"
+
+#include "stdint.h"
+
+#define UPSCALE_SHARPNESS 0.2f //force du filtre de nettet quand l'image rendue  chelle rduite est agrandie
+
+class FrameCapture;
+class FramePacer;
+struct StereoViews;
+
+//Particules d'un metteur, en tableaux spars : positions, vie restante (1  la naissance, 0  la mort) et couleur RGBA8.
+struct ParticleBatch {
+	const float* x;
+	const float* y;
+	const float* z;
+	const float* life;
+	const uint32_t* colors;
+	int count;
+	float size; //diamtre en pixels d'une particule  distance 1 de la camra
+	glm::mat4 viewProjection;
+};
+
+//Interface commune aux moteurs de rendu (OpenGL ou logiciel). Les figures et les textures sont dsignes par l'indice renvoy  leur cration.
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() {}
+
+	//positions (3 floats), normales (3 floats) et uvs (2 floats) de nbVertices sommets, 3 sommets par triangle. Renvoie -1 si la mmoire manque.
+	virtual int createMesh(const float* positions, const float* normals, const float* uvs, int nbVertices) = 0;
+	//pixels RGBA8, ligne par ligne. Renvoie -1 si la mmoire manque.
+	virtual int createTexture(const uint8_t* pixels, int width, int height) = 0;
+	//panorama quirectangulaire RGBA8, premire ligne en haut, converti en cube map pour drawSkybox(). Renvoie -1 si la mmoire manque.
+	virtual int createSkybox(const uint8_t* pixels, int width, int height) = 0;
+
+	virtual void beginFrame() = 0;
+	virtual void draw(int mesh, int texture, const glm::mat4& mvp, const Material& material, const Light& light) = 0;
+	//toutes les particules de batch en un seul appel, en points ronds mlangs par addition par-dessus les figures.
+	//Les donnes sont copies pendant l'appel.
+	virtual void drawParticles(const ParticleBatch& batch) = 0;
+	//fond de l'image : la cube map est lue sur les seuls pixels o aucune figure n'a t dessine, sans clairage.
+	//viewProjection ne doit pas contenir la translation de la camra. Un seul fond par image, le dernier appel l'emporte.
+	virtual void drawSkybox(int skybox, const glm::mat4& viewProjection) = 0;
+	//Ombres d'une lumire ponctuelle place en position et tourne vers target, dans le monde, sur les draw() qui suivent.
+	//viewProjection est la camra des mvp donnes  draw().  appeler  chaque image, aprs beginFrame() et avant les draw().
+	//Renvoie false si le moteur ne sait pas rendre d'ombres.
+	virtual bool setShadowLight(const glm::vec3& position, const glm::vec3& target, const glm::mat4& viewProjection) = 0;
+	//figure qui projette une ombre  cette image, model tant son repre dans le monde. Les figures fixes (isStatic) ne sont redessines
+	//dans la carte d'ombre que si l'une d'elles ou la lumire a boug : elles doivent tre donnes dans le mme ordre  chaque image.
+	virtual void drawShadowCaster(int mesh, const glm::mat4& model, bool isStatic) = 0;
+	//termine l'image et l'affiche
+	virtual void endFrame() = 0;
+
+	//Chaque image affiche est ensuite confie  capture (NULL pour arrter). En arrtant, les images encore en cours de lecture sont transmises.
+	virtual void setCapture(FrameCapture* capture) = 0;
+	//Chaque image attend l'chance de pacer avant d'tre affiche (NULL : affichage immdiat)
+	virtual void setFramePacer(FramePacer* pacer) = 0;
+
+	//La scne est rendue dans une image rduite de scale en largeur et en hauteur (0 < scale <= 1), agrandie  l'affichage
+	//avec un filtre de nettet. Le changement prend effet  la prochaine image.
+	virtual void setRenderScale(float scale) = 0;
+	virtual float getRenderScale() const = 0;
+	//dure de rendu en ms de la dernire image mesure par le moteur, -1 si elle n'est pas connue
+	virtual float getRenderTime() const = 0;
+
+	//Stro cte  cte en une seule passe : chaque draw() est rendu pour les deux yeux, avec les matrices de views appliques
+	//aux mvp de la camra centrale. NULL revient  la vue unique. Renvoie false si le moteur ne sait pas rendre en stro.
+	virtual bool setStereo(const StereoViews* views) = 0;
+
+	//Affiche la mmoire occupe par les figures et les textures
+	virtual void printMemoryReport(const char* title) const = 0;
+};
+
+#endif
@@ -0,0 +1,221 @@
+#include "Replay.h"
+
+#include "logger.h"
+
+#include "algorithm"
+#include "string.h"
+
+static void writeU32(FILE* file, uint32_t value)
+{
+	uint8_t bytes[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+	fwrite(bytes, 1, 4, file);
+}
+
+static void writeU16(FILE* file, uint16_t value)
+{
+	uint8_t bytes[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+	fwrite(bytes, 1, 2, file);
+}
+
+static bool readU32(FILE* file, uint32_t& value)
+{
+	uint8_t bytes[4];
+	if (fread(bytes, 1, 4, file) != 4) {
+		return false;
+	}
+	value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+	return true;
+}
+
+static bool readU16(FILE* file, uint16_t& value)
+{
+	uint8_t bytes[2];
+	if (fread(bytes, 1, 2, file) != 2) {
+		return false;
+	}
+	value = bytes[0] | (bytes[1] << 8);
+	return true;
+}
+
+InputRecorder::InputRecorder() : m_file(NULL)
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+	close();
+}
+
+bool InputRecorder::open(const char* path, uint32_t seed, uint32_t framerate)
+{
+	m_file = fopen(path, "wb");
+	if (m_file == NULL) {
+		ERROR("Could not open the replay file %s\n", path);
+		return false;
+	}
+	fwrite("RPLY", 1, 4, m_file);
+	writeU32(m_file, REPLAY_VERSION);
+	writeU32(m_file, seed);
+	writeU32(m_file, framerate);
+	return true;
+}
+
+void InputRecorder::recordEvent(const SDL_Event& event)
+{
+	if (m_file == NULL) {
+		return;
+	}
+	RecordedEvent recorded;
+	switch (event.type)
+	{
+	case SDL_KEYDOWN:
+		recorded.type = RECORDED_KEYDOWN;
+		recorded.a = event.key.keysym.sym;
+		recorded.b = 0;
+		break;
+	case SDL_MOUSEBUTTONDOWN:
+		recorded.type = RECORDED_MOUSEBUTTONDOWN;
+		recorded.a = event.button.x;
+		recorded.b = event.button.y;
+		break;
+	default:
+		return;
+	}
+	m_current.events.push_back(recorded);
+}
+
+void InputRecorder::endFrame(uint32_t frame, uint32_t timestamp)
+{
+	m_current.frame = frame;
+	m_current.timestamp = timestamp;
+	if (m_file == NULL || m_current.events.empty()) {
+		return;
+	}
+	writeU32(m_file, frame);
+	writeU32(m_file, timestamp);
+	writeU16(m_file, (uint16_t)m_current.events.size());
+	for (size_t i = 0; i < m_current.events.size(); i++)
+	{
+		fwrite(&m_current.events[i].type, 1, 1, m_file);
+		writeU32(m_file, (uint32_t)m_current.events[i].a);
+		writeU32(m_file, (uint32_t)m_current.events[i].b);
+	}
+	m_current.events.clear();
+}
+
+void InputRecorder::close()
+{
+	if (m_file == NULL) {
+		return;
+	}
+	//la dernire image, mme vide, donne la dure du journal
+	writeU32(m_file, m_current.frame);
+	writeU32(m_file, m_current.timestamp);
+	writeU16(m_file, 0);
+	fclose(m_file);
+	m_file = NULL;
+}
+
+InputReplayer::InputReplayer() : m_next(0), m_seed(0), m_framerate(0)
+{
+}
+
+bool InputReplayer::open(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		ERROR("Could not open the replay file %s\n", path);
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version;
+	if (fread(magic, 1, 4, file) != 4 || memcmp(magic, "RPLY", 4) != 0 || !readU32(file, version) || version != REPLAY_VERSION
+		|| !readU32(file, m_seed) || !readU32(file, m_framerate) || m_framerate == 0)
+	{
+		ERROR("%s is not a valid replay file\n", path);
+		fclose(file);
+		return false;
+	}
+
+	RecordedFrame frame;
+	uint16_t nbEvents;
+	while (readU32(file, frame.frame) && readU32(file, frame.timestamp) && readU16(file, nbEvents))
+	{
+		frame.events.resize(nbEvents);
+		for (uint16_t i = 0; i < nbEvents; i++)
+		{
+			uint32_t a, b;
+			if (fread(&frame.events[i].type, 1, 1, file) != 1 || !readU32(file, a) || !readU32(file, b)) {
+				ERROR("The replay file %s is truncated\n", path);
+				fclose(file);
+				return false;
+			}
+			frame.events[i].a = (int32_t)a;
+			frame.events[i].b = (int32_t)b;
+		}
+		m_frames.push_back(frame);
+	}
+	fclose(file);
+	m_next = 0;
+	return true;
+}
+
+void InputReplayer::getEvents(uint32_t frame, std::vector<SDL_Event>& events)
+{
+	events.clear();
+	while (m_next < m_frames.size() && m_frames[m_next].frame < frame) {
+		m_next++;
+	}
+	if (m_next >= m_frames.size() || m_frames[m_next].frame != frame) {
+		return;
+	}
+
+	const std::vector<RecordedEvent>& recorded = m_frames[m_next].events;
+	for (size_t i = 0; i < recorded.size(); i++)
+	{
+		SDL_Event event;
+		memset(&event, 0, sizeof(event));
+		if (recorded[i].type == RECORDED_KEYDOWN) {
+			event.type = SDL_KEYDOWN;
+			event.key.keysym.sym = recorded[i].a;
+		}
+		else {
+			event.type = SDL_MOUSEBUTTONDOWN;
+			event.button.button = SDL_BUTTON_LEFT;
+			event.button.x = recorded[i].a;
+			event.button.y = recorded[i].b;
+		}
+		events.push_back(event);
+	}
+}
+
+bool FrameTimings::write(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		ERROR("Could not open the timings file %s\n", path);
+		return false;
+	}
+	fprintf(file, "frame;ms\n");
+	for (size_t i = 0; i < m_times.size(); i++) {
+		fprintf(file, "%u;%.4f\n", (unsigned)(i + 1), m_times[i]);
+	}
+	fclose(file);
+	return true;
+}
+
+void FrameTimings::printSummary() const
+{
+	if (m_times.empty()) {
+		return;
+	}
+	std::vector<double> sorted = m_times;
+	std::sort(sorted.begin(), sorted.end());
+	double sum = 0;
+	for (size_t i = 0; i < sorted.size(); i++) {
+		sum += sorted[i];
+	}
+	printf("%u frames : mean %.3f ms, median %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n", (unsigned)sorted.size(), sum / sorted.size(),
+		sorted[sorted.size() / 2], sorted[sorted.size() * 95 / 100], sorted[sorted.size() * 99 / 100], sorted.back());
+}
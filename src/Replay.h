@@ -0,0 +1,92 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+//SDL Libraries
+#include <SDL2/SDL.h>
+
+#include "stdio.h"
+#include "stdint.h"
+#include "vector"
+
+//Format du journal (entiers little-endian) :
+//  en-tte : "RPLY", version, graine de rand(), framerate (uint32)
+//  puis pour chaque image ayant des vnements : numro d'image (uint32), instant en ms (uint32), nombre d'vnements (uint16)
+//  suivi des vnements : type (uint8), deux paramtres (int32)
+//  la dernire image enregistre est toujours crite, mme sans vnement, pour connatre la dure du journal
+#define REPLAY_VERSION 1
+#define TIMINGS_RESERVED_FRAMES (60 * 60 * 10) //dix minutes  60 images par seconde sans que la liste des dures ne grandisse
+
+enum RecordedEventType {
+	RECORDED_KEYDOWN = 0, //a = touche
+	RECORDED_MOUSEBUTTONDOWN = 1 //a = x, b = y
+};
+
+struct RecordedEvent {
+	uint8_t type;
+	int32_t a;
+	int32_t b;
+};
+
+struct RecordedFrame {
+	uint32_t frame;
+	uint32_t timestamp;
+	std::vector<RecordedEvent> events;
+};
+
+//Enregistre les entres de l'utilisateur image par image
+class InputRecorder
+{
+public:
+	InputRecorder();
+	~InputRecorder();
+
+	bool open(const char* path, uint32_t seed, uint32_t framerate);
+	//Ajoute un vnement  l'image en cours. Les vnements qui n'influencent pas la simulation sont ignors.
+	void recordEvent(const SDL_Event& event);
+	void endFrame(uint32_t frame, uint32_t timestamp);
+	void close();
+
+private:
+	FILE* m_file;
+	RecordedFrame m_current;
+};
+
+//Relit un journal et redonne les vnements de chaque image
+class InputReplayer
+{
+public:
+	InputReplayer();
+
+	bool open(const char* path);
+	uint32_t getSeed() const { return m_seed; }
+	uint32_t getFramerate() const { return m_framerate; }
+	uint32_t getLastFrame() const { return m_frames.empty() ? 0 : m_frames.back().frame; }
+	bool isFinished(uint32_t frame) const { return frame > getLastFrame(); }
+
+	//Remplit events avec les vnements SDL enregistrs pour cette image. Les images doivent tre demandes dans l'ordre.
+	void getEvents(uint32_t frame, std::vector<SDL_Event>& events);
+
+private:
+	std::vector<RecordedFrame> m_frames;
+	size_t m_next;
+	uint32_t m_seed;
+	uint32_t m_framerate;
+};
+
+//Dures des images d'une excution, pour comparer les distributions entre deux versions
+class FrameTimings
+{
+public:
+	FrameTimings() { m_times.reserve(TIMINGS_RESERVED_FRAMES); }
+
+	void add(double frameMs) { m_times.push_back(frameMs); }
+	//crit une ligne "image;dure en ms" par image
+	bool write(const char* path) const;
+	//Affiche moyenne, mdiane et centiles
+	void printSummary() const;
+
+private:
+	std::vector<double> m_times;
+};
+
+#endif
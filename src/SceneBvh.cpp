@@ -0,0 +1,527 @@
+#include "SceneBvh.h"
+
+#include "algorithm"
+#include "chrono"
+#include "float.h"
+#include "math.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+//bote dans le monde du cube [-0.5, 0.5] transform par model
+static void figureBox(const glm::mat4& model, glm::vec3& boxMin, glm::vec3& boxMax)
+{
+	glm::vec3 center = glm::vec3(model[3]);
+	glm::vec3 half = 0.5f * (glm::abs(glm::vec3(model[0])) + glm::abs(glm::vec3(model[1])) + glm::abs(glm::vec3(model[2])));
+	boxMin = center - half;
+	boxMax = center + half;
+}
+
+//moiti de la surface de la bote, seule sa proportion compte pour la SAH
+static float halfArea(const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+	glm::vec3 d = glm::max(boxMax - boxMin, glm::vec3(0.f));
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+//part d'un noeud dans le cot SAH, avant division par l'aire de la racine
+static float weightedArea(const glm::vec3& boxMin, const glm::vec3& boxMax, int count)
+{
+	return halfArea(boxMin, boxMax) * (count == 0 ? BVH_TRAVERSAL_COST : (float)count);
+}
+
+SceneBvh::SceneBvh() : m_weightedArea(0.0), m_builtCost(0.f), m_rebuilds(0)
+{
+}
+
+void SceneBvh::build(const std::vector<PickFigure>& figures)
+{
+	int nbFigures = (int)figures.size();
+	m_shapes.resize(nbFigures);
+	m_inverses.resize(nbFigures);
+	m_boxMin.resize(nbFigures);
+	m_boxMax.resize(nbFigures);
+	for (int i = 0; i < nbFigures; i++)
+	{
+		m_shapes[i] = figures[i].shape;
+		setFigure(i, figures[i].model);
+	}
+	buildTree();
+}
+
+void SceneBvh::buildTree()
+{
+	int nbFigures = (int)m_shapes.size();
+	m_order.resize(nbFigures);
+	for (int i = 0; i < nbFigures; i++) {
+		m_order[i] = i;
+	}
+	m_leafOf.assign(nbFigures, 0);
+	m_nodes.clear();
+	m_parents.clear();
+	m_dirty.clear();
+	if (nbFigures > 0)
+	{
+		//au plus 2n - 1 noeuds : rservs d'avance, les refit de chaque image n'allouent rien
+		m_nodes.reserve(2 * nbFigures - 1);
+		m_parents.reserve(2 * nbFigures - 1);
+		m_nodes.push_back(Node());
+		m_parents.push_back(-1);
+		buildNode(0, 0, nbFigures, 0);
+	}
+	m_dirty.reserve(m_nodes.size());
+	m_dirtyFlags.assign(m_nodes.size(), 0);
+	m_weightedArea = 0.0;
+	for (size_t i = 0; i < m_nodes.size(); i++) {
+		m_weightedArea += weightedArea(m_nodes[i].boxMin, m_nodes[i].boxMax, m_nodes[i].count);
+	}
+	m_builtCost = treeCost();
+}
+
+void SceneBvh::buildNode(int node, int first, int count, int depth)
+{
+	//bote des figures, et bote de leurs centres o sont placs les intervalles
+	glm::vec3 boxMin(FLT_MAX), boxMax(-FLT_MAX), centerMin(FLT_MAX), centerMax(-FLT_MAX);
+	for (int i = first; i < first + count; i++)
+	{
+		int f = m_order[i];
+		boxMin = glm::min(boxMin, m_boxMin[f]);
+		boxMax = glm::max(boxMax, m_boxMax[f]);
+		glm::vec3 center = 0.5f * (m_boxMin[f] + m_boxMax[f]);
+		centerMin = glm::min(centerMin, center);
+		centerMax = glm::max(centerMax, center);
+	}
+	m_nodes[node].boxMin = boxMin;
+	m_nodes[node].boxMax = boxMax;
+	m_nodes[node].first = first;
+	m_nodes[node].count = count;
+
+	//meilleure coupe parmi les BVH_BINS - 1 limites d'intervalles de chaque axe
+	int bestAxis = -1, bestSplit = 0;
+	float bestCost = FLT_MAX;
+	float nodeArea = std::max(halfArea(boxMin, boxMax), FLT_MIN);
+	if (count > 1 && depth < BVH_MAX_DEPTH)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = centerMax[axis] - centerMin[axis];
+			if (extent <= 0.f) {
+				continue;
+			}
+			float scale = BVH_BINS / extent;
+			glm::vec3 binMin[BVH_BINS], binMax[BVH_BINS];
+			int binCount[BVH_BINS] = { 0 };
+			for (int b = 0; b < BVH_BINS; b++)
+			{
+				binMin[b] = glm::vec3(FLT_MAX);
+				binMax[b] = glm::vec3(-FLT_MAX);
+			}
+			for (int i = first; i < first + count; i++)
+			{
+				int f = m_order[i];
+				float center = 0.5f * (m_boxMin[f][axis] + m_boxMax[f][axis]);
+				int b = std::min(BVH_BINS - 1, (int)((center - centerMin[axis]) * scale));
+				binMin[b] = glm::min(binMin[b], m_boxMin[f]);
+				binMax[b] = glm::max(binMax[b], m_boxMax[f]);
+				binCount[b]++;
+			}
+
+			//surfaces et nombres de figures  gauche de chaque limite, puis balayage depuis la droite
+			float leftArea[BVH_BINS - 1];
+			int leftCount[BVH_BINS - 1];
+			glm::vec3 sweepMin(FLT_MAX), sweepMax(-FLT_MAX);
+			int sweepCount = 0;
+			for (int b = 0; b < BVH_BINS - 1; b++)
+			{
+				sweepMin = glm::min(sweepMin, binMin[b]);
+				sweepMax = glm::max(sweepMax, binMax[b]);
+				sweepCount += binCount[b];
+				leftArea[b] = halfArea(sweepMin, sweepMax);
+				leftCount[b] = sweepCount;
+			}
+			sweepMin = glm::vec3(FLT_MAX);
+			sweepMax = glm::vec3(-FLT_MAX);
+			sweepCount = 0;
+			for (int b = BVH_BINS - 1; b > 0; b--)
+			{
+				sweepMin = glm::min(sweepMin, binMin[b]);
+				sweepMax = glm::max(sweepMax, binMax[b]);
+				sweepCount += binCount[b];
+				if (leftCount[b - 1] == 0 || sweepCount == 0) {
+					continue;
+				}
+				float cost = BVH_TRAVERSAL_COST + (leftArea[b - 1] * leftCount[b - 1] + halfArea(sweepMin, sweepMax) * sweepCount) / nodeArea;
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = b;
+				}
+			}
+		}
+	}
+
+	//une feuille si aucune coupe ne cote moins que de tester toutes ses figures et qu'elle reste petite.
+	//Des figures aux centres confondus sont coupes en deux.
+	if ((bestCost >= count && count <= BVH_LEAF_SIZE) || count <= 1 || depth >= BVH_MAX_DEPTH)
+	{
+		for (int i = first; i < first + count; i++) {
+			m_leafOf[m_order[i]] = node;
+		}
+		return;
+	}
+	int middle = count / 2;
+	if (bestAxis >= 0)
+	{
+		float centerBase = centerMin[bestAxis];
+		float scale = BVH_BINS / (centerMax[bestAxis] - centerBase);
+		int split = bestSplit;
+		const std::vector<glm::vec3>& figureMin = m_boxMin;
+		const std::vector<glm::vec3>& figureMax = m_boxMax;
+		int axis = bestAxis;
+		int* middlePointer = std::partition(&m_order[first], &m_order[first] + count, [&](int f) {
+			float center = 0.5f * (figureMin[f][axis] + figureMax[f][axis]);
+			return std::min(BVH_BINS - 1, (int)((center - centerBase) * scale)) < split;
+		});
+		middle = (int)(middlePointer - &m_order[first]);
+		if (middle == 0 || middle == count) {
+			middle = count / 2;
+		}
+	}
+
+	int left = (int)m_nodes.size();
+	m_nodes.push_back(Node());
+	m_nodes.push_back(Node());
+	m_parents.push_back(node);
+	m_parents.push_back(node);
+	m_nodes[node].first = left;
+	m_nodes[node].count = 0;
+	buildNode(left, first, middle, depth + 1);
+	buildNode(left + 1, first + middle, count - middle, depth + 1);
+}
+
+void SceneBvh::setFigure(int figure, const glm::mat4& model)
+{
+	glm::mat4 inverse = glm::inverse(model);
+	for (int r = 0; r < 3; r++) {
+		m_inverses[figure].rows[r] = glm::vec4(inverse[0][r], inverse[1][r], inverse[2][r], inverse[3][r]);
+	}
+
+	glm::vec3 boxMin, boxMax;
+	figureBox(model, boxMin, boxMax);
+	if (m_nodes.empty() || (boxMin == m_boxMin[figure] && boxMax == m_boxMax[figure]))
+	{
+		m_boxMin[figure] = boxMin;
+		m_boxMax[figure] = boxMax;
+		return;
+	}
+	m_boxMin[figure] = boxMin;
+	m_boxMax[figure] = boxMax;
+	int leaf = m_leafOf[figure];
+	if (!m_dirtyFlags[leaf])
+	{
+		m_dirtyFlags[leaf] = 1;
+		m_dirty.push_back(leaf);
+	}
+}
+
+void SceneBvh::updateNodeBox(int node)
+{
+	Node& n = m_nodes[node];
+	glm::vec3 boxMin(FLT_MAX), boxMax(-FLT_MAX);
+	if (n.count == 0)
+	{
+		boxMin = glm::min(m_nodes[n.first].boxMin, m_nodes[n.first + 1].boxMin);
+		boxMax = glm::max(m_nodes[n.first].boxMax, m_nodes[n.first + 1].boxMax);
+	}
+	for (int i = n.first; i < n.first + n.count; i++)
+	{
+		boxMin = glm::min(boxMin, m_boxMin[m_order[i]]);
+		boxMax = glm::max(boxMax, m_boxMax[m_order[i]]);
+	}
+	//le cot suit les seuls noeuds recalculs : le refit reste proportionnel  ce qui a boug
+	m_weightedArea += weightedArea(boxMin, boxMax, n.count) - weightedArea(n.boxMin, n.boxMax, n.count);
+	n.boxMin = boxMin;
+	n.boxMax = boxMax;
+}
+
+bool SceneBvh::refit()
+{
+	if (m_dirty.empty()) {
+		return false;
+	}
+	for (size_t d = 0; d < m_dirty.size(); d++)
+	{
+		int node = m_dirty[d];
+		m_dirtyFlags[node] = 0;
+		updateNodeBox(node);
+		//on remonte tant que les botes changent : au-dessus, rien n'a boug
+		for (int parent = m_parents[node]; parent >= 0; parent = m_parents[parent])
+		{
+			glm::vec3 oldMin = m_nodes[parent].boxMin, oldMax = m_nodes[parent].boxMax;
+			updateNodeBox(parent);
+			if (m_nodes[parent].boxMin == oldMin && m_nodes[parent].boxMax == oldMax) {
+				break;
+			}
+		}
+	}
+	m_dirty.clear();
+
+	//des figures qui ont travers la scne laissent des botes qui se chevauchent : l'arbre est refait
+	if (treeCost() > BVH_REBUILD_RATIO * m_builtCost)
+	{
+		buildTree();
+		m_rebuilds++;
+		return true;
+	}
+	return false;
+}
+
+//cot SAH attendu d'un rayon qui touche la racine, en tests de figures
+float SceneBvh::treeCost() const
+{
+	if (m_nodes.empty()) {
+		return 0.f;
+	}
+	return (float)(m_weightedArea / std::max(halfArea(m_nodes[0].boxMin, m_nodes[0].boxMax), FLT_MIN));
+}
+
+bool SceneBvh::intersectNode(const Node& node, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance)
+{
+	glm::vec3 t0 = (node.boxMin - origin) * inverseDirection;
+	glm::vec3 t1 = (node.boxMax - origin) * inverseDirection;
+	glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+	float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.f));
+	float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+	distance = enter;
+	return enter <= exit;
+}
+
+//Le rayon passe dans le repre de la figure, o elle tient dans [-0.5, 0.5]. Le repre est affine : la distance le long du rayon reste la mme.
+//Un rayon qui part de l'intrieur touche la figure  la distance 0.
+bool SceneBvh::intersectFigure(int figure, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const
+{
+	const InverseModel& inverse = m_inverses[figure];
+	glm::vec3 o(glm::dot(inverse.rows[0], glm::vec4(origin, 1.f)), glm::dot(inverse.rows[1], glm::vec4(origin, 1.f)), glm::dot(inverse.rows[2], glm::vec4(origin, 1.f)));
+	glm::vec3 d(glm::dot(inverse.rows[0], glm::vec4(direction, 0.f)), glm::dot(inverse.rows[1], glm::vec4(direction, 0.f)), glm::dot(inverse.rows[2], glm::vec4(direction, 0.f)));
+
+	float enter = 0.f, exit = maxDistance;
+	//tranches du cube : les trois axes pour la bote, z seulement pour le cylindre, aucun pour la sphre
+	int nbSlabs = m_shapes[figure] == PICK_BOX ? 3 : (m_shapes[figure] == PICK_CYLINDER ? 1 : 0);
+	for (int s = 0; s < nbSlabs; s++)
+	{
+		int axis = nbSlabs == 1 ? 2 : s;
+		if (d[axis] == 0.f)
+		{
+			if (fabsf(o[axis]) > 0.5f) {
+				return false;
+			}
+			continue;
+		}
+		float t0 = (-0.5f - o[axis]) / d[axis], t1 = (0.5f - o[axis]) / d[axis];
+		enter = std::max(enter, std::min(t0, t1));
+		exit = std::min(exit, std::max(t0, t1));
+	}
+
+	//sphre de rayon 0.5, ou cylindre infini de rayon 0.5 autour de z
+	if (m_shapes[figure] != PICK_BOX)
+	{
+		if (m_shapes[figure] == PICK_CYLINDER)
+		{
+			o.z = 0.f;
+			d.z = 0.f;
+		}
+		float a = glm::dot(d, d), b = glm::dot(o, d), c = glm::dot(o, o) - 0.25f;
+		if (a == 0.f)
+		{
+			if (c > 0.f) {
+				return false;
+			}
+		}
+		else
+		{
+			float discriminant = b * b - a * c;
+			if (discriminant < 0.f) {
+				return false;
+			}
+			float root = sqrtf(discriminant);
+			enter = std::max(enter, (-b - root) / a);
+			exit = std::min(exit, (-b + root) / a);
+		}
+	}
+	distance = enter;
+	return enter <= exit;
+}
+
+bool SceneBvh::traverse(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, int ignore, bool anyHit, RayHit& hit) const
+{
+	hit.figure = -1;
+	float length = glm::length(direction);
+	if (m_nodes.empty() || length == 0.f) {
+		return false;
+	}
+	glm::vec3 dir = direction / length;
+	glm::vec3 inverseDirection = glm::vec3(1.f) / dir; //infini sur un axe o le rayon ne bouge pas : les tranches le grent
+	float closest = maxDistance;
+
+	//noeuds  visiter avec leur distance d'entre, le plus proche des deux enfants est visit en premier
+	int stack[BVH_MAX_DEPTH + 2];
+	float stackDistance[BVH_MAX_DEPTH + 2];
+	int top = 0;
+	float distance;
+	if (!intersectNode(m_nodes[0], origin, inverseDirection, closest, distance)) {
+		return false;
+	}
+	stack[top] = 0;
+	stackDistance[top++] = distance;
+	while (top > 0)
+	{
+		top--;
+		if (stackDistance[top] > closest) {
+			continue; //une figure plus proche a t trouve depuis
+		}
+		const Node& node = m_nodes[stack[top]];
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				int f = m_order[i];
+				if (f != ignore && intersectFigure(f, origin, dir, closest, distance))
+				{
+					closest = distance;
+					hit.figure = f;
+					if (anyHit) {
+						return true;
+					}
+				}
+			}
+			continue;
+		}
+
+		float leftDistance, rightDistance;
+		bool left = intersectNode(m_nodes[node.first], origin, inverseDirection, closest, leftDistance);
+		bool right = intersectNode(m_nodes[node.first + 1], origin, inverseDirection, closest, rightDistance);
+		if (left && right)
+		{
+			//le plus lointain d'abord sur la pile : le plus proche est dpil en premier
+			bool leftFirst = leftDistance <= rightDistance;
+			stack[top] = leftFirst ? node.first + 1 : node.first;
+			stackDistance[top++] = leftFirst ? rightDistance : leftDistance;
+			stack[top] = leftFirst ? node.first : node.first + 1;
+			stackDistance[top++] = leftFirst ? leftDistance : rightDistance;
+		}
+		else if (left || right)
+		{
+			stack[top] = left ? node.first : node.first + 1;
+			stackDistance[top++] = left ? leftDistance : rightDistance;
+		}
+	}
+
+	if (hit.figure < 0) {
+		return false;
+	}
+	hit.distance = closest;
+	hit.point = origin + closest * dir;
+	return true;
+}
+
+bool SceneBvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit, int ignore) const
+{
+	return traverse(origin, direction, maxDistance, ignore, false, hit);
+}
+
+bool SceneBvh::lineOfSight(const glm::vec3& from, const glm::vec3& to, int ignore) const
+{
+	RayHit hit;
+	return !traverse(from, to - from, glm::length(to - from), ignore, true, hit);
+}
+
+void screenRay(const glm::mat4& viewProjection, float x, float y, int width, int height, glm::vec3& origin, glm::vec3& direction)
+{
+	glm::mat4 inverse = glm::inverse(viewProjection);
+	float ndcX = 2.f * x / width - 1.f;
+	float ndcY = 1.f - 2.f * y / height;
+	glm::vec4 nearPoint = inverse * glm::vec4(ndcX, ndcY, -1.f, 1.f);
+	glm::vec4 farPoint = inverse * glm::vec4(ndcX, ndcY, 1.f, 1.f);
+	origin = glm::vec3(nearPoint) / nearPoint.w;
+	direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+}
+
+static float randomFloat(float low, float high)
+{
+	return low + (high - low) * rand() / (float)RAND_MAX;
+}
+
+static glm::vec3 randomDirection()
+{
+	glm::vec3 v;
+	do {
+		v = glm::vec3(randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f));
+	} while (glm::dot(v, v) > 1.f || glm::dot(v, v) < 1e-4f);
+	return glm::normalize(v);
+}
+
+void runPickBenchmark()
+{
+	const int sizes[2] = { 10000, 1000000 };
+	const int nbRays = 200000;
+	for (int s = 0; s < 2; s++)
+	{
+		//densit constante : un cube de ct 2 par figure, figures de 0.3  1.2 de ct orientes au hasard
+		int nbFigures = sizes[s];
+		float side = 2.f * cbrtf((float)nbFigures);
+		std::vector<PickFigure> figures(nbFigures);
+		for (int i = 0; i < nbFigures; i++)
+		{
+			glm::vec3 x = randomDirection();
+			glm::vec3 y = glm::normalize(glm::cross(x, randomDirection()));
+			glm::vec3 z = glm::cross(x, y);
+			glm::mat4& model = figures[i].model;
+			model = glm::mat4(1.f);
+			model[0] = glm::vec4(x * randomFloat(0.3f, 1.2f), 0.f);
+			model[1] = glm::vec4(y * randomFloat(0.3f, 1.2f), 0.f);
+			model[2] = glm::vec4(z * randomFloat(0.3f, 1.2f), 0.f);
+			model[3] = glm::vec4(randomFloat(0.f, side), randomFloat(0.f, side), randomFloat(0.f, side), 1.f);
+			figures[i].shape = (PickShape)(i % 3);
+		}
+
+		SceneBvh bvh;
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		bvh.build(figures);
+		double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+		//toutes les figures bougent un peu, comme les personnages d'une image  l'autre
+		for (int i = 0; i < nbFigures; i++) {
+			figures[i].model[3] += glm::vec4(randomDirection() * 0.05f, 0.f);
+		}
+		begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < nbFigures; i++) {
+			bvh.setFigure(i, figures[i].model);
+		}
+		bool rebuilt = bvh.refit();
+		double refitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+		std::vector<glm::vec3> origins(nbRays), directions(nbRays);
+		for (int r = 0; r < nbRays; r++)
+		{
+			origins[r] = glm::vec3(randomFloat(0.f, side), randomFloat(0.f, side), randomFloat(0.f, side));
+			directions[r] = randomDirection();
+		}
+		int nbHits = 0, nbVisible = 0;
+		begin = std::chrono::steady_clock::now();
+		for (int r = 0; r < nbRays; r++)
+		{
+			RayHit hit;
+			nbHits += bvh.raycast(origins[r], directions[r], side, hit) ? 1 : 0;
+		}
+		double rayMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		begin = std::chrono::steady_clock::now();
+		for (int r = 0; r < nbRays; r++) {
+			nbVisible += bvh.lineOfSight(origins[r], origins[r] + directions[r] * 4.f) ? 1 : 0;
+		}
+		double sightMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+		printf("%d figures, %d nodes : build %.1f ms, refit after moving every figure %.2f ms%s, raycast %.2f Mrays/s (%d%% hit), line of sight %.2f Mrays/s (%d%% clear)\n",
+			nbFigures, bvh.getNodeCount(), buildMs, refitMs, rebuilt ? " (rebuilt)" : "", nbRays / rayMs / 1000.0, 100 * nbHits / nbRays,
+			nbRays / sightMs / 1000.0, 100 * nbVisible / nbRays);
+	}
+}
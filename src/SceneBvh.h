@@ -0,0 +1,101 @@
+#ifndef SCENEBVH_H
+#define SCENEBVH_H
+
+//GML libraries
+#include <glm/glm.hpp>
+
+#include "stdint.h"
+#include "vector"
+
+#define BVH_BINS 16 //intervalles par axe de l'heuristique de surface (SAH)
+#define BVH_LEAF_SIZE 4 //figures par feuille au plus, sauf quand on ne peut plus les sparer
+#define BVH_MAX_DEPTH 48 //au-del, la feuille garde toutes ses figures : la pile du parcours ne dborde jamais
+#define BVH_TRAVERSAL_COST 1.f //cot d'un noeud travers, relatif au test d'une figure
+#define BVH_REBUILD_RATIO 1.5f //l'arbre est reconstruit quand les refit ont fait crotre son cot SAH de ce facteur
+
+//Forme de la figure dans son repre : toutes tiennent dans le cube [-0.5, 0.5], comme les maillages de la scne
+enum PickShape { PICK_BOX, PICK_SPHERE, PICK_CYLINDER }; //cylindre d'axe z
+
+struct PickFigure {
+	glm::mat4 model; //repre de la figure dans le monde, chelle comprise
+	PickShape shape;
+};
+
+struct RayHit {
+	int figure;
+	float distance; //depuis l'origine du rayon, dans le monde
+	glm::vec3 point;
+};
+
+//Hirarchie de botes englobantes (BVH) des figures, dans le monde, pour lancer des rayons sans tester toutes les figures.
+//Construite par l'heuristique de surface sur BVH_BINS intervalles, puis remise  jour  chaque image par refit : seules les feuilles
+//des figures qui ont boug et leurs anctres sont recalculs, la structure de l'arbre ne change pas. Quand les figures se sont tant
+//dplaces que l'arbre est devenu mauvais, il est reconstruit.
+//Les rayons sont tests contre la forme exacte de chaque figure, pas contre sa bote.
+class SceneBvh
+{
+public:
+	SceneBvh();
+
+	void build(const std::vector<PickFigure>& figures);
+	//nouvelle position d'une figure, prise en compte au prochain refit()
+	void setFigure(int figure, const glm::mat4& model);
+	//remet  jour les botes des figures dplaces, reconstruit l'arbre s'il est devenu trop coteux. Renvoie true en cas de reconstruction.
+	bool refit();
+
+	//figure la plus proche touche par le rayon avant maxDistance, en ignorant la figure ignore
+	bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit, int ignore = -1) const;
+	//true si aucune figure, sauf ignore, ne coupe le segment [from, to]
+	bool lineOfSight(const glm::vec3& from, const glm::vec3& to, int ignore = -1) const;
+
+	int getFigureCount() const { return (int)m_shapes.size(); }
+	int getNodeCount() const { return (int)m_nodes.size(); }
+	int getRebuilds() const { return m_rebuilds; }
+
+private:
+	//enfants contigus first et first + 1 si count == 0, sinon feuille des figures m_order[first..first + count)
+	struct Node {
+		glm::vec3 boxMin;
+		int first;
+		glm::vec3 boxMax;
+		int count;
+	};
+	//inverse du repre de la figure, sans sa dernire ligne (0, 0, 0, 1)
+	struct InverseModel {
+		glm::vec4 rows[3];
+	};
+
+	void buildTree();
+	void buildNode(int node, int first, int count, int depth);
+	void updateNodeBox(int node);
+	float treeCost() const;
+	bool intersectFigure(int figure, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) const;
+	//distance d'entre du rayon dans la bote du noeud, false s'il la manque avant maxDistance
+	static bool intersectNode(const Node& node, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance);
+	//la ligne de vise s'arrte  la premire figure trouve, pas forcment la plus proche
+	bool traverse(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, int ignore, bool anyHit, RayHit& hit) const;
+
+	std::vector<Node> m_nodes;
+	std::vector<int> m_parents; //parent de chaque noeud, -1 pour la racine
+	std::vector<int> m_order; //figures ranges feuille par feuille
+	std::vector<int> m_leafOf; //noeud feuille de chaque figure
+
+	std::vector<PickShape> m_shapes;
+	std::vector<InverseModel> m_inverses;
+	std::vector<glm::vec3> m_boxMin; //bote de chaque figure dans le monde
+	std::vector<glm::vec3> m_boxMax;
+
+	std::vector<int> m_dirty; //feuilles dont une figure a boug depuis le dernier refit
+	std::vector<uint8_t> m_dirtyFlags;
+	double m_weightedArea; //somme des aires pondres de tous les noeuds, tenue  jour par updateNodeBox()
+	float m_builtCost; //cot SAH juste aprs la dernire construction
+	int m_rebuilds;
+};
+
+//Rayon qui part de la camra et passe par le point (x, y) de l'image, en pixels depuis le coin haut gauche
+void screenRay(const glm::mat4& viewProjection, float x, float y, int width, int height, glm::vec3& origin, glm::vec3& direction);
+
+//Mesure la construction, le refit et le dbit de rayons sur 10 000 puis 1 000 000 de figures rparties au hasard
+void runPickBenchmark();
+
+#endif
@@ -0,0 +1,125 @@
+#include "ShaderVariants.h"
+
+#include "logger.h"
+
+#include "stdio.h"
+
+//contenu complet d'un fichier texte, false s'il ne peut pas tre ouvert
+static bool readFile(const char* path, std::string& content)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+	content.clear();
+	char buffer[4096];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		content.append(buffer, read);
+	}
+	fclose(file);
+	return true;
+}
+
+//insre defines juste aprs la ligne #version, qui doit rester la premire du shader
+static std::string specialize(const std::string& source, const std::string& defines)
+{
+	size_t version = source.find("#version");
+	size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+	if (lineEnd == std::string::npos) {
+		return defines + source;
+	}
+	return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+ShaderVariants::ShaderVariants(GpuResourceManager& resources) : m_resources(resources)
+{
+	for (int i = 0; i < NB_MATERIAL_VARIANTS; i++) {
+		m_failed[i] = false;
+	}
+}
+
+bool ShaderVariants::load(const char* vertPath, const char* fragPath, const char* label, const char* const* attributes, const char* const* blockNames)
+{
+	if (!readFile(vertPath, m_vertSource) || !readFile(fragPath, m_fragSource)) {
+		ERROR("Could not open the shader files %s and %s\n", vertPath, fragPath);
+		return false;
+	}
+	m_label = label;
+	m_attributes.clear();
+	for (int i = 0; attributes != NULL && attributes[i] != NULL; i++) {
+		m_attributes.push_back(attributes[i]);
+	}
+	m_blockNames.clear();
+	for (int i = 0; blockNames != NULL && blockNames[i] != NULL; i++) {
+		m_blockNames.push_back(blockNames[i]);
+	}
+	return true;
+}
+
+GLuint ShaderVariants::get(int features)
+{
+	features &= NB_MATERIAL_VARIANTS - 1;
+	if (m_programs[features].isValid() || m_failed[features]) {
+		return m_programs[features].get();
+	}
+
+	std::string defines;
+	std::string label = m_label;
+	const char* names[] = { "MATERIAL_TEXTURED", "MATERIAL_DIFFUSE", "MATERIAL_SPECULAR", "MATERIAL_EMISSIVE" };
+	const char* shortNames[] = { "textured", "diffuse", "specular", "emissive" };
+	for (int bit = 0; bit < 4; bit++)
+	{
+		if (features & (1 << bit))
+		{
+			defines += std::string("#define ") + names[bit] + "\n";
+			label += std::string(" ") + shortNames[bit];
+		}
+	}
+
+	Shader* shader = Shader::loadFromStrings(specialize(m_vertSource, defines), specialize(m_fragSource, defines));
+	if (shader == NULL)
+	{
+		ERROR("Could not compile the shader variant %s\n", label.c_str());
+		m_failed[features] = true;
+		return 0;
+	}
+
+	//les indices des attributs ne sont pris en compte qu' l'dition des liens : on relie le programme
+	GLuint program = shader->getProgramID();
+	for (size_t i = 0; i < m_attributes.size(); i++) {
+		glBindAttribLocation(program, (GLuint)i, m_attributes[i].c_str());
+	}
+	glLinkProgram(program);
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	m_programs[features] = m_resources.adoptProgram(shader, label.c_str());
+	if (!linked)
+	{
+		ERROR("Could not link the shader variant %s\n", label.c_str());
+		m_programs[features].reset();
+		m_failed[features] = true;
+		return 0;
+	}
+
+	for (size_t i = 0; i < m_blockNames.size(); i++)
+	{
+		GLuint block = glGetUniformBlockIndex(program, m_blockNames[i].c_str());
+		if (block != GL_INVALID_INDEX) {
+			glUniformBlockBinding(program, block, (GLuint)i);
+		}
+	}
+	return program;
+}
+
+GLint ShaderVariants::getAttribute(const char* name) const
+{
+	for (size_t i = 0; i < m_attributes.size(); i++)
+	{
+		if (m_attributes[i] == name) {
+			return (GLint)i;
+		}
+	}
+	return -1;
+}
+
@@ -0,0 +1,41 @@
+#ifndef SHADERVARIANTS_H
+#define SHADERVARIANTS_H
+
+//OpenGL Libraries
+#include <GL/glew.h>
+
+#include "GpuResources.h"
+#include "Material.h"
+
+#include "string"
+#include "vector"
+
+//Variantes d'une paire de shaders selon les bits de MaterialFeature. Chaque variante est compile  sa premire demande,
+//avec un bloc de #define (MATERIAL_TEXTURED, MATERIAL_DIFFUSE...) insr aprs la ligne #version des deux sources.
+//Les attributs reoivent les mmes indices dans toutes les variantes, pour qu'un VAO serve avec n'importe laquelle.
+class ShaderVariants
+{
+public:
+	ShaderVariants(GpuResourceManager& resources);
+
+	//lit les deux sources. attributes : noms des attributs, lis aux indices 0, 1, 2... dans cet ordre, termins par NULL.
+	//blockNames : blocs uniformes lis aux points 0, 1, 2... dans cet ordre, termins par NULL. Renvoie false si un fichier manque.
+	bool load(const char* vertPath, const char* fragPath, const char* label, const char* const* attributes, const char* const* blockNames);
+
+	//programme de la variante features, 0 si sa compilation a chou
+	GLuint get(int features);
+	//indice d'un attribut donn  load(), -1 s'il n'y est pas
+	GLint getAttribute(const char* name) const;
+
+private:
+	GpuResourceManager& m_resources;
+	std::string m_vertSource;
+	std::string m_fragSource;
+	std::string m_label;
+	std::vector<std::string> m_attributes;
+	std::vector<std::string> m_blockNames;
+	GpuProgram m_programs[NB_MATERIAL_VARIANTS];
+	bool m_failed[NB_MATERIAL_VARIANTS]; //pour ne pas recompiler  chaque image une variante qui choue
+};
+
+#endif
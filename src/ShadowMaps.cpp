@@ -0,0 +1,162 @@
+#include "ShadowMaps.h"
+
+#include "logger.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "stdio.h"
+#include "string.h"
+
+ShadowMaps::ShadowMaps(GpuResourceManager& resources) : m_resources(resources), m_previousFramebuffer(0), m_position(0.f, 0.f, 0.f), m_target(0.f, 0.f, 1.f),
+	m_nbStaticCasters(0), m_staticDirty(true), m_staticIncomplete(false), m_frames(0), m_staticRedraws(0), m_dynamicCasters(0)
+{
+	for (int i = 0; i < 4; i++) {
+		m_viewport[i] = 0;
+	}
+	m_viewProjection = glm::perspective(glm::radians(SHADOW_FOV), 1.f, SHADOW_NEAR, SHADOW_FAR) * glm::lookAt(m_position, m_target, glm::vec3(0.f, 1.f, 0.f));
+}
+
+ShadowMaps::~ShadowMaps()
+{
+	if (m_frames > 0) {
+		printf("Shadow maps : static map drawn %u times in %u frames, %.1f moving casters per frame\n", m_staticRedraws, m_frames, m_dynamicCasters / (double)m_frames);
+	}
+}
+
+bool ShadowMaps::init()
+{
+	if (!initTarget(m_staticDepth, m_staticFramebuffer, "static shadow map") || !initTarget(m_dynamicDepth, m_dynamicFramebuffer, "shadow map")) {
+		return false;
+	}
+
+	//la carte de l'image est lue par comparaison : chaque lecture filtre donne dj la part claire de 2 x 2 texels
+	glBindTexture(GL_TEXTURE_2D, m_dynamicDepth.get());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+bool ShadowMaps::initTarget(GpuTexture& depth, GpuFramebuffer& framebuffer, const char* label)
+{
+	depth = m_resources.createTexture2D(SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, NULL, label);
+	framebuffer = m_resources.createFramebuffer(label);
+	if (!depth.isValid() || !framebuffer.isValid()) {
+		return false;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, depth.get());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	//profondeur seule : pas d'attachement couleur
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.get());
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth.get(), 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		ERROR("The %s framebuffer is incomplete (0x%x)\n", label, status);
+		return false;
+	}
+	return true;
+}
+
+void ShadowMaps::setLight(const glm::vec3& position, const glm::vec3& target)
+{
+	if (position == m_position && target == m_target) {
+		return;
+	}
+	m_position = position;
+	m_target = target;
+	//la lumire regarde vers la table,  l'horizontale : l'axe vertical du monde convient toujours
+	m_viewProjection = glm::perspective(glm::radians(SHADOW_FOV), 1.f, SHADOW_NEAR, SHADOW_FAR) * glm::lookAt(position, target, glm::vec3(0.f, 1.f, 0.f));
+	m_staticDirty = true;
+}
+
+void ShadowMaps::beginStaticCasters()
+{
+	m_nbStaticCasters = 0;
+	m_staticIncomplete = false;
+}
+
+void ShadowMaps::addStaticCaster(int mesh, const glm::mat4& model)
+{
+	//les matrices des figures fixes sont recalcules  l'identique  chaque image : la comparaison peut tre exacte
+	if (m_nbStaticCasters < (int)m_staticCasters.size())
+	{
+		StaticCaster& cached = m_staticCasters[m_nbStaticCasters];
+		if (cached.mesh != mesh || memcmp(&cached.model, &model, sizeof(glm::mat4)) != 0)
+		{
+			cached.mesh = mesh;
+			cached.model = model;
+			m_staticDirty = true;
+		}
+	}
+	else
+	{
+		StaticCaster caster = { mesh, model };
+		m_staticCasters.push_back(caster);
+		m_staticDirty = true;
+	}
+	m_nbStaticCasters++;
+}
+
+void ShadowMaps::bindTarget(const GpuFramebuffer& framebuffer)
+{
+	glGetIntegerv(GL_VIEWPORT, m_viewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_previousFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.get());
+	glViewport(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+}
+
+void ShadowMaps::restoreTarget()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_previousFramebuffer);
+	glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+}
+
+bool ShadowMaps::beginStatic()
+{
+	//une figure fixe de moins qu' l'image prcdente change aussi la carte
+	if (m_nbStaticCasters != (int)m_staticCasters.size())
+	{
+		m_staticCasters.resize(m_nbStaticCasters);
+		m_staticDirty = true;
+	}
+	if (!m_staticDirty && !m_staticIncomplete) {
+		return false;
+	}
+	bindTarget(m_staticFramebuffer);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	return true;
+}
+
+void ShadowMaps::endStatic()
+{
+	restoreTarget();
+	m_staticDirty = m_staticIncomplete;
+	m_staticRedraws++;
+}
+
+//copie de profondeur  profondeur sur la carte graphique, bien moins chre que de redessiner les figures fixes
+void ShadowMaps::beginDynamic()
+{
+	bindTarget(m_dynamicFramebuffer);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_staticFramebuffer.get());
+	glBlitFramebuffer(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_dynamicFramebuffer.get());
+}
+
+void ShadowMaps::endDynamic(int nbCasters)
+{
+	restoreTarget();
+	m_frames++;
+	m_dynamicCasters += nbCasters;
+}
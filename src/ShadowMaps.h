@@ -0,0 +1,85 @@
+#ifndef SHADOWMAPS_H
+#define SHADOWMAPS_H
+
+//OpenGL Libraries
+#include <GL/glew.h>
+
+//GML libraries
+#include <glm/glm.hpp>
+
+#include "GpuResources.h"
+
+#include "stdint.h"
+#include "vector"
+
+#define SHADOW_MAP_SIZE 1024 //ct des deux cartes de profondeur
+#define SHADOW_FOV 50.f //ouverture de la projection de la lumire, en degrs : la table et les deux personnages vus depuis la lumire
+#define SHADOW_NEAR 0.5f
+#define SHADOW_FAR 20.f
+#define SHADOW_OFFSET_FACTOR 2.f //glPolygonOffset des passes d'ombre, contre l'acn des surfaces claires de biais
+#define SHADOW_OFFSET_UNITS 4.f
+
+//Cartes d'ombre d'une lumire ponctuelle, vue en perspective vers sa cible. Les figures qui ne bougent jamais (table, filet...)
+//sont dessines dans une carte fixe, garde d'une image  l'autre et redessine seulement quand la lumire ou l'une d'elles a boug.
+// chaque image, la carte fixe est copie dans la carte de l'image, o seules les figures mobiles sont ajoutes :
+//le cot par image suit la gomtrie qui bouge, pas la taille de la scne. color.frag lit la carte de l'image avec un filtre PCF.
+class ShadowMaps
+{
+public:
+	ShadowMaps(GpuResourceManager& resources);
+	~ShadowMaps();
+
+	bool init();
+
+	//position de la lumire et point vis, dans le monde. La carte fixe est  refaire si la projection change.
+	void setLight(const glm::vec3& position, const glm::vec3& target);
+	const glm::mat4& getViewProjection() const { return m_viewProjection; }
+
+	//Les figures fixes de l'image, dans le mme ordre  chaque image : toute diffrence avec la carte garde la fait redessiner
+	void beginStaticCasters();
+	void addStaticCaster(int mesh, const glm::mat4& model);
+	//une figure fixe n'a pas pu tre prpare : la carte dessine  cette image ne sera pas garde
+	void invalidateStatic() { m_staticIncomplete = true; }
+
+	//Les draw calls faits entre ces deux appels remplissent la carte fixe. Renvoie false si la carte garde est  jour : rien  dessiner.
+	bool beginStatic();
+	void endStatic();
+	//copie la carte fixe dans la carte de l'image, les draw calls qui suivent y ajoutent les figures mobiles
+	void beginDynamic();
+	void endDynamic(int nbCasters);
+
+	//carte de l'image, en comparaison de profondeur (sampler2DShadow)
+	GLuint getTexture() const { return m_dynamicDepth.get(); }
+
+private:
+	struct StaticCaster {
+		int mesh;
+		glm::mat4 model;
+	};
+
+	void bindTarget(const GpuFramebuffer& framebuffer);
+	void restoreTarget();
+	bool initTarget(GpuTexture& depth, GpuFramebuffer& framebuffer, const char* label);
+
+	GpuResourceManager& m_resources;
+	GpuTexture m_staticDepth;
+	GpuFramebuffer m_staticFramebuffer;
+	GpuTexture m_dynamicDepth;
+	GpuFramebuffer m_dynamicFramebuffer;
+	GLint m_viewport[4]; //viewport et framebuffer de l'image, rtablis aprs les passes d'ombre
+	GLint m_previousFramebuffer;
+
+	glm::vec3 m_position;
+	glm::vec3 m_target;
+	glm::mat4 m_viewProjection;
+	std::vector<StaticCaster> m_staticCasters; //figures de la carte fixe, compares  celles de l'image
+	int m_nbStaticCasters; //reues  cette image
+	bool m_staticDirty;
+	bool m_staticIncomplete;
+
+	uint32_t m_frames;
+	uint32_t m_staticRedraws;
+	uint64_t m_dynamicCasters;
+};
+
+#endif
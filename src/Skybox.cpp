@@ -0,0 +1,113 @@
+#include "Skybox.h"
+
+#include "algorithm"
+#include "math.h"
+
+//Direction du texel (sc, tc) de la face face, sc et tc entre -1 et 1 (table 8.19 de la spcification OpenGL,  l'envers)
+static glm::vec3 faceDirection(int face, float sc, float tc)
+{
+	switch (face)
+	{
+	case 0: return glm::vec3(1.f, -tc, -sc);
+	case 1: return glm::vec3(-1.f, -tc, sc);
+	case 2: return glm::vec3(sc, 1.f, tc);
+	case 3: return glm::vec3(sc, -1.f, -tc);
+	case 4: return glm::vec3(sc, -tc, 1.f);
+	default: return glm::vec3(-sc, -tc, -1.f);
+	}
+}
+
+//chantillonnage bilinaire du panorama : la longitude boucle, la latitude est borne aux ples
+static void samplePanorama(const uint8_t* pixels, int width, int height, const glm::vec3& d, uint8_t* out)
+{
+	float longitude = atan2f(d.x, d.z);
+	float latitude = atan2f(d.y, sqrtf(d.x * d.x + d.z * d.z));
+	float fx = (0.5f + longitude / (2.f * (float)M_PI)) * width - 0.5f;
+	float fy = (0.5f - latitude / (float)M_PI) * height - 0.5f;
+	fy = std::min(std::max(fy, 0.f), (float)(height - 1));
+	float floorX = floorf(fx);
+	int y0 = (int)fy;
+	int y1 = std::min(y0 + 1, height - 1);
+	float ax = fx - floorX;
+	float ay = fy - y0;
+	int x0 = ((int)floorX % width + width) % width;
+	int x1 = (x0 + 1) % width;
+
+	const uint8_t* p00 = &pixels[4 * (y0 * width + x0)];
+	const uint8_t* p10 = &pixels[4 * (y0 * width + x1)];
+	const uint8_t* p01 = &pixels[4 * (y1 * width + x0)];
+	const uint8_t* p11 = &pixels[4 * (y1 * width + x1)];
+	for (int c = 0; c < 3; c++)
+	{
+		float top = p00[c] + (p10[c] - p00[c]) * ax;
+		float bottom = p01[c] + (p11[c] - p01[c]) * ax;
+		out[c] = (uint8_t)(top + (bottom - top) * ay + 0.5f);
+	}
+	out[3] = 255;
+}
+
+void equirectangularToCubeMap(const uint8_t* pixels, int width, int height, int size, CubeMap& cubeMap)
+{
+	cubeMap.size = size;
+	for (int face = 0; face < 6; face++)
+	{
+		std::vector<uint8_t>& target = cubeMap.faces[face];
+		target.resize(4 * size * size);
+		for (int y = 0; y < size; y++)
+		{
+			float tc = 2.f * (y + 0.5f) / size - 1.f;
+			for (int x = 0; x < size; x++)
+			{
+				float sc = 2.f * (x + 0.5f) / size - 1.f;
+				samplePanorama(pixels, width, height, faceDirection(face, sc, tc), &target[4 * (y * size + x)]);
+			}
+		}
+	}
+}
+
+glm::vec3 sampleCubeMap(const CubeMap& cubeMap, const glm::vec3& d)
+{
+	//face de l'axe dominant, puis coordonnes dans la face comme la carte graphique
+	float ax = fabsf(d.x), ay = fabsf(d.y), az = fabsf(d.z);
+	int face;
+	float sc, tc, ma;
+	if (ax >= ay && ax >= az) {
+		face = d.x > 0.f ? 0 : 1;
+		sc = d.x > 0.f ? -d.z : d.z;
+		tc = -d.y;
+		ma = ax;
+	}
+	else if (ay >= az) {
+		face = d.y > 0.f ? 2 : 3;
+		sc = d.x;
+		tc = d.y > 0.f ? d.z : -d.z;
+		ma = ay;
+	}
+	else {
+		face = d.z > 0.f ? 4 : 5;
+		sc = d.z > 0.f ? d.x : -d.x;
+		tc = -d.y;
+		ma = az;
+	}
+
+	int size = cubeMap.size;
+	float fx = std::min(std::max((sc / ma + 1.f) * 0.5f * size - 0.5f, 0.f), (float)(size - 1));
+	float fy = std::min(std::max((tc / ma + 1.f) * 0.5f * size - 0.5f, 0.f), (float)(size - 1));
+	int x0 = (int)fx, y0 = (int)fy;
+	int x1 = std::min(x0 + 1, size - 1), y1 = std::min(y0 + 1, size - 1);
+	float wx = fx - x0, wy = fy - y0;
+
+	const std::vector<uint8_t>& pixels = cubeMap.faces[face];
+	const uint8_t* p00 = &pixels[4 * (y0 * size + x0)];
+	const uint8_t* p10 = &pixels[4 * (y0 * size + x1)];
+	const uint8_t* p01 = &pixels[4 * (y1 * size + x0)];
+	const uint8_t* p11 = &pixels[4 * (y1 * size + x1)];
+	glm::vec3 color;
+	for (int c = 0; c < 3; c++)
+	{
+		float top = p00[c] + (p10[c] - p00[c]) * wx;
+		float bottom = p01[c] + (p11[c] - p01[c]) * wx;
+		color[c] = (top + (bottom - top) * wy) / 255.f;
+	}
+	return color;
+}
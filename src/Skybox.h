@@ -0,0 +1,26 @@
+#ifndef SKYBOX_H
+#define SKYBOX_H
+
+//GML libraries
+#include <glm/glm.hpp>
+
+#include "stdint.h"
+#include "vector"
+
+#define SKYBOX_FACE_SIZE 512 //ct des faces de la cube map, en pixels
+
+//Cube map RGBA8 sur le processeur. Les faces sont dans l'ordre de GL_TEXTURE_CUBE_MAP_POSITIVE_X + i (+X, -X, +Y, -Y, +Z, -Z),
+//avec l'orientation des coordonnes (s, t) de la spcification OpenGL, pour tre envoyes telles quelles avec glTexImage2D.
+struct CubeMap {
+	int size;
+	std::vector<uint8_t> faces[6];
+};
+
+//Convertit un panorama quirectangulaire (longitude en largeur, latitude en hauteur, premire ligne en haut) en cube map de size pixels de ct.
+//Le centre du panorama est dans la direction +z, celle o regarde la camra au dpart.
+void equirectangularToCubeMap(const uint8_t* pixels, int width, int height, int size, CubeMap& cubeMap);
+
+//Couleur RGB entre 0 et 1 de la cube map dans la direction direction (non nulle, pas forcment normalise), filtrage bilinaire dans la face
+glm::vec3 sampleCubeMap(const CubeMap& cubeMap, const glm::vec3& direction);
+
+#endif
@@ -0,0 +1,796 @@
+#include "SoftwareBackend.h"
+#include "FrameCapture.h"
+#include "FramePacer.h"
+
+#include "algorithm"
+#include "math.h"
+#include "string.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOFTWARE_SIMD
+#endif
+
+//chantillonnage bilinaire en GL_REPEAT, comme la texture cre par le backend OpenGL
+static glm::vec3 sampleTexture(const std::vector<uint8_t>& pixels, int width, int height, float u, float v)
+{
+	float fx = u * width - 0.5f;
+	float fy = v * height - 0.5f;
+	float floorX = floorf(fx);
+	float floorY = floorf(fy);
+	float ax = fx - floorX;
+	float ay = fy - floorY;
+
+	int x0 = ((int)floorX % width + width) % width;
+	int y0 = ((int)floorY % height + height) % height;
+	int x1 = (x0 + 1) % width;
+	int y1 = (y0 + 1) % height;
+
+	const uint8_t* p00 = &pixels[4 * (y0 * width + x0)];
+	const uint8_t* p10 = &pixels[4 * (y0 * width + x1)];
+	const uint8_t* p01 = &pixels[4 * (y1 * width + x0)];
+	const uint8_t* p11 = &pixels[4 * (y1 * width + x1)];
+
+	glm::vec3 color;
+	for (int c = 0; c < 3; c++)
+	{
+		float top = p00[c] + (p10[c] - p00[c]) * ax;
+		float bottom = p01[c] + (p11[c] - p01[c]) * ax;
+		color[c] = (top + (bottom - top) * ay) / 255.f;
+	}
+	return color;
+}
+
+SoftwareBackend::SoftwareBackend(SDL_Window* window, int width, int height, int nbThreads) :
+	m_window(window), m_width(width), m_height(height), m_renderScale(1.f), m_nextRenderScale(1.f), m_renderWidth(width), m_renderHeight(height),
+	m_renderTime(-1.f), m_skybox(-1), m_binStart(NULL), m_binRefs(NULL), m_splatStart(NULL), m_splatRefs(NULL), m_upscaledImage(NULL), m_capture(NULL), m_pacer(NULL), m_task(NULL), m_taskCount(0), m_next(0), m_workersDone(0), m_generation(0), m_stop(false)
+{
+	m_tilesX = (width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+	m_tilesY = (height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+	m_color.resize(4 * width * height);
+	m_image = SDL_CreateRGBSurfaceWithFormatFrom(&m_color[0], width, height, 32, 4 * width, SDL_PIXELFORMAT_RGBA32);
+	m_sharpened.resize(4 * width * height);
+	m_upscaled.resize(4 * width * height);
+	m_upscaledImage = SDL_CreateRGBSurfaceWithFormatFrom(&m_upscaled[0], width, height, 32, 4 * width, SDL_PIXELFORMAT_RGBA32);
+	m_sourceColumns.resize(width);
+	m_sourceWeights.resize(width);
+
+	if (nbThreads <= 0) {
+		nbThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	//le thread principal travaille aussi
+	for (int i = 1; i < nbThreads; i++) {
+		m_workers.push_back(std::thread(&SoftwareBackend::workerLoop, this));
+	}
+}
+
+SoftwareBackend::~SoftwareBackend()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++) {
+		m_workers[i].join();
+	}
+	if (m_image != NULL) {
+		SDL_FreeSurface(m_image);
+	}
+	if (m_upscaledImage != NULL) {
+		SDL_FreeSurface(m_upscaledImage);
+	}
+}
+
+int SoftwareBackend::createMesh(const float* positions, const float* normals, const float* uvs, int nbVertices)
+{
+	Mesh mesh;
+	mesh.positions.assign(positions, positions + 3 * nbVertices);
+	mesh.normals.assign(normals, normals + 3 * nbVertices);
+	mesh.uvs.assign(uvs, uvs + 2 * nbVertices);
+	mesh.nbVertices = nbVertices;
+	m_meshes.push_back(mesh);
+	return (int)m_meshes.size() - 1;
+}
+
+int SoftwareBackend::createTexture(const uint8_t* pixels, int width, int height)
+{
+	Texture texture;
+	texture.pixels.assign(pixels, pixels + 4 * width * height);
+	texture.width = width;
+	texture.height = height;
+	m_textures.push_back(texture);
+	return (int)m_textures.size() - 1;
+}
+
+int SoftwareBackend::createSkybox(const uint8_t* pixels, int width, int height)
+{
+	m_skyboxes.push_back(CubeMap());
+	equirectangularToCubeMap(pixels, width, height, SKYBOX_FACE_SIZE, m_skyboxes.back());
+	return (int)m_skyboxes.size() - 1;
+}
+
+void SoftwareBackend::setRenderScale(float scale)
+{
+	m_nextRenderScale = std::min(1.f, std::max(0.1f, scale));
+}
+
+void SoftwareBackend::beginFrame()
+{
+	//la taille rendue ne change qu'entre deux images, drawParticles() s'en sert dj
+	m_renderScale = m_nextRenderScale;
+	m_renderWidth = std::max(1, (int)(m_width * m_renderScale + 0.5f));
+	m_renderHeight = std::max(1, (int)(m_height * m_renderScale + 0.5f));
+	m_tilesX = (m_renderWidth + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+	m_tilesY = (m_renderHeight + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+
+	m_commands.clear();
+	m_skybox = -1;
+	m_splats.clear();
+	m_arena.reset();
+}
+
+void SoftwareBackend::draw(int mesh, int texture, const glm::mat4& mvp, const Material& material, const Light& light)
+{
+	DrawCommand command;
+	command.mesh = mesh;
+	command.texture = texture;
+	command.mvp = mvp;
+	command.material = material;
+	command.light = light;
+	command.features = material.getFeatures();
+	if (texture < 0) {
+		command.features &= ~MATERIAL_TEXTURED;
+	}
+	m_commands.push_back(command);
+}
+
+void SoftwareBackend::drawSkybox(int skybox, const glm::mat4& viewProjection)
+{
+	m_skybox = skybox;
+	m_skyInverse = glm::inverse(viewProjection);
+}
+
+//quivalent de particle.vert : les particules sont projetes ds l'appel, puis rparties dans les tuiles par endFrame()
+void SoftwareBackend::drawParticles(const ParticleBatch& batch)
+{
+	const glm::mat4& m = batch.viewProjection;
+	for (int i = 0; i < batch.count; i++)
+	{
+		float x = batch.x[i], y = batch.y[i], z = batch.z[i];
+		float w = m[0][3] * x + m[1][3] * y + m[2][3] * z + m[3][3];
+		if (w <= 1e-4f) {
+			continue; //derrire la camra
+		}
+		float invW = 1.f / w;
+		Splat splat;
+		splat.x = ((m[0][0] * x + m[1][0] * y + m[2][0] * z + m[3][0]) * invW * 0.5f + 0.5f) * m_renderWidth;
+		splat.y = (0.5f - (m[0][1] * x + m[1][1] * y + m[2][1] * z + m[3][1]) * invW * 0.5f) * m_renderHeight;
+		splat.z = (m[0][2] * x + m[1][2] * y + m[2][2] * z + m[3][2]) * invW * 0.5f + 0.5f;
+		splat.radius = 0.5f * std::max(batch.size * m_renderScale * (0.5f + 0.5f * batch.life[i]) * invW, 1.f);
+		if (splat.z < 0.f || splat.z > 1.f || splat.x + splat.radius < 0.f || splat.y + splat.radius < 0.f
+			|| splat.x - splat.radius >= m_renderWidth || splat.y - splat.radius >= m_renderHeight) {
+			continue;
+		}
+		uint32_t rgba = batch.colors[i];
+		float alpha = (rgba >> 24) / 255.f * batch.life[i];
+		for (int c = 0; c < 3; c++) {
+			splat.color[c] = ((rgba >> (8 * c)) & 0xFF) * alpha;
+		}
+
+		m_splats.push_back(splat);
+	}
+}
+
+//Comptage des particules de chaque tuile, puis remplissage : deux passes, mais aucun tableau qui grandit
+void SoftwareBackend::binSplats()
+{
+	int nbTiles = m_tilesX * m_tilesY;
+	m_splatStart = m_arena.allocateArray<int>(nbTiles + 1);
+	std::fill(m_splatStart, m_splatStart + nbTiles + 1, 0);
+	int* cursor = NULL;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		if (pass == 1)
+		{
+			for (int t = 0; t < nbTiles; t++) {
+				m_splatStart[t + 1] += m_splatStart[t];
+			}
+			m_splatRefs = m_arena.allocateArray<int>(m_splatStart[nbTiles]);
+			cursor = m_arena.allocateArray<int>(nbTiles);
+			std::copy(m_splatStart, m_splatStart + nbTiles, cursor);
+		}
+		for (int i = 0; i < (int)m_splats.size(); i++)
+		{
+			const Splat& splat = m_splats[i];
+			int tx0 = std::max(0, (int)(splat.x - splat.radius) / SOFTWARE_TILE_SIZE);
+			int ty0 = std::max(0, (int)(splat.y - splat.radius) / SOFTWARE_TILE_SIZE);
+			int tx1 = std::min(m_tilesX - 1, (int)(splat.x + splat.radius) / SOFTWARE_TILE_SIZE);
+			int ty1 = std::min(m_tilesY - 1, (int)(splat.y + splat.radius) / SOFTWARE_TILE_SIZE);
+			for (int ty = ty0; ty <= ty1; ty++)
+			{
+				for (int tx = tx0; tx <= tx1; tx++)
+				{
+					int tile = ty * m_tilesX + tx;
+					if (pass == 0) {
+						m_splatStart[tile + 1]++;
+					}
+					else {
+						m_splatRefs[cursor[tile]++] = i;
+					}
+				}
+			}
+		}
+	}
+}
+
+void SoftwareBackend::endFrame()
+{
+	Uint64 counterBegin = SDL_GetPerformanceCounter();
+	int nbCommands = (int)m_commands.size();
+	if (m_triangles.size() < m_commands.size()) {
+		m_triangles.resize(nbCommands);
+	}
+
+	//1 : vertex shader et dcoupage, une tche par draw()
+	runParallel(nbCommands, &SoftwareBackend::setupCommand);
+
+	//2 : rpartition des triangles dans les tuiles, en gardant l'ordre des draw(). On compte d'abord les triangles de chaque tuile,
+	//pour que les listes soient ranges  la suite dans la mmoire de l'image.
+	int nbTiles = m_tilesX * m_tilesY;
+	m_binStart = m_arena.allocateArray<int>(nbTiles + 1);
+	std::fill(m_binStart, m_binStart + nbTiles + 1, 0);
+	int* cursor = NULL;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		if (pass == 1)
+		{
+			for (int t = 0; t < nbTiles; t++) {
+				m_binStart[t + 1] += m_binStart[t];
+			}
+			m_binRefs = m_arena.allocateArray<TriangleRef>(m_binStart[nbTiles]);
+			cursor = m_arena.allocateArray<int>(nbTiles);
+			std::copy(m_binStart, m_binStart + nbTiles, cursor);
+		}
+		for (int c = 0; c < nbCommands; c++)
+		{
+			const std::vector<Triangle>& triangles = m_triangles[c];
+			for (int t = 0; t < (int)triangles.size(); t++)
+			{
+				const Triangle& tri = triangles[t];
+				TriangleRef ref = { c, t };
+				for (int ty = tri.minY / SOFTWARE_TILE_SIZE; ty <= tri.maxY / SOFTWARE_TILE_SIZE; ty++)
+				{
+					for (int tx = tri.minX / SOFTWARE_TILE_SIZE; tx <= tri.maxX / SOFTWARE_TILE_SIZE; tx++)
+					{
+						int tile = ty * m_tilesX + tx;
+						if (pass == 0) {
+							m_binStart[tile + 1]++;
+						}
+						else {
+							m_binRefs[cursor[tile]++] = ref;
+						}
+					}
+				}
+			}
+		}
+	}
+	binSplats();
+
+	//3 : rastrisation, une tche par tuile
+	runParallel(m_tilesX * m_tilesY, &SoftwareBackend::rasterTile);
+
+	//4 : agrandissement de la zone rendue  la taille de la fentre
+	SDL_Surface* image = m_image;
+	if (m_renderWidth < m_width || m_renderHeight < m_height)
+	{
+		for (int x = 0; x < m_width; x++)
+		{
+			float source = std::min(std::max((x + 0.5f) * m_renderWidth / m_width - 0.5f, 0.f), (float)(m_renderWidth - 1));
+			m_sourceColumns[x] = (int)source;
+			m_sourceWeights[x] = source - m_sourceColumns[x];
+		}
+		int nbBlocks = (std::max(m_renderHeight, m_height) + SOFTWARE_UPSCALE_ROWS - 1) / SOFTWARE_UPSCALE_ROWS;
+		runParallel(nbBlocks, &SoftwareBackend::sharpenRows);
+		runParallel(nbBlocks, &SoftwareBackend::upscaleRows);
+		image = m_upscaledImage;
+	}
+
+	//l'image est dj en mmoire, une copie suffit
+	if (m_capture != NULL)
+	{
+		uint8_t* pixels = m_capture->acquireFrame();
+		memcpy(pixels, getColorBuffer(), m_color.size());
+		m_capture->submitFrame(pixels, false);
+	}
+
+	m_renderTime = (float)((SDL_GetPerformanceCounter() - counterBegin) * 1000.0 / SDL_GetPerformanceFrequency()); //sans l'attente de l'chance d'affichage
+	SDL_Surface* surface = SDL_GetWindowSurface(m_window);
+	if (surface != NULL && image != NULL)
+	{
+		SDL_BlitSurface(image, NULL, surface, NULL);
+		if (m_pacer != NULL) {
+			m_pacer->waitForDeadline();
+		}
+		SDL_UpdateWindowSurface(m_window);
+		if (m_pacer != NULL) {
+			m_pacer->framePresented();
+		}
+	}
+}
+
+//masque flou : c + k * (4c - voisins), les voisins tant pris dans la zone rendue
+void SoftwareBackend::sharpenRows(int block)
+{
+	int endY = std::min((block + 1) * SOFTWARE_UPSCALE_ROWS, m_renderHeight);
+	for (int y = block * SOFTWARE_UPSCALE_ROWS; y < endY; y++)
+	{
+		const uint8_t* row = &m_color[4 * y * m_width];
+		const uint8_t* up = &m_color[4 * std::max(y - 1, 0) * m_width];
+		const uint8_t* down = &m_color[4 * std::min(y + 1, m_renderHeight - 1) * m_width];
+		uint8_t* target = &m_sharpened[4 * y * m_width];
+		for (int x = 0; x < m_renderWidth; x++)
+		{
+			int left = 4 * std::max(x - 1, 0);
+			int right = 4 * std::min(x + 1, m_renderWidth - 1);
+			for (int c = 0; c < 3; c++)
+			{
+				float center = row[4 * x + c];
+				float value = center + UPSCALE_SHARPNESS * (4.f * center - row[left + c] - row[right + c] - up[4 * x + c] - down[4 * x + c]);
+				target[4 * x + c] = (uint8_t)std::min(255.f, std::max(0.f, value + 0.5f));
+			}
+			target[4 * x + 3] = 255;
+		}
+	}
+}
+
+void SoftwareBackend::upscaleRows(int block)
+{
+	int endY = std::min((block + 1) * SOFTWARE_UPSCALE_ROWS, m_height);
+	for (int y = block * SOFTWARE_UPSCALE_ROWS; y < endY; y++)
+	{
+		float sourceY = std::min(std::max((y + 0.5f) * m_renderHeight / m_height - 0.5f, 0.f), (float)(m_renderHeight - 1));
+		int y0 = (int)sourceY;
+		int y1 = std::min(y0 + 1, m_renderHeight - 1);
+		float wy = sourceY - y0;
+		const uint8_t* row0 = &m_sharpened[4 * y0 * m_width];
+		const uint8_t* row1 = &m_sharpened[4 * y1 * m_width];
+		uint8_t* target = &m_upscaled[4 * y * m_width];
+		for (int x = 0; x < m_width; x++)
+		{
+			int x0 = 4 * m_sourceColumns[x];
+			int x1 = std::min(m_sourceColumns[x] + 1, m_renderWidth - 1) * 4;
+			float wx = m_sourceWeights[x];
+			for (int c = 0; c < 3; c++)
+			{
+				float top = row0[x0 + c] + (row0[x1 + c] - row0[x0 + c]) * wx;
+				float bottom = row1[x0 + c] + (row1[x1 + c] - row1[x0 + c]) * wx;
+				target[4 * x + c] = (uint8_t)(top + (bottom - top) * wy + 0.5f);
+			}
+			target[4 * x + 3] = 255;
+		}
+	}
+}
+
+void SoftwareBackend::printMemoryReport(const char* title) const
+{
+	size_t meshBytes = 0, textureBytes = 0;
+	for (size_t i = 0; i < m_meshes.size(); i++) {
+		meshBytes += (m_meshes[i].positions.size() + m_meshes[i].normals.size() + m_meshes[i].uvs.size()) * sizeof(float);
+	}
+	for (size_t i = 0; i < m_textures.size(); i++) {
+		textureBytes += m_textures[i].pixels.size();
+	}
+	for (size_t i = 0; i < m_skyboxes.size(); i++) {
+		textureBytes += 6 * m_skyboxes[i].faces[0].size();
+	}
+	printf("Software renderer memory (%s) : %u meshes %.2f MB, %u textures %.2f MB, color buffer %.2f MB, frame arena %.2f MB (peak %.2f MB)\n", title,
+		(unsigned)m_meshes.size(), meshBytes / (1024.0 * 1024.0), (unsigned)m_textures.size(), textureBytes / (1024.0 * 1024.0), m_color.size() / (1024.0 * 1024.0),
+		m_arena.getCapacity() / (1024.0 * 1024.0), m_arena.getPeak() / (1024.0 * 1024.0));
+}
+
+//quivalent de color.vert pour tous les sommets d'un draw(), puis dcoupage par le plan near
+void SoftwareBackend::setupCommand(int c)
+{
+	const DrawCommand& command = m_commands[c];
+	const Mesh& mesh = m_meshes[command.mesh];
+	std::vector<Triangle>& triangles = m_triangles[c];
+	triangles.clear();
+
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(command.mvp)));
+
+	for (int v = 0; v + 2 < mesh.nbVertices; v += 3)
+	{
+		ClipVertex in[3];
+		for (int k = 0; k < 3; k++)
+		{
+			const float* p = &mesh.positions[3 * (v + k)];
+			const float* n = &mesh.normals[3 * (v + k)];
+			const float* uv = &mesh.uvs[2 * (v + k)];
+
+			glm::vec4 position = command.mvp * glm::vec4(p[0], p[1], p[2], 1.0f);
+			glm::vec3 normal = glm::normalize(normalMatrix * glm::vec3(n[0], n[1], n[2]));
+			float w = fabsf(position.w) > 1e-12f ? position.w : 1e-12f;
+
+			in[k].position = position;
+			in[k].varyings[0] = normal.x;
+			in[k].varyings[1] = normal.y;
+			in[k].varyings[2] = normal.z;
+			in[k].varyings[3] = position.x / w;
+			in[k].varyings[4] = position.y / w;
+			in[k].varyings[5] = position.z / w;
+			in[k].varyings[6] = -uv[0] + 1.0f;
+			in[k].varyings[7] = -uv[1];
+		}
+
+		//rejet des triangles entirement hors d'un des plans de dcoupage
+		bool outside = false;
+		for (int axis = 0; axis < 3 && !outside; axis++)
+		{
+			bool allBelow = true, allAbove = true;
+			for (int k = 0; k < 3; k++)
+			{
+				allBelow = allBelow && in[k].position[axis] < -in[k].position.w;
+				allAbove = allAbove && in[k].position[axis] > in[k].position.w;
+			}
+			outside = allBelow || allAbove;
+		}
+		if (outside) {
+			continue;
+		}
+
+		//dcoupage par le plan near (z >= -w), le seul ncessaire pour que la division par w soit valide. Le far est trait par pixel.
+		float d[3];
+		int nbInside = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			d[k] = in[k].position.z + in[k].position.w;
+			nbInside += d[k] >= 0.f;
+		}
+		if (nbInside == 3) {
+			addTriangle(triangles, in[0], in[1], in[2]);
+			continue;
+		}
+		if (nbInside == 0) {
+			continue;
+		}
+
+		ClipVertex polygon[4];
+		int nbPolygon = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			int next = (k + 1) % 3;
+			if (d[k] >= 0.f) {
+				polygon[nbPolygon++] = in[k];
+			}
+			if ((d[k] >= 0.f) != (d[next] >= 0.f))
+			{
+				float t = d[k] / (d[k] - d[next]);
+				ClipVertex& out = polygon[nbPolygon++];
+				out.position = in[k].position + (in[next].position - in[k].position) * t;
+				for (int i = 0; i < SOFTWARE_VARYINGS; i++) {
+					out.varyings[i] = in[k].varyings[i] + (in[next].varyings[i] - in[k].varyings[i]) * t;
+				}
+			}
+		}
+		for (int k = 1; k + 1 < nbPolygon; k++) {
+			addTriangle(triangles, polygon[0], polygon[k], polygon[k + 1]);
+		}
+	}
+}
+
+void SoftwareBackend::addTriangle(std::vector<Triangle>& triangles, const ClipVertex& a, const ClipVertex& b, const ClipVertex& c)
+{
+	const ClipVertex* v[3] = { &a, &b, &c };
+	Triangle tri;
+	for (int k = 0; k < 3; k++)
+	{
+		float invW = 1.0f / v[k]->position.w;
+		tri.x[k] = (v[k]->position.x * invW * 0.5f + 0.5f) * m_renderWidth;
+		tri.y[k] = (0.5f - v[k]->position.y * invW * 0.5f) * m_renderHeight; //premire ligne en haut
+		tri.z[k] = v[k]->position.z * invW * 0.5f + 0.5f;
+		tri.invW[k] = invW;
+		for (int i = 0; i < SOFTWARE_VARYINGS; i++) {
+			tri.varyings[k][i] = v[k]->varyings[i] * invW;
+		}
+	}
+
+	//pas de face culling dans le rendu OpenGL : on remet les triangles dans le mme sens
+	tri.area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.y[1] - tri.y[0]) * (tri.x[2] - tri.x[0]);
+	if (fabsf(tri.area) < 1e-8f) {
+		return;
+	}
+	if (tri.area < 0.f)
+	{
+		std::swap(tri.x[1], tri.x[2]);
+		std::swap(tri.y[1], tri.y[2]);
+		std::swap(tri.z[1], tri.z[2]);
+		std::swap(tri.invW[1], tri.invW[2]);
+		for (int i = 0; i < SOFTWARE_VARYINGS; i++) {
+			std::swap(tri.varyings[1][i], tri.varyings[2][i]);
+		}
+		tri.area = -tri.area;
+	}
+
+	tri.minX = std::max(0, (int)floorf(std::min(tri.x[0], std::min(tri.x[1], tri.x[2]))));
+	tri.minY = std::max(0, (int)floorf(std::min(tri.y[0], std::min(tri.y[1], tri.y[2]))));
+	tri.maxX = std::min(m_renderWidth - 1, (int)ceilf(std::max(tri.x[0], std::max(tri.x[1], tri.x[2]))));
+	tri.maxY = std::min(m_renderHeight - 1, (int)ceilf(std::max(tri.y[0], std::max(tri.y[1], tri.y[2]))));
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY) {
+		return;
+	}
+	triangles.push_back(tri);
+}
+
+void SoftwareBackend::rasterTile(int tile)
+{
+	int tileX = (tile % m_tilesX) * SOFTWARE_TILE_SIZE;
+	int tileY = (tile / m_tilesX) * SOFTWARE_TILE_SIZE;
+
+	//depth buffer de la tuile, avec une marge pour les lectures SIMD en fin de ligne
+	float depth[SOFTWARE_TILE_SIZE * SOFTWARE_TILE_SIZE + 4];
+	std::fill(depth, depth + SOFTWARE_TILE_SIZE * SOFTWARE_TILE_SIZE + 4, 1.0f);
+
+	int endX = std::min(tileX + SOFTWARE_TILE_SIZE, m_renderWidth);
+	int endY = std::min(tileY + SOFTWARE_TILE_SIZE, m_renderHeight);
+	for (int y = tileY; y < endY; y++)
+	{
+		uint8_t* row = &m_color[4 * (y * m_width + tileX)];
+		for (int x = 0; x < endX - tileX; x++)
+		{
+			row[4 * x] = row[4 * x + 1] = row[4 * x + 2] = 0;
+			row[4 * x + 3] = 255;
+		}
+	}
+
+	for (int i = m_binStart[tile]; i < m_binStart[tile + 1]; i++)
+	{
+		const TriangleRef& ref = m_binRefs[i];
+		rasterTriangle(m_triangles[ref.command][ref.triangle], m_commands[ref.command], tileX, tileY, depth);
+	}
+
+	//le fond puis les particules par-dessus les figures, comme dans presentFrame() du rendu OpenGL
+	if (m_skybox >= 0) {
+		rasterSky(tileX, tileY, depth);
+	}
+	for (int i = m_splatStart[tile]; i < m_splatStart[tile + 1]; i++) {
+		rasterSplat(m_splats[m_splatRefs[i]], tileX, tileY, depth);
+	}
+}
+
+void SoftwareBackend::rasterSky(int tileX, int tileY, const float* depth)
+{
+	const CubeMap& cubeMap = m_skyboxes[m_skybox];
+	int endX = std::min(tileX + SOFTWARE_TILE_SIZE, m_renderWidth);
+	int endY = std::min(tileY + SOFTWARE_TILE_SIZE, m_renderHeight);
+	//point du plan far sous le pixel, linaire en coordonnes normalises comme varyDirection dans skybox.vert
+	glm::vec4 stepX = m_skyInverse[0] * (2.f / m_renderWidth);
+	for (int y = tileY; y < endY; y++)
+	{
+		const float* depthRow = &depth[(y - tileY) * SOFTWARE_TILE_SIZE];
+		uint8_t* colorRow = &m_color[4 * y * m_width];
+		glm::vec4 farPoint = m_skyInverse * glm::vec4(2.f * (tileX + 0.5f) / m_renderWidth - 1.f, 1.f - 2.f * (y + 0.5f) / m_renderHeight, 1.f, 1.f);
+		for (int x = tileX; x < endX; x++, farPoint += stepX)
+		{
+			if (depthRow[x - tileX] < 1.f) {
+				continue;
+			}
+			glm::vec3 color = sampleCubeMap(cubeMap, glm::vec3(farPoint) / farPoint.w);
+			uint8_t* pixel = &colorRow[4 * x];
+			for (int c = 0; c < 3; c++) {
+				pixel[c] = (uint8_t)(std::min(color[c], 1.f) * 255.f + 0.5f);
+			}
+		}
+	}
+}
+
+void SoftwareBackend::rasterSplat(const Splat& splat, int tileX, int tileY, const float* depth)
+{
+	int x0 = std::max((int)floorf(splat.x - splat.radius), tileX);
+	int y0 = std::max((int)floorf(splat.y - splat.radius), tileY);
+	int x1 = std::min((int)ceilf(splat.x + splat.radius), std::min(tileX + SOFTWARE_TILE_SIZE, m_renderWidth) - 1);
+	int y1 = std::min((int)ceilf(splat.y + splat.radius), std::min(tileY + SOFTWARE_TILE_SIZE, m_renderHeight) - 1);
+	float invRadius2 = 1.f / (splat.radius * splat.radius);
+
+	for (int y = y0; y <= y1; y++)
+	{
+		float dy = y + 0.5f - splat.y;
+		const float* depthRow = &depth[(y - tileY) * SOFTWARE_TILE_SIZE];
+		uint8_t* colorRow = &m_color[4 * y * m_width];
+		for (int x = x0; x <= x1; x++)
+		{
+			float dx = x + 0.5f - splat.x;
+			float distance2 = (dx * dx + dy * dy) * invRadius2;
+			if (distance2 > 1.f || splat.z >= depthRow[x - tileX]) {
+				continue;
+			}
+			//mlange additif GL_SRC_ALPHA, GL_ONE
+			float intensity = 1.f - distance2;
+			uint8_t* pixel = &colorRow[4 * x];
+			for (int c = 0; c < 3; c++) {
+				pixel[c] = (uint8_t)std::min(255.f, pixel[c] + splat.color[c] * intensity + 0.5f);
+			}
+		}
+	}
+}
+
+void SoftwareBackend::rasterTriangle(const Triangle& tri, const DrawCommand& command, int tileX, int tileY, float* depth)
+{
+	int x0 = std::max(tri.minX, tileX);
+	int y0 = std::max(tri.minY, tileY);
+	int x1 = std::min(tri.maxX, std::min(tileX + SOFTWARE_TILE_SIZE, m_renderWidth) - 1);
+	int y1 = std::min(tri.maxY, std::min(tileY + SOFTWARE_TILE_SIZE, m_renderHeight) - 1);
+	if (x0 > x1 || y0 > y1) {
+		return;
+	}
+
+	//fonctions d'arte E(p) = A * (p.x - a.x) + B * (p.y - a.y), positives  l'intrieur. L'arte k est oppose au sommet k.
+	float ax[3], ay[3], A[3], B[3];
+	for (int k = 0; k < 3; k++)
+	{
+		int a = (k + 1) % 3;
+		int b = (k + 2) % 3;
+		ax[k] = tri.x[a];
+		ay[k] = tri.y[a];
+		A[k] = -(tri.y[b] - tri.y[a]);
+		B[k] = tri.x[b] - tri.x[a];
+	}
+	float invArea = 1.0f / tri.area;
+
+	for (int y = y0; y <= y1; y++)
+	{
+		float py = y + 0.5f;
+		float* depthRow = &depth[(y - tileY) * SOFTWARE_TILE_SIZE];
+		uint8_t* colorRow = &m_color[4 * y * m_width];
+
+		for (int x = x0; x <= x1; x += 4)
+		{
+			float weights[3][4];
+			float z[4];
+			int mask = 0;
+#ifdef SOFTWARE_SIMD
+			__m128 px = _mm_add_ps(_mm_set1_ps(x + 0.5f), _mm_set_ps(3.f, 2.f, 1.f, 0.f));
+			__m128 inside = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_add_epi32(_mm_set1_epi32(x), _mm_set_epi32(3, 2, 1, 0)), _mm_set1_epi32(x1 + 1)));
+			__m128 w[3];
+			for (int k = 0; k < 3; k++)
+			{
+				__m128 e = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[k]), _mm_sub_ps(px, _mm_set1_ps(ax[k]))), _mm_set1_ps(B[k] * (py - ay[k])));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(e, _mm_setzero_ps()));
+				w[k] = _mm_mul_ps(e, _mm_set1_ps(invArea));
+			}
+			if (_mm_movemask_ps(inside) == 0) {
+				continue;
+			}
+			__m128 depthValue = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w[0], _mm_set1_ps(tri.z[0])), _mm_mul_ps(w[1], _mm_set1_ps(tri.z[1]))),
+				_mm_mul_ps(w[2], _mm_set1_ps(tri.z[2])));
+			//test de profondeur GL_LESS, et rejet de ce qui est au-del du plan far
+			inside = _mm_and_ps(inside, _mm_cmplt_ps(depthValue, _mm_loadu_ps(&depthRow[x - tileX])));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(depthValue, _mm_setzero_ps()));
+			mask = _mm_movemask_ps(inside);
+			_mm_storeu_ps(z, depthValue);
+			for (int k = 0; k < 3; k++) {
+				_mm_storeu_ps(weights[k], w[k]);
+			}
+#else
+			for (int lane = 0; lane < 4 && x + lane <= x1; lane++)
+			{
+				float px = x + lane + 0.5f;
+				bool covered = true;
+				for (int k = 0; k < 3; k++)
+				{
+					float e = A[k] * (px - ax[k]) + B[k] * (py - ay[k]);
+					covered = covered && e >= 0.f;
+					weights[k][lane] = e * invArea;
+				}
+				z[lane] = weights[0][lane] * tri.z[0] + weights[1][lane] * tri.z[1] + weights[2][lane] * tri.z[2];
+				if (covered && z[lane] < depthRow[x - tileX + lane] && z[lane] >= 0.f) {
+					mask |= 1 << lane;
+				}
+			}
+#endif
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (!(mask & (1 << lane))) {
+					continue;
+				}
+
+				//interpolation correcte en perspective des varyings
+				float b0 = weights[0][lane] * tri.invW[0];
+				float b1 = weights[1][lane] * tri.invW[1];
+				float b2 = weights[2][lane] * tri.invW[2];
+				float invSum = 1.0f / (b0 + b1 + b2);
+				float varyings[SOFTWARE_VARYINGS];
+				for (int i = 0; i < SOFTWARE_VARYINGS; i++) {
+					varyings[i] = (weights[0][lane] * tri.varyings[0][i] + weights[1][lane] * tri.varyings[1][i] + weights[2][lane] * tri.varyings[2][i]) * invSum;
+				}
+
+				glm::vec3 color = shade(command, varyings);
+				depthRow[x - tileX + lane] = z[lane];
+				uint8_t* pixel = &colorRow[4 * (x + lane)];
+				pixel[0] = (uint8_t)(color.r * 255.f + 0.5f);
+				pixel[1] = (uint8_t)(color.g * 255.f + 0.5f);
+				pixel[2] = (uint8_t)(color.b * 255.f + 0.5f);
+				pixel[3] = 255;
+			}
+		}
+	}
+}
+
+//quivalent de color.frag
+glm::vec3 SoftwareBackend::shade(const DrawCommand& command, const float* varyings) const
+{
+	const Material& m = command.material;
+	const Light& l = command.light;
+	glm::vec3 normal(varyings[0], varyings[1], varyings[2]);
+	glm::vec3 position(varyings[3], varyings[4], varyings[5]);
+
+	//mmes termes que la variante de color.frag choisie par le rendu OpenGL
+	glm::vec3 tex = m.color;
+	if (command.features & MATERIAL_TEXTURED)
+	{
+		const Texture& texture = m_textures[command.texture];
+		tex = sampleTexture(texture.pixels, texture.width, texture.height, varyings[6], varyings[7]);
+	}
+	glm::vec3 color = m.ka * tex * l.color;
+	if (command.features & (MATERIAL_DIFFUSE | MATERIAL_SPECULAR))
+	{
+		glm::vec3 L = glm::normalize(l.position - position);
+		if (command.features & MATERIAL_DIFFUSE) {
+			color += m.kd * std::max(0.f, glm::dot(normal, L)) * tex * l.color;
+		}
+		if (command.features & MATERIAL_SPECULAR)
+		{
+			glm::vec3 V = glm::normalize(glm::vec3(0.f, 0.f, 0.f) - position);
+			glm::vec3 R = -L - 2.f * glm::dot(normal, -L) * normal;
+			color += m.ks * powf(std::max(0.f, glm::dot(R, V)), m.alpha) * l.color;
+		}
+	}
+
+	return glm::min(glm::vec3(1.0f, 1.0f, 1.0f), color);
+}
+
+void SoftwareBackend::runParallel(int count, Task task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = task;
+		m_taskCount = count;
+		m_next = 0;
+		m_workersDone = 0;
+		m_generation++;
+	}
+	m_wake.notify_all();
+
+	work();
+
+	//chaque thread traite chaque gnration une seule fois, on attend qu'ils aient tous fini avant d'en lancer une autre
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_finished.wait(lock, [this] { return m_workersDone == (int)m_workers.size(); });
+}
+
+void SoftwareBackend::work()
+{
+	int i;
+	while ((i = m_next++) < m_taskCount) {
+		(this->*m_task)(i);
+	}
+}
+
+void SoftwareBackend::workerLoop()
+{
+	unsigned seen = 0;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_wake.wait(lock, [this, &seen] { return m_stop || m_generation != seen; });
+		if (m_stop) {
+			return;
+		}
+		seen = m_generation;
+		lock.unlock();
+		work();
+		lock.lock();
+		m_workersDone++;
+		m_finished.notify_all();
+	}
+}
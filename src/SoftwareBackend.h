@@ -0,0 +1,180 @@
+#ifndef SOFTWAREBACKEND_H
+#define SOFTWAREBACKEND_H
+
+//SDL Libraries
+#include <SDL2/SDL.h>
+
+#include "RenderBackend.h"
+#include "Skybox.h"
+#include "FrameArena.h"
+
+#include "vector"
+#include "thread"
+#include "mutex"
+#include "condition_variable"
+#include "atomic"
+
+#define SOFTWARE_TILE_SIZE 64
+#define SOFTWARE_VARYINGS  8 //normale (3), position (3), uv (2), comme en sortie de color.vert
+#define SOFTWARE_UPSCALE_ROWS 16 //lignes traites par tche pendant l'agrandissement
+
+//Rendu sur le processeur, pour les machines sans carte graphique. Il reproduit color.vert et color.frag.
+//Les triangles sont rpartis par tuiles de 64x64 pixels, chaque tuile tant rastrise par un thread avec son propre depth buffer.
+//Avec une chelle de rendu rduite, seul le coin en haut  gauche de l'image est rastris, puis agrandi comme upscale.frag.
+class SoftwareBackend : public RenderBackend
+{
+public:
+	//nbThreads = 0 utilise tous les coeurs
+	SoftwareBackend(SDL_Window* window, int width, int height, int nbThreads = 0);
+	~SoftwareBackend();
+
+	int createMesh(const float* positions, const float* normals, const float* uvs, int nbVertices);
+	int createTexture(const uint8_t* pixels, int width, int height);
+	int createSkybox(const uint8_t* pixels, int width, int height);
+
+	void beginFrame();
+	void draw(int mesh, int texture, const glm::mat4& mvp, const Material& material, const Light& light);
+	void drawParticles(const ParticleBatch& batch);
+	void drawSkybox(int skybox, const glm::mat4& viewProjection);
+	//pas de carte d'ombre sur le processeur
+	bool setShadowLight(const glm::vec3&, const glm::vec3&, const glm::mat4&) { return false; }
+	void drawShadowCaster(int, const glm::mat4&, bool) {}
+	void endFrame();
+
+	void setCapture(FrameCapture* capture) { m_capture = capture; }
+	void setFramePacer(FramePacer* pacer) { m_pacer = pacer; }
+
+	void setRenderScale(float scale);
+	float getRenderScale() const { return m_renderScale; }
+	//dure de endFrame() : rastrisation, agrandissement et affichage
+	float getRenderTime() const { return m_renderTime; }
+
+	//la stro en une passe repose sur l'instanciation des draw calls : seule la vue unique est rendue ici
+	bool setStereo(const StereoViews* views) { return views == NULL; }
+
+	void printMemoryReport(const char* title) const;
+
+	//image RGBA8 de la dernire frame  la taille de la fentre, premire ligne en haut
+	const uint8_t* getColorBuffer() const { return m_renderWidth < m_width || m_renderHeight < m_height ? &m_upscaled[0] : &m_color[0]; }
+
+private:
+	struct Mesh {
+		std::vector<float> positions;
+		std::vector<float> normals;
+		std::vector<float> uvs;
+		int nbVertices;
+	};
+
+	struct Texture {
+		std::vector<uint8_t> pixels;
+		int width;
+		int height;
+	};
+
+	struct DrawCommand {
+		int mesh;
+		int texture;
+		glm::mat4 mvp;
+		Material material;
+		Light light;
+		int features; //termes calculs par shade(), voir MaterialFeature
+	};
+
+	//sommet en sortie du vertex shader
+	struct ClipVertex {
+		glm::vec4 position;
+		float varyings[SOFTWARE_VARYINGS];
+	};
+
+	//triangle prt  tre rastris : coordonnes cran et varyings diviss par w pour la correction de perspective
+	struct Triangle {
+		float x[3], y[3], z[3], invW[3];
+		float varyings[3][SOFTWARE_VARYINGS];
+		float area;
+		int minX, minY, maxX, maxY;
+	};
+
+	struct TriangleRef {
+		int command;
+		int triangle;
+	};
+
+	//particule projete, comme en sortie de particle.vert : disque de rayon radius pixels, couleur dj multiplie par l'opacit
+	struct Splat {
+		float x, y, z;
+		float radius;
+		float color[3];
+	};
+
+	typedef void (SoftwareBackend::*Task)(int);
+
+	void setupCommand(int command);
+	void addTriangle(std::vector<Triangle>& triangles, const ClipVertex& a, const ClipVertex& b, const ClipVertex& c);
+	//rpartit les particules de l'image dans les tuiles, comme les triangles
+	void binSplats();
+	void rasterTile(int tile);
+	void rasterTriangle(const Triangle& tri, const DrawCommand& command, int tileX, int tileY, float* depth);
+	//quivalent de particle.frag : disque attnu vers le bord, test contre le depth buffer de la tuile sans l'crire
+	void rasterSplat(const Splat& splat, int tileX, int tileY, const float* depth);
+	//quivalent de skybox.frag sur les pixels de la tuile dont la profondeur est reste  1
+	void rasterSky(int tileX, int tileY, const float* depth);
+	glm::vec3 shade(const DrawCommand& command, const float* varyings) const;
+	//quivalent de upscale.frag en deux passes, par blocs de SOFTWARE_UPSCALE_ROWS lignes : nettet  la taille rendue, puis agrandissement bilinaire
+	void sharpenRows(int block);
+	void upscaleRows(int block);
+
+	void runParallel(int count, Task task);
+	void work();
+	void workerLoop();
+
+	SDL_Window* m_window;
+	int m_width;
+	int m_height;
+	int m_tilesX; //tuiles de la zone rendue
+	int m_tilesY;
+	float m_renderScale;
+	float m_nextRenderScale;
+	int m_renderWidth;
+	int m_renderHeight;
+	float m_renderTime;
+
+	std::vector<Mesh> m_meshes;
+	std::vector<Texture> m_textures;
+	std::vector<CubeMap> m_skyboxes;
+	int m_skybox; //fond de l'image en cours, -1 sans fond
+	glm::mat4 m_skyInverse;
+
+	std::vector<DrawCommand> m_commands;
+	std::vector<std::vector<Triangle> > m_triangles; //triangles de chaque commande
+	std::vector<Splat> m_splats;
+	//Tuiles de l'image, dans la mmoire de l'image : les triangles de la tuile t sont m_binRefs[m_binStart[t]]  m_binRefs[m_binStart[t + 1] - 1],
+	//dans l'ordre des draw(), et de mme pour les particules
+	FrameArena m_arena;
+	int* m_binStart;
+	TriangleRef* m_binRefs;
+	int* m_splatStart;
+	int* m_splatRefs;
+	std::vector<uint8_t> m_color;
+	SDL_Surface* m_image; //m_color vue comme une surface SDL, pour l'affichage
+	std::vector<uint8_t> m_sharpened; //zone rendue aprs le filtre de nettet, mme disposition que m_color
+	std::vector<uint8_t> m_upscaled;
+	SDL_Surface* m_upscaledImage;
+	std::vector<int> m_sourceColumns; //pour chaque colonne de la fentre, colonne source  gauche et poids de celle de droite
+	std::vector<float> m_sourceWeights;
+	FrameCapture* m_capture;
+	FramePacer* m_pacer;
+
+	//threads de travail : chaque appel  runParallel() distribue les indices 0..count-1
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_finished;
+	Task m_task;
+	int m_taskCount;
+	std::atomic<int> m_next;
+	int m_workersDone; //threads ayant fini la tche en cours
+	unsigned m_generation;
+	bool m_stop;
+};
+
+#endif
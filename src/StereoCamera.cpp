@@ -0,0 +1,57 @@
+#include "StereoCamera.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "stdio.h"
+
+void computeStereoViews(const glm::mat4& projection, float ipd, float convergence, StereoViews& views)
+{
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	for (int eye = 0; eye < 2; eye++)
+	{
+		float side = eye == 0 ? -1.f : 1.f;
+		float eyeX = side * 0.5f * ipd; //position de l'oeil dans le repre de la camra centrale
+
+		//moiti de la largeur pour le mme champ vertical, puis dcalage du frustum :
+		//un point du plan de convergence se projette au mme endroit que pour la camra centrale
+		glm::mat4 eyeProjection = projection;
+		eyeProjection[0][0] *= 2.f;
+		eyeProjection[2][0] = -eyeProjection[0][0] * eyeX / convergence;
+		glm::mat4 eyeView = glm::translate(glm::mat4(1.f), glm::vec3(-eyeX, 0.f, 0.f));
+		views.eyeProjections[eye] = eyeProjection * eyeView * inverseProjection;
+
+		//x' = x / 2 -+ w / 2 : l'oeil gauche occupe [-1, 0] en coordonnes normalises, l'oeil droit [0, 1]
+		glm::mat4 placement(1.f);
+		placement[0][0] = 0.5f;
+		placement[3][0] = 0.5f * side;
+		views.eyes[eye] = placement * views.eyeProjections[eye];
+		views.clipPlanes[eye] = glm::vec4(side, 0.f, 0.f, 0.f);
+
+		float skyScale = projection[0][0] / eyeProjection[0][0];
+		views.layouts[eye] = glm::vec4(0.5f, 0.5f * side, skyScale, eyeProjection[2][0] * skyScale);
+	}
+	views.parallax = glm::vec2(projection[0][0] * 0.5f * ipd, 1.f / convergence);
+}
+
+StereoComparison::StereoComparison()
+{
+	m_total[0] = m_total[1] = 0.0;
+	m_frames[0] = m_frames[1] = 0;
+}
+
+void StereoComparison::add(bool stereo, double milliseconds)
+{
+	m_total[stereo ? 1 : 0] += milliseconds;
+	m_frames[stereo ? 1 : 0]++;
+}
+
+void StereoComparison::printSummary() const
+{
+	if (m_frames[0] == 0 || m_frames[1] == 0) {
+		return;
+	}
+	double mono = m_total[0] / m_frames[0];
+	double stereo = m_total[1] / m_frames[1];
+	printf("Render CPU time : mono %.3f ms over %d frames, stereo %.3f ms over %d frames, stereo / mono = %.2f\n",
+		mono, m_frames[0], stereo, m_frames[1], mono > 0.0 ? stereo / mono : 0.0);
+}
@@ -0,0 +1,41 @@
+#ifndef STEREOCAMERA_H
+#define STEREOCAMERA_H
+
+#include <glm/glm.hpp>
+
+#define STEREO_IPD         0.064f //cart entre les deux yeux, en units de la scne
+#define STEREO_CONVERGENCE 3.f //distance du plan o les deux images concident : la table vue de la position de dpart
+
+//Les deux yeux cte  cte dans l'image, l'oeil gauche dans la moiti gauche. Chaque oeil garde le champ vertical de la camra
+//centrale sur une moiti de la largeur, avec un frustum dcal pour que les images concident  la distance de convergence.
+//Les matrices partent du clip space de la camra centrale : les mvp calcules pour une vue unique servent telles quelles.
+struct StereoViews {
+	glm::mat4 eyes[2]; //clip space central -> clip space de l'oeil, plac dans sa moiti de l'image
+	glm::mat4 eyeProjections[2]; //mme chose sans le placement, coordonnes normalises sur la moiti
+	glm::vec4 clipPlanes[2]; //gl_ClipDistance[0] = dot(plan, position) garde chaque oeil dans sa moiti
+	//passes plein cran : x de l'oeil = x * layout.x + layout.y, et la direction du fond vue en x de l'oeil
+	//est celle de la camra centrale en x * layout.z + layout.w (points  l'infini, sans parallaxe)
+	glm::vec4 layouts[2];
+	//un point  la profondeur w (clip space central) est vu par chaque oeil dcal de parallax.x * |1 / w - parallax.y|
+	//en coordonnes normalises de la camra centrale : parallax.x = projection[0][0] * ipd / 2, parallax.y = 1 / convergence
+	glm::vec2 parallax;
+};
+
+//projection : celle de la camra centrale, perspective symtrique
+void computeStereoViews(const glm::mat4& projection, float ipd, float convergence, StereoViews& views);
+
+//Temps processeur du rendu (de beginFrame()  la fin de endFrame()) des images en vue unique et en stro, pour les comparer
+class StereoComparison
+{
+public:
+	StereoComparison();
+
+	void add(bool stereo, double milliseconds);
+	void printSummary() const;
+
+private:
+	double m_total[2];
+	int m_frames[2];
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "StreamBuffer.h"
+
+#include "logger.h"
+
+#include "algorithm"
+
+#define STREAM_MAX_ALIGNMENT 256 //plus grand alignement d'offset demand par OpenGL pour les uniform et storage buffers
+
+StreamBuffer::StreamBuffer(GpuResourceManager& resources) : m_resources(resources), m_mapped(NULL), m_regionSize(0), m_region(0), m_used(0), m_overflow(0), m_waits(0)
+{
+	for (int i = 0; i < STREAM_REGIONS; i++) {
+		m_fences[i] = NULL;
+	}
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for (int i = 0; i < STREAM_REGIONS; i++) {
+		waitRegion(i);
+	}
+	if (m_mapped != NULL)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer.get());
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+}
+
+bool StreamBuffer::init(size_t regionSize)
+{
+	return create(regionSize);
+}
+
+bool StreamBuffer::create(size_t regionSize)
+{
+	//chaque rgion commence sur un offset utilisable par glBindBufferRange
+	regionSize = (regionSize + STREAM_MAX_ALIGNMENT - 1) / STREAM_MAX_ALIGNMENT * STREAM_MAX_ALIGNMENT;
+	size_t size = regionSize * STREAM_REGIONS;
+
+	if (m_mapped != NULL)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer.get());
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		m_mapped = NULL;
+	}
+	m_buffer.reset();
+
+	if (GLEW_ARB_buffer_storage)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		m_buffer = m_resources.createStorageBuffer(GL_COPY_WRITE_BUFFER, size, flags, "stream ring");
+		if (m_buffer.isValid())
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer.get());
+			m_mapped = (uint8_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+	}
+	else
+	{
+		m_buffer = m_resources.createBuffer(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_DRAW, "stream ring");
+		m_staging.resize(regionSize);
+	}
+
+	if (!m_buffer.isValid() || (GLEW_ARB_buffer_storage && m_mapped == NULL))
+	{
+		ERROR("Could not create the stream buffer of %u bytes\n", (unsigned)size);
+		m_buffer.reset();
+		m_regionSize = 0;
+		return false;
+	}
+	m_regionSize = regionSize;
+	m_used = 0;
+	return true;
+}
+
+void StreamBuffer::waitRegion(int region)
+{
+	GLsync fence = m_fences[region];
+	if (fence == NULL) {
+		return;
+	}
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		m_waits++;
+		do {
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); //1 ms
+		} while (status == GL_TIMEOUT_EXPIRED);
+	}
+	glDeleteSync(fence);
+	m_fences[region] = NULL;
+}
+
+void StreamBuffer::beginFrame()
+{
+	//une image n'a pas tenu dans sa rgion : on attend que tout soit lu et on recre le buffer plus grand
+	if (m_overflow > 0)
+	{
+		for (int i = 0; i < STREAM_REGIONS; i++) {
+			waitRegion(i);
+		}
+		create(std::max(2 * m_regionSize, m_used + m_overflow));
+		m_overflow = 0;
+	}
+
+	m_region = (m_region + 1) % STREAM_REGIONS;
+	waitRegion(m_region);
+	m_used = 0;
+}
+
+void* StreamBuffer::allocate(size_t size, size_t alignment, GLintptr& offset)
+{
+	size_t start = (m_used + alignment - 1) / alignment * alignment;
+	if (m_regionSize == 0 || start + size > m_regionSize)
+	{
+		m_overflow += size;
+		return NULL;
+	}
+	m_used = start + size;
+	offset = (GLintptr)(m_region * m_regionSize + start);
+	if (m_mapped != NULL) {
+		return m_mapped + offset;
+	}
+	return &m_staging[start];
+}
+
+void StreamBuffer::flush()
+{
+	//le mapping est cohrent : les critures sont dj visibles
+	if (m_mapped != NULL || m_used == 0) {
+		return;
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer.get());
+	glBufferSubData(GL_COPY_WRITE_BUFFER, m_region * m_regionSize, m_used, &m_staging[0]);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamBuffer::endFrame()
+{
+	//sans mapping persistant, glBufferSubData se synchronise dj avec la carte graphique
+	if (m_mapped != NULL) {
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
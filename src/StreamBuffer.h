@@ -0,0 +1,56 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+//OpenGL Libraries
+#include <GL/glew.h>
+
+#include "GpuResources.h"
+
+#include "stdint.h"
+#include "vector"
+
+#define STREAM_REGIONS 3 //le processeur crit l'image n pendant que la carte graphique lit les images n-1 et n-2
+#define STREAM_REGION_SIZE (1 << 20) //taille initiale d'une rgion, double si une image la dpasse
+
+//Anneau de donnes par image (matrices, matriaux, commandes) crites directement dans un buffer mapp en permanence.
+//Le buffer est dcoup en STREAM_REGIONS rgions, une par image, et une fence protge chaque rgion tant que la carte graphique la lit.
+//Sans ARB_buffer_storage, les donnes passent par une copie locale envoye avec glBufferSubData dans flush().
+class StreamBuffer
+{
+public:
+	StreamBuffer(GpuResourceManager& resources);
+	~StreamBuffer();
+
+	bool init(size_t regionSize = STREAM_REGION_SIZE);
+	bool isPersistent() const { return m_mapped != NULL; }
+	GLuint getBuffer() const { return m_buffer.get(); }
+
+	//Passe  la rgion suivante, en attendant que la carte graphique ait fini de la lire
+	void beginFrame();
+	//Rserve size octets aligns sur alignment dans la rgion de l'image. offset reoit la position dans le buffer.
+	//Renvoie NULL si la rgion est pleine : elle sera agrandie  la prochaine image.
+	void* allocate(size_t size, size_t alignment, GLintptr& offset);
+	// appeler avant les draw calls qui lisent les donnes de l'image
+	void flush();
+	// appeler aprs ces draw calls : pose la fence de la rgion
+	void endFrame();
+
+	uint32_t getWaits() const { return m_waits; }
+
+private:
+	bool create(size_t regionSize);
+	void waitRegion(int region);
+
+	GpuResourceManager& m_resources;
+	GpuBuffer m_buffer;
+	uint8_t* m_mapped; //mapping persistant, NULL sans ARB_buffer_storage
+	std::vector<uint8_t> m_staging; //copie locale de la rgion sans mapping persistant
+	GLsync m_fences[STREAM_REGIONS];
+	size_t m_regionSize;
+	int m_region;
+	size_t m_used; //octets utiliss dans la rgion de l'image
+	size_t m_overflow; //octets refuss pendant l'image
+	uint32_t m_waits; //nombre de fois o le processeur a attendu la carte graphique
+};
+
+#endif
@@ -0,0 +1,251 @@
+#include "Tessellation.h"
+
+#include "algorithm"
+#include "chrono"
+#include "math.h"
+#include "stdio.h"
+#include "thread"
+#include "vector"
+
+#define TESSELLATION_PI 3.14159265358979323846
+
+//Sries de Taylor values  la compilation, pour x dans [-pi, pi] : le terme suivant le dernier est sous 1e-12
+static constexpr double taylorSin(double x)
+{
+	double term = x, sum = x;
+	for (int n = 1; n < 13; n++)
+	{
+		term *= -x * x / ((2 * n) * (2 * n + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+static constexpr double taylorCos(double x)
+{
+	double term = 1.0, sum = 1.0;
+	for (int n = 1; n < 13; n++)
+	{
+		term *= -x * x / ((2 * n - 1) * (2 * n));
+		sum += term;
+	}
+	return sum;
+}
+
+struct TrigTable {
+	float sines[TESSELLATION_TABLE_SIZE];
+	float cosines[TESSELLATION_TABLE_SIZE];
+};
+
+static constexpr TrigTable makeTrigTable()
+{
+	TrigTable table = {};
+	for (int k = 0; k < TESSELLATION_TABLE_SIZE; k++)
+	{
+		double angle = 2.0 * TESSELLATION_PI * k / TESSELLATION_TABLE_SIZE;
+		if (angle > TESSELLATION_PI) {
+			angle -= 2.0 * TESSELLATION_PI;
+		}
+		table.sines[k] = (float)taylorSin(angle);
+		table.cosines[k] = (float)taylorCos(angle);
+	}
+	return table;
+}
+
+//sin et cos de 2pi k / TESSELLATION_TABLE_SIZE, dans les donnes du programme : rien n'est calcul au lancement
+static constexpr TrigTable trigTable = makeTrigTable();
+
+//sinus et cosinus des count + 1 angles 2pi k / count : lus dans la table quand count divise sa taille,
+//calculs sinon, une fois par angle et non plus une fois par sommet
+struct AngleTable {
+	std::vector<float> sines;
+	std::vector<float> cosines;
+};
+
+static void fillAngleTable(int count, AngleTable& table)
+{
+	table.sines.resize(count + 1);
+	table.cosines.resize(count + 1);
+	if (TESSELLATION_TABLE_SIZE % count == 0)
+	{
+		int step = TESSELLATION_TABLE_SIZE / count;
+		for (int k = 0; k <= count; k++)
+		{
+			int index = (k * step) % TESSELLATION_TABLE_SIZE;
+			table.sines[k] = trigTable.sines[index];
+			table.cosines[k] = trigTable.cosines[index];
+		}
+		return;
+	}
+	for (int k = 0; k <= count; k++)
+	{
+		double angle = 2.0 * TESSELLATION_PI * k / count;
+		table.sines[k] = (float)sin(angle);
+		table.cosines[k] = (float)cos(angle);
+	}
+}
+
+static inline void writeVertex(const MeshBuffers& out, int vertex, float x, float y, float z, float nx, float ny, float nz, float u, float v)
+{
+	out.positions[3 * vertex] = x;
+	out.positions[3 * vertex + 1] = y;
+	out.positions[3 * vertex + 2] = z;
+	out.normals[3 * vertex] = nx;
+	out.normals[3 * vertex + 1] = ny;
+	out.normals[3 * vertex + 2] = nz;
+	out.uvs[2 * vertex] = u;
+	out.uvs[2 * vertex + 1] = v;
+}
+
+//Dcoupe les lignes [0, count) en bandes contigus, chacune gnre par un thread, le thread appelant prenant la premire.
+//Chaque ligne crit toujours aux mmes sommets : les bandes ne se chevauchent pas et le rsultat ne dpend pas du dcoupage
+template<typename Stripe>
+static void runStripes(int count, int nbVertices, int nbThreads, Stripe stripe)
+{
+	if (nbThreads <= 0) {
+		nbThreads = nbVertices < TESSELLATION_PARALLEL_VERTICES ? 1 : (int)std::max(1u, std::thread::hardware_concurrency());
+	}
+	nbThreads = std::max(1, std::min(nbThreads, count));
+
+	std::vector<std::thread> workers;
+	for (int t = 1; t < nbThreads; t++) {
+		workers.push_back(std::thread(stripe, count * t / nbThreads, count * (t + 1) / nbThreads));
+	}
+	stripe(0, count / nbThreads);
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+}
+
+int sphereVertexCount(int slices, int stacks)
+{
+	return 6 * slices * stacks;
+}
+
+void tessellateSphere(int slices, int stacks, const MeshBuffers& out, int nbThreads)
+{
+	//longitude 2pi j / slices, colatitude pi i / stacks = 2pi i / (2 stacks) : les stacks + 1 premiers angles de la seconde table
+	AngleTable longitudes, latitudes;
+	fillAngleTable(slices, longitudes);
+	fillAngleTable(2 * stacks, latitudes);
+
+	runStripes(stacks, sphereVertexCount(slices, stacks), nbThreads, [&](int firstStack, int lastStack)
+	{
+		int vertex = 6 * slices * firstStack;
+		for (int i = firstStack; i < lastStack; i++)
+		{
+			//quadrilatre entre les parallles i et i + 1 et les mridiens j et j + 1, en deux triangles dans le sens direct vus de l'extrieur
+			const int rows[6] = { i, i + 1, i + 1, i, i + 1, i };
+			const int columns[6] = { 0, 0, 1, 0, 1, 1 };
+			for (int j = 0; j < slices; j++)
+			{
+				for (int k = 0; k < 6; k++)
+				{
+					int row = rows[k], column = j + columns[k];
+					float ring = latitudes.sines[row];
+					float nx = ring * longitudes.cosines[column];
+					float ny = ring * longitudes.sines[column];
+					float nz = latitudes.cosines[row];
+					writeVertex(out, vertex++, 0.5f * nx, 0.5f * ny, 0.5f * nz, nx, ny, nz, column / (float)slices, row / (float)stacks);
+				}
+			}
+		}
+	});
+}
+
+int cylinderVertexCount(int slices)
+{
+	return 12 * slices;
+}
+
+void tessellateCylinder(int slices, const MeshBuffers& out, int nbThreads)
+{
+	AngleTable angles;
+	fillAngleTable(slices, angles);
+
+	runStripes(slices, cylinderVertexCount(slices), nbThreads, [&](int firstSlice, int lastSlice)
+	{
+		int vertex = 12 * firstSlice;
+		for (int j = firstSlice; j < lastSlice; j++)
+		{
+			float c0 = angles.cosines[j], s0 = angles.sines[j];
+			float c1 = angles.cosines[j + 1], s1 = angles.sines[j + 1];
+			float x0 = 0.5f * c0, y0 = 0.5f * s0, x1 = 0.5f * c1, y1 = 0.5f * s1;
+			float u0 = j / (float)slices, u1 = (j + 1) / (float)slices;
+
+			//le ct : deux triangles, normales horizontales
+			writeVertex(out, vertex++, x0, y0, 0.5f, c0, s0, 0.f, u0, 0.f);
+			writeVertex(out, vertex++, x0, y0, -0.5f, c0, s0, 0.f, u0, 1.f);
+			writeVertex(out, vertex++, x1, y1, -0.5f, c1, s1, 0.f, u1, 1.f);
+			writeVertex(out, vertex++, x0, y0, 0.5f, c0, s0, 0.f, u0, 0.f);
+			writeVertex(out, vertex++, x1, y1, -0.5f, c1, s1, 0.f, u1, 1.f);
+			writeVertex(out, vertex++, x1, y1, 0.5f, c1, s1, 0.f, u1, 0.f);
+
+			//les disques : un triangle depuis le centre, texture plaque sur le disque
+			writeVertex(out, vertex++, 0.f, 0.f, 0.5f, 0.f, 0.f, 1.f, 0.5f, 0.5f);
+			writeVertex(out, vertex++, x0, y0, 0.5f, 0.f, 0.f, 1.f, 0.5f + x0, 0.5f + y0);
+			writeVertex(out, vertex++, x1, y1, 0.5f, 0.f, 0.f, 1.f, 0.5f + x1, 0.5f + y1);
+			writeVertex(out, vertex++, 0.f, 0.f, -0.5f, 0.f, 0.f, -1.f, 0.5f, 0.5f);
+			writeVertex(out, vertex++, x1, y1, -0.5f, 0.f, 0.f, -1.f, 0.5f + x1, 0.5f + y1);
+			writeVertex(out, vertex++, x0, y0, -0.5f, 0.f, 0.f, -1.f, 0.5f + x0, 0.5f + y0);
+		}
+	});
+}
+
+//Sphre calcule comme avant la table, un sin et un cos par sommet, pour comparer dans la mesure
+static void tessellateSphereDirect(int slices, int stacks, const MeshBuffers& out)
+{
+	const int rows[6] = { 0, 1, 1, 0, 1, 0 };
+	const int columns[6] = { 0, 0, 1, 0, 1, 1 };
+	int vertex = 0;
+	for (int i = 0; i < stacks; i++)
+	{
+		for (int j = 0; j < slices; j++)
+		{
+			for (int k = 0; k < 6; k++)
+			{
+				float theta = 2.f * (float)TESSELLATION_PI * (j + columns[k]) / slices;
+				float phi = (float)TESSELLATION_PI * (i + rows[k]) / stacks;
+				float nx = sinf(phi) * cosf(theta);
+				float ny = sinf(phi) * sinf(theta);
+				float nz = cosf(phi);
+				writeVertex(out, vertex++, 0.5f * nx, 0.5f * ny, 0.5f * nz, nx, ny, nz, (j + columns[k]) / (float)slices, (i + rows[k]) / (float)stacks);
+			}
+		}
+	}
+}
+
+//dure moyenne d'un appel de generate, en secondes
+template<typename Generate>
+static double measure(int repeats, Generate generate)
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats; r++) {
+		generate();
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(end - begin).count() / repeats;
+}
+
+void runTessellationBenchmark(int slices)
+{
+	int nbThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+	int sphereVertices = sphereVertexCount(slices, slices);
+	int cylinderVertices = cylinderVertexCount(slices);
+	std::vector<float> positions(3 * (size_t)sphereVertices), normals(3 * (size_t)sphereVertices), uvs(2 * (size_t)sphereVertices);
+	MeshBuffers out = { &positions[0], &normals[0], &uvs[0] };
+
+	//assez de rptitions pour gnrer environ 16 millions de sommets par mesure
+	int sphereRepeats = std::max(1, (1 << 24) / sphereVertices);
+	int cylinderRepeats = std::max(1, (1 << 24) / cylinderVertices);
+	double direct = measure(sphereRepeats, [&]() { tessellateSphereDirect(slices, slices, out); });
+	double serial = measure(sphereRepeats, [&]() { tessellateSphere(slices, slices, out, 1); });
+	double parallel = measure(sphereRepeats, [&]() { tessellateSphere(slices, slices, out, nbThreads); });
+	printf("Sphere %dx%d, %d vertices : per-vertex trigonometry %.1f Mvertices/s, tables %.1f Mvertices/s, tables on %d threads %.1f Mvertices/s\n",
+		slices, slices, sphereVertices, sphereVertices / direct * 1e-6, sphereVertices / serial * 1e-6, nbThreads, sphereVertices / parallel * 1e-6);
+
+	serial = measure(cylinderRepeats, [&]() { tessellateCylinder(slices, out, 1); });
+	parallel = measure(cylinderRepeats, [&]() { tessellateCylinder(slices, out, nbThreads); });
+	printf("Cylinder %d, %d vertices : tables %.1f Mvertices/s, tables on %d threads %.1f Mvertices/s\n",
+		slices, cylinderVertices, cylinderVertices / serial * 1e-6, nbThreads, cylinderVertices / parallel * 1e-6);
+}
@@ -0,0 +1,27 @@
+#ifndef TESSELLATION_H
+#define TESSELLATION_H
+
+#define TESSELLATION_TABLE_SIZE 2048 //angles par tour de la table de sinus : les subdivisions qui divisent ce nombre y sont lues directement
+#define TESSELLATION_PARALLEL_VERTICES 65536 //en dessous, une seule bande : lancer les threads coterait plus que le calcul
+
+//Tableaux remplis par la tessellation, fournis par l'appelant, dans le mme format que Geometry :
+//triangles non indexs, 3 floats par position et par normale, 2 par coordonne de texture
+struct MeshBuffers {
+	float* positions;
+	float* normals;
+	float* uvs;
+};
+
+//Sphre de rayon 0.5 centre  l'origine, ples sur l'axe z : slices mridiens, stacks parallles
+int sphereVertexCount(int slices, int stacks);
+//nbThreads : nombre de bandes de parallles gnres en mme temps, 0 = tous les coeurs pour les grands maillages
+void tessellateSphere(int slices, int stacks, const MeshBuffers& out, int nbThreads = 0);
+
+//Cylindre ferm de rayon 0.5 et de hauteur 1 centr  l'origine, axe z : slices secteurs, chacun avec son morceau des deux disques
+int cylinderVertexCount(int slices);
+void tessellateCylinder(int slices, const MeshBuffers& out, int nbThreads = 0);
+
+//Mesure le dbit de gnration d'une sphre slices x slices et d'un cylindre  slices secteurs, en sommets par seconde
+void runTessellationBenchmark(int slices);
+
+#endif
@@ -0,0 +1,159 @@
+#include "TexturePacker.h"
+
+#include "algorithm"
+#include "math.h"
+#include "string.h"
+
+//niveaux de mipmaps jusqu' 1 x 1
+static int fullMipLevels(int width, int height)
+{
+	int levels = 1;
+	while ((std::max(width, height) >> levels) > 0) {
+		levels++;
+	}
+	return levels;
+}
+
+//atlas d'une couche pour les images qui n'ont pas leur propre page, false s'il dpasse maxSize
+static bool packAtlas(const std::vector<TextureImage>& images, const std::vector<int>& atlasImages, int pageIndex, int maxSize,
+	TexturePage& page, std::vector<TexturePlacement>& placements)
+{
+	const int pad = TEXTURE_ATLAS_PADDING;
+	std::vector<int> order = atlasImages;
+	std::sort(order.begin(), order.end(), [&images](int a, int b) { return images[a].height > images[b].height; });
+
+	//ranges de hauteur dcroissante dans un atlas  peu prs carr, jamais plus troit que la plus large image
+	double area = 0.0;
+	int width = 0;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const TextureImage& image = images[order[i]];
+		area += (double)(image.width + 2 * pad) * (image.height + 2 * pad);
+		width = std::max(width, image.width + 2 * pad);
+	}
+	width = std::max(width, (int)ceil(sqrt(area)));
+
+	std::vector<int> xs(order.size()), ys(order.size());
+	int x = 0, y = 0, shelf = 0;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const TextureImage& image = images[order[i]];
+		if (x + image.width + 2 * pad > width)
+		{
+			y += shelf;
+			x = 0;
+			shelf = 0;
+		}
+		xs[i] = x;
+		ys[i] = y;
+		x += image.width + 2 * pad;
+		shelf = std::max(shelf, image.height + 2 * pad);
+	}
+	int height = y + shelf;
+	if (width > maxSize || height > maxSize) {
+		return false;
+	}
+
+	page.width = width;
+	page.height = height;
+	page.layers = 1;
+	page.mipLevels = 1;
+	while ((pad >> page.mipLevels) > 0 && page.mipLevels < fullMipLevels(width, height)) {
+		page.mipLevels++;
+	}
+	page.pixels.assign(4 * (size_t)width * height, 0);
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const TextureImage& image = images[order[i]];
+		//la bordure reprend le bord oppos : le filtrage linaire prs d'un bord lit les mmes pixels qu'avec GL_REPEAT
+		for (int py = -pad; py < image.height + pad; py++)
+		{
+			int sourceY = (py % image.height + image.height) % image.height;
+			uint8_t* row = &page.pixels[4 * ((size_t)(ys[i] + pad + py) * width + xs[i] + pad)];
+			for (int px = -pad; px < image.width + pad; px++)
+			{
+				int sourceX = (px % image.width + image.width) % image.width;
+				memcpy(row + 4 * px, image.pixels + 4 * ((size_t)sourceY * image.width + sourceX), 4);
+			}
+		}
+
+		TexturePlacement& placement = placements[order[i]];
+		placement.page = pageIndex;
+		placement.layer = 0;
+		placement.scaleU = image.width / (float)width;
+		placement.scaleV = image.height / (float)height;
+		placement.offsetU = (xs[i] + pad) / (float)width;
+		placement.offsetV = (ys[i] + pad) / (float)height;
+	}
+	return true;
+}
+
+bool packTextures(const std::vector<TextureImage>& images, int maxPages, int maxSize, std::vector<TexturePage>& pages, std::vector<TexturePlacement>& placements)
+{
+	pages.clear();
+	TexturePlacement unplaced = { -1, 0, 1.f, 1.f, 0.f, 0.f };
+	placements.assign(images.size(), unplaced);
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		if (images[i].width > maxSize || images[i].height > maxSize) {
+			return false;
+		}
+	}
+
+	//images groupes par taille, les groupes les plus nombreux d'abord
+	std::vector<std::vector<int> > groups;
+	for (int i = 0; i < (int)images.size(); i++)
+	{
+		size_t g = 0;
+		while (g < groups.size() && (images[groups[g][0]].width != images[i].width || images[groups[g][0]].height != images[i].height)) {
+			g++;
+		}
+		if (g == groups.size()) {
+			groups.push_back(std::vector<int>());
+		}
+		groups[g].push_back(i);
+	}
+	std::stable_sort(groups.begin(), groups.end(), [](const std::vector<int>& a, const std::vector<int>& b) { return a.size() > b.size(); });
+
+	//une page par groupe d'au moins deux images, la dernire page tant garde pour l'atlas
+	std::vector<int> atlasImages;
+	for (size_t g = 0; g < groups.size(); g++)
+	{
+		const std::vector<int>& group = groups[g];
+		if (group.size() < 2 || (int)pages.size() >= maxPages - 1)
+		{
+			atlasImages.insert(atlasImages.end(), group.begin(), group.end());
+			continue;
+		}
+
+		const TextureImage& first = images[group[0]];
+		size_t layerBytes = 4 * (size_t)first.width * first.height;
+		pages.push_back(TexturePage());
+		TexturePage& page = pages.back();
+		page.width = first.width;
+		page.height = first.height;
+		page.layers = (int)group.size();
+		page.mipLevels = fullMipLevels(page.width, page.height);
+		page.pixels.resize(layerBytes * group.size());
+		for (size_t layer = 0; layer < group.size(); layer++)
+		{
+			memcpy(&page.pixels[layer * layerBytes], images[group[layer]].pixels, layerBytes);
+			placements[group[layer]].page = (int)pages.size() - 1;
+			placements[group[layer]].layer = (int)layer;
+		}
+	}
+
+	if (atlasImages.empty()) {
+		return true;
+	}
+	if ((int)pages.size() >= maxPages) {
+		return false;
+	}
+	pages.push_back(TexturePage());
+	if (!packAtlas(images, atlasImages, (int)pages.size() - 1, maxSize, pages.back(), placements))
+	{
+		pages.pop_back();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,39 @@
+#ifndef TEXTUREPACKER_H
+#define TEXTUREPACKER_H
+
+#include "stdint.h"
+#include "vector"
+
+#define TEXTURE_PAGES 4 //pages lies en mme temps, chacune sur son unit de texture : autant de sampler2DArray dans color.frag
+#define TEXTURE_ATLAS_PADDING 8 //pixels recopis du bord oppos autour de chaque image de l'atlas, pour filtrer comme GL_REPEAT jusqu'au niveau de mipmap 3
+
+//image RGBA8, ligne par ligne
+struct TextureImage {
+	const uint8_t* pixels;
+	int width;
+	int height;
+};
+
+//tableau de textures : layers couches de width x height pixels RGBA8,  la suite dans pixels
+struct TexturePage {
+	int width;
+	int height;
+	int layers;
+	int mipLevels; //niveaux de mipmaps utilisables : dans l'atlas, ils s'arrtent quand la bordure ne fait plus un pixel
+	std::vector<uint8_t> pixels;
+};
+
+//o une image a t range : uv dans la page = fract(uv) * scale + offset, dans la couche layer
+struct TexturePlacement {
+	int page;
+	int layer;
+	float scaleU, scaleV;
+	float offsetU, offsetV;
+};
+
+//Range les images dans au plus maxPages pages. Les images de mme taille deviennent les couches d'une mme page, sans
+//rchantillonnage. Les autres partagent un atlas d'une seule couche, chacune entoure de TEXTURE_ATLAS_PADDING pixels.
+//Renvoie false si une page dpasserait maxSize pixels de ct.
+bool packTextures(const std::vector<TextureImage>& images, int maxPages, int maxSize, std::vector<TexturePage>& pages, std::vector<TexturePlacement>& placements);
+
+#endif
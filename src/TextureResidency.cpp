@@ -0,0 +1,351 @@
+#include "TextureResidency.h"
+
+#include "stdio.h"
+#include "string.h"
+
+//niveau suivant de toutes les couches, moyenne de 2 x 2 pixels (la dernire colonne ou ligne d'une taille impaire est rpte)
+static void downsample(const std::vector<uint8_t>& source, int width, int height, int layers, std::vector<uint8_t>& destination)
+{
+	int nextWidth = std::max(1, width / 2);
+	int nextHeight = std::max(1, height / 2);
+	destination.resize(4 * (size_t)nextWidth * nextHeight * layers);
+	for (int layer = 0; layer < layers; layer++)
+	{
+		const uint8_t* in = &source[4 * (size_t)width * height * layer];
+		uint8_t* out = &destination[4 * (size_t)nextWidth * nextHeight * layer];
+		for (int y = 0; y < nextHeight; y++)
+		{
+			int y0 = std::min(2 * y, height - 1);
+			int y1 = std::min(2 * y + 1, height - 1);
+			for (int x = 0; x < nextWidth; x++)
+			{
+				int x0 = std::min(2 * x, width - 1);
+				int x1 = std::min(2 * x + 1, width - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					int sum = in[4 * (y0 * width + x0) + c] + in[4 * (y0 * width + x1) + c] + in[4 * (y1 * width + x0) + c] + in[4 * (y1 * width + x1) + c];
+					out[4 * (y * nextWidth + x) + c] = (uint8_t)((sum + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+TextureResidency::TextureResidency(GpuResourceManager& resources) :
+	m_resources(resources), m_budget(0), m_residentBytes(0), m_frame(0), m_staging(resources), m_uploadPage(-1), m_uploadLevel(0), m_uploadRow(0),
+	m_evictions(0), m_uploadedBytes(0)
+{
+}
+
+bool TextureResidency::init()
+{
+	return m_staging.init(TEXTURE_UPLOAD_BYTES_PER_FRAME);
+}
+
+size_t TextureResidency::levelBytes(const Page& page, int level) const
+{
+	return 4 * (size_t)levelWidth(page, level) * levelHeight(page, level) * page.layers;
+}
+
+int TextureResidency::addPage(const TexturePage& source, const char* label)
+{
+	Page page;
+	page.width = source.width;
+	page.height = source.height;
+	page.layers = source.layers;
+	page.levels = std::max(1, source.mipLevels);
+	page.mipmaps.resize(page.levels);
+	page.mipmaps[0] = source.pixels;
+	for (int level = 1; level < page.levels; level++) {
+		downsample(page.mipmaps[level - 1], levelWidth(page, level - 1), levelHeight(page, level - 1), page.layers, page.mipmaps[level]);
+	}
+	page.coarsest = 0;
+	while (page.coarsest + 1 < page.levels && std::max(levelWidth(page, page.coarsest), levelHeight(page, page.coarsest)) > TEXTURE_RESIDENT_SIZE) {
+		page.coarsest++;
+	}
+	page.baseLevel = page.levels;
+	page.bytes = 0;
+	page.target = page.coarsest;
+	page.requested = page.levels;
+	page.lastUsed = 0;
+
+	size_t bytes = 0;
+	for (int level = page.coarsest; level < page.levels; level++) {
+		bytes += levelBytes(page, level);
+	}
+	page.texture = m_resources.createEmptyTexture(label);
+	if (m_resources.resizeTexture(page.texture, bytes))
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, page.texture.get());
+		for (int level = page.coarsest; level < page.levels; level++) {
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, levelWidth(page, level), levelHeight(page, level), page.layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, &page.mipmaps[level][0]);
+		}
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, page.coarsest);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, page.levels - 1);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		page.baseLevel = page.coarsest;
+		page.bytes = bytes;
+		m_residentBytes += bytes;
+	}
+	else {
+		page.texture.reset();
+	}
+	m_pages.push_back(std::move(page));
+	return (int)m_pages.size() - 1;
+}
+
+//le niveau voulu est le plus grossier qui a encore au moins un texel par pixel couvert
+void TextureResidency::request(int page, float scaleU, float scaleV, float screenWidth, float screenHeight)
+{
+	Page& p = m_pages[page];
+	float texels = std::max(scaleU * p.width, scaleV * p.height);
+	float pixels = std::max(1.f, std::max(screenWidth, screenHeight));
+	int level = 0;
+	while (level + 1 < p.levels && texels / (float)(2 << level) >= pixels) {
+		level++;
+	}
+	p.requested = std::min(p.requested, level);
+}
+
+void TextureResidency::update()
+{
+	m_frame++;
+	for (size_t i = 0; i < m_pages.size(); i++)
+	{
+		Page& page = m_pages[i];
+		if (page.requested < page.levels)
+		{
+			page.target = std::min(page.requested, page.coarsest);
+			page.lastUsed = m_frame;
+			page.requested = page.levels;
+		}
+	}
+
+	//la rgion de l'image a t lue par la carte graphique il y a STREAM_REGIONS images : l'attente est presque toujours nulle
+	m_staging.beginFrame();
+	m_bands.clear();
+
+	//le budget a pu baisser : on rend d'abord ce que l'image n'utilise pas
+	while (m_budget != 0 && m_residentBytes > m_budget && evictFor(-1)) {
+	}
+
+	size_t budget = TEXTURE_UPLOAD_BYTES_PER_FRAME;
+	while (budget > 0)
+	{
+		if (m_uploadPage < 0)
+		{
+			int page = nextUpload();
+			if (page < 0 || !beginUpload(page)) {
+				break;
+			}
+		}
+		size_t copied = continueUpload(budget);
+		if (copied == 0) {
+			break;
+		}
+		budget -= std::min(budget, copied);
+	}
+	m_staging.flush();
+	sendBands();
+	m_staging.endFrame();
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+//parmi les pages de l'image, celle  qui il manque le plus de niveaux
+int TextureResidency::nextUpload() const
+{
+	int best = -1;
+	for (int i = 0; i < (int)m_pages.size(); i++)
+	{
+		const Page& page = m_pages[i];
+		if (!page.texture.isValid() || page.lastUsed != m_frame || page.baseLevel <= page.target) {
+			continue;
+		}
+		if (best < 0 || page.baseLevel - page.target > m_pages[best].baseLevel - m_pages[best].target) {
+			best = i;
+		}
+	}
+	return best;
+}
+
+//Une page peut cder son niveau le plus fin s'il est plus fin que ce qu'elle demande, ou si elle a servi moins rcemment que keep.
+//Les niveaux inutiles partent en premier, puis ceux des pages les plus anciennes.
+bool TextureResidency::evictFor(int keep)
+{
+	uint32_t keepUsed = keep < 0 ? m_frame : m_pages[keep].lastUsed;
+	int victim = -1;
+	bool victimUnneeded = false;
+	for (int i = 0; i < (int)m_pages.size(); i++)
+	{
+		const Page& page = m_pages[i];
+		if (i == keep || i == m_uploadPage || hasBands(i) || !page.texture.isValid() || page.baseLevel >= page.coarsest) {
+			continue;
+		}
+		bool unneeded = page.baseLevel < page.target;
+		if (!unneeded && page.lastUsed >= keepUsed) {
+			continue;
+		}
+		if (victim < 0 || (unneeded && !victimUnneeded) || (unneeded == victimUnneeded && page.lastUsed < m_pages[victim].lastUsed))
+		{
+			victim = i;
+			victimUnneeded = unneeded;
+		}
+	}
+	if (victim < 0) {
+		return false;
+	}
+	evict(victim);
+	return true;
+}
+
+//un niveau fini pendant l'image n'est pas encore copi depuis l'anneau : il ne peut pas tre libr avant sendBands()
+bool TextureResidency::hasBands(int page) const
+{
+	for (size_t i = 0; i < m_bands.size(); i++)
+	{
+		if (m_bands[i].page == page) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//le niveau sort de l'intervalle chantillonn avant d'tre redfini vide, ce qui libre sa mmoire
+void TextureResidency::evict(int index)
+{
+	Page& page = m_pages[index];
+	int level = page.baseLevel;
+	glBindTexture(GL_TEXTURE_2D_ARRAY, page.texture.get());
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, level + 1);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, 0, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	size_t bytes = levelBytes(page, level);
+	page.bytes -= bytes;
+	m_resources.resizeTexture(page.texture, page.bytes);
+	m_residentBytes -= bytes;
+	page.baseLevel = level + 1;
+	m_evictions++;
+}
+
+//le niveau est allou en entier, mais reste hors de GL_TEXTURE_BASE_LEVEL tant que toutes ses lignes ne sont pas arrives
+bool TextureResidency::beginUpload(int index)
+{
+	Page& page = m_pages[index];
+	int level = page.baseLevel - 1;
+	size_t bytes = levelBytes(page, level);
+	while (m_budget != 0 && m_residentBytes + bytes > m_budget)
+	{
+		if (!evictFor(index)) {
+			return false;
+		}
+	}
+	if (!m_resources.resizeTexture(page.texture, page.bytes + bytes)) {
+		return false;
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, page.texture.get());
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, levelWidth(page, level), levelHeight(page, level), page.layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	page.bytes += bytes;
+	m_residentBytes += bytes;
+	m_uploadPage = index;
+	m_uploadLevel = level;
+	m_uploadRow = 0;
+	return true;
+}
+
+size_t TextureResidency::continueUpload(size_t budget)
+{
+	Page& page = m_pages[m_uploadPage];
+	int width = levelWidth(page, m_uploadLevel);
+	int height = levelHeight(page, m_uploadLevel);
+	size_t rowBytes = 4 * (size_t)width;
+	int totalRows = height * page.layers;
+	int rows = (int)std::min((size_t)(totalRows - m_uploadRow), budget / rowBytes);
+
+	//les lignes des couches se suivent : une bande ne dborde jamais d'une couche sur la suivante
+	int sent = 0;
+	while (sent < rows)
+	{
+		Band band;
+		band.page = m_uploadPage;
+		band.level = m_uploadLevel;
+		band.layer = m_uploadRow / height;
+		band.y = m_uploadRow % height;
+		band.rows = std::min(rows - sent, height - band.y);
+		size_t bytes = band.rows * rowBytes;
+		void* destination = m_staging.allocate(bytes, 4, band.offset);
+		if (destination == NULL) {
+			break;
+		}
+		memcpy(destination, &page.mipmaps[m_uploadLevel][((size_t)band.layer * height + band.y) * rowBytes], bytes);
+		m_uploadRow += band.rows;
+		sent += band.rows;
+		band.last = m_uploadRow == totalRows;
+		m_bands.push_back(band);
+	}
+	m_uploadedBytes += sent * rowBytes;
+
+	if (m_uploadRow == totalRows)
+	{
+		page.baseLevel = m_uploadLevel;
+		m_uploadPage = -1;
+	}
+	return sent * rowBytes;
+}
+
+//les copies partent de l'anneau dans l'ordre des commandes : les draw calls qui suivent voient dj le niveau complet
+void TextureResidency::sendBands()
+{
+	if (m_bands.empty()) {
+		return;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_staging.getBuffer());
+	for (size_t i = 0; i < m_bands.size(); i++)
+	{
+		const Band& band = m_bands[i];
+		const Page& page = m_pages[band.page];
+		glBindTexture(GL_TEXTURE_2D_ARRAY, page.texture.get());
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, band.level, 0, band.y, band.layer, levelWidth(page, band.level), band.rows, 1, GL_RGBA, GL_UNSIGNED_BYTE, (const void*)band.offset);
+		if (band.last) {
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, band.level);
+		}
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+int TextureResidency::getPendingUploads() const
+{
+	int pending = 0;
+	for (size_t i = 0; i < m_pages.size(); i++)
+	{
+		const Page& page = m_pages[i];
+		if (page.texture.isValid() && page.lastUsed == m_frame) {
+			pending += std::max(0, page.baseLevel - page.target);
+		}
+	}
+	return pending;
+}
+
+void TextureResidency::printReport() const
+{
+	if (m_pages.empty()) {
+		return;
+	}
+	if (m_budget != 0) {
+		printf("Texture residency : %.2f MB resident of a %.2f MB budget", m_residentBytes / (1024.0 * 1024.0), m_budget / (1024.0 * 1024.0));
+	}
+	else {
+		printf("Texture residency : %.2f MB resident, no budget", m_residentBytes / (1024.0 * 1024.0));
+	}
+	printf(", %d levels pending, %llu evictions, %.2f MB uploaded\n", getPendingUploads(), (unsigned long long)m_evictions, m_uploadedBytes / (1024.0 * 1024.0));
+	for (size_t i = 0; i < m_pages.size(); i++)
+	{
+		const Page& page = m_pages[i];
+		if (page.texture.isValid()) {
+			printf("    page %d : %dx%dx%d, levels %d to %d resident, level %d wanted\n", (int)i, page.width, page.height, page.layers, page.baseLevel, page.levels - 1, page.target);
+		}
+	}
+}
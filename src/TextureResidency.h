@@ -0,0 +1,114 @@
+#ifndef TEXTURERESIDENCY_H
+#define TEXTURERESIDENCY_H
+
+//OpenGL Libraries
+#include <GL/glew.h>
+
+#include "GpuResources.h"
+#include "StreamBuffer.h"
+#include "TexturePacker.h"
+
+#include "algorithm"
+#include "stdint.h"
+#include "vector"
+
+#define TEXTURE_UPLOAD_BYTES_PER_FRAME (2 << 20) //octets de mipmaps envoys au plus par image, par bandes de lignes
+#define TEXTURE_RESIDENT_SIZE 64 //les niveaux de 64 pixels de ct ou moins ne quittent jamais la carte graphique
+
+//Rsidence des pages de textures sous un budget mmoire. Chaque page garde sur le processeur toute sa chane de mipmaps,
+//la carte graphique n'a que les niveaux de GL_TEXTURE_BASE_LEVEL au plus grossier.
+//Les draw calls de l'image demandent le niveau dont chaque figure a besoin d'aprs sa taille  l'cran. Les niveaux manquants
+//sont envoys un par un, du plus grossier au plus fin, par bandes d'au plus TEXTURE_UPLOAD_BYTES_PER_FRAME octets par image :
+//en attendant, la figure est dessine avec le niveau dj prsent, rien n'attend le chargement.
+//Les bandes sont copies dans un StreamBuffer lu comme GL_PIXEL_UNPACK_BUFFER : le processeur ne fait qu'crire dans la mmoire
+//mappe, la copie vers la texture est faite par la carte graphique pendant que les images suivantes remplissent les autres rgions.
+//Pour rester sous le budget, les niveaux les plus fins des pages utilises le moins rcemment sont librs.
+class TextureResidency
+{
+public:
+	TextureResidency(GpuResourceManager& resources);
+
+	//cre l'anneau des envois, renvoie false en cas d'chec
+	bool init();
+
+	//octets des niveaux chargs, 0 = illimit. Les niveaux toujours prsents restent chargs mme au-del.
+	void setBudget(size_t budget) { m_budget = budget; }
+
+	//calcule les mipmaps de la page et charge ses niveaux toujours prsents. Renvoie l'indice de la page,
+	//dont la texture est vide si la mmoire manque.
+	int addPage(const TexturePage& page, const char* label);
+	GLuint getTexture(int page) const { return m_pages[page].texture.get(); }
+	int getPageCount() const { return (int)m_pages.size(); }
+
+	//une figure de l'image lit le rectangle scaleU x scaleV de la page, et couvre screenWidth x screenHeight pixels
+	void request(int page, float scaleU, float scaleV, float screenWidth, float screenHeight);
+	//aprs les demandes de l'image : libre et charge des niveaux, en laissant la texture 0 lie sur l'unit active
+	void update();
+
+	size_t getResidentBytes() const { return m_residentBytes; }
+	//niveaux demands par la dernire image qui ne sont pas encore chargs, y compris celui en cours d'envoi
+	int getPendingUploads() const;
+	uint64_t getEvictions() const { return m_evictions; }
+	void printReport() const;
+
+private:
+	struct Page {
+		GpuTexture texture;
+		int width;
+		int height;
+		int layers;
+		int levels;
+		std::vector<std::vector<uint8_t> > mipmaps; //tous les niveaux, couches  la suite
+		int coarsest; //premier niveau toujours prsent
+		int baseLevel; //niveau le plus fin charg
+		size_t bytes; //niveaux chargs, avec celui en cours d'envoi
+		int target; //niveau le plus fin demand lors de la dernire utilisation
+		int requested; //niveau le plus fin demand pendant l'image, levels sans demande
+		uint32_t lastUsed; //dernire image o une figure l'a demande
+	};
+
+	size_t levelBytes(const Page& page, int level) const;
+	int levelWidth(const Page& page, int level) const { return std::max(1, page.width >> level); }
+	int levelHeight(const Page& page, int level) const { return std::max(1, page.height >> level); }
+
+	//page dont le prochain niveau doit tre charg, -1 si aucune
+	int nextUpload() const;
+	//libre un niveau d'une page moins utile que celle de rang keep (-1 : toute page hors de l'image), false s'il n'y en a pas
+	bool evictFor(int keep);
+	void evict(int page);
+	bool hasBands(int page) const;
+	bool beginUpload(int page);
+	//copie dans l'anneau au plus budget octets du niveau en cours, renvoie les octets copis (0 si l'anneau est plein)
+	size_t continueUpload(size_t budget);
+	//glTexSubImage3D des bandes de l'image, depuis l'anneau
+	void sendBands();
+
+	//bande de lignes d'une couche, en attente dans l'anneau
+	struct Band {
+		int page;
+		int level;
+		int y;
+		int layer;
+		int rows;
+		GLintptr offset;
+		bool last; //dernire bande du niveau : il entre dans GL_TEXTURE_BASE_LEVEL
+	};
+
+	GpuResourceManager& m_resources;
+	std::vector<Page> m_pages;
+	size_t m_budget;
+	size_t m_residentBytes;
+	uint32_t m_frame;
+	StreamBuffer m_staging; //une rgion de TEXTURE_UPLOAD_BYTES_PER_FRAME octets par image
+	std::vector<Band> m_bands;
+
+	//niveau en cours d'envoi, ligne par ligne sur toutes les couches
+	int m_uploadPage;
+	int m_uploadLevel;
+	int m_uploadRow;
+
+	uint64_t m_evictions;
+	uint64_t m_uploadedBytes;
+};
+
+#endif
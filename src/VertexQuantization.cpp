@@ -0,0 +1,198 @@
+#include "VertexQuantization.h"
+
+#include "algorithm"
+#include "math.h"
+#include "stdio.h"
+#include "string.h"
+
+//conversion arrondie au plus proche (pair en cas d'galit), les valeurs trop grandes deviennent l'infini
+static uint16_t toHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000;
+	int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = bits & 0x7fffff;
+	if (exponent >= 31) {
+		return (uint16_t)(sign | 0x7c00);
+	}
+
+	uint32_t half;
+	int shift;
+	if (exponent <= 0)
+	{
+		//dnormalis : la mantisse avec son 1 implicite est dcale d'autant plus que l'exposant est petit
+		if (exponent < -10) {
+			return (uint16_t)sign;
+		}
+		mantissa |= 0x800000;
+		shift = 14 - exponent;
+		half = mantissa >> shift;
+	}
+	else
+	{
+		shift = 13;
+		half = ((uint32_t)exponent << 10) | (mantissa >> shift);
+	}
+	//la retenue peut passer dans l'exposant, ce qui donne encore le bon rsultat
+	uint32_t rest = mantissa & ((1u << shift) - 1);
+	uint32_t halfway = 1u << (shift - 1);
+	if (rest > halfway || (rest == halfway && (half & 1))) {
+		half++;
+	}
+	return (uint16_t)(sign | half);
+}
+
+static float fromHalf(uint16_t half)
+{
+	int exponent = (half >> 10) & 0x1f;
+	int mantissa = half & 0x3ff;
+	float value;
+	if (exponent == 0) {
+		value = ldexpf((float)mantissa, -24);
+	}
+	else if (exponent == 31) {
+		value = INFINITY;
+	}
+	else {
+		value = ldexpf((float)(mantissa + 1024), exponent - 25);
+	}
+	return (half & 0x8000) ? -value : value;
+}
+
+static float signNotZero(float value)
+{
+	return value >= 0.f ? 1.f : -1.f;
+}
+
+//mme calcul que decodeNormal() dans color.vert
+static glm::vec3 decodeNormal(int8_t x, int8_t y)
+{
+	glm::vec3 n(x / (float)QUANTIZED_NORMAL_MAX, y / (float)QUANTIZED_NORMAL_MAX, 0.f);
+	n.z = 1.f - fabsf(n.x) - fabsf(n.y);
+	if (n.z < 0.f)
+	{
+		float foldedX = (1.f - fabsf(n.y)) * signNotZero(n.x);
+		float foldedY = (1.f - fabsf(n.x)) * signNotZero(n.y);
+		n.x = foldedX;
+		n.y = foldedY;
+	}
+	return glm::normalize(n);
+}
+
+//Parmi les quatre arrondis voisins de la projection, garde celui dont la normale dcode est la plus proche
+static void encodeNormal(const glm::vec3& normal, int8_t encoded[2])
+{
+	float length = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	if (length <= 0.f)
+	{
+		encoded[0] = encoded[1] = 0;
+		return;
+	}
+	glm::vec3 n = normal / length;
+	float u = n.x, v = n.y;
+	if (n.z < 0.f)
+	{
+		u = (1.f - fabsf(n.y)) * signNotZero(n.x);
+		v = (1.f - fabsf(n.x)) * signNotZero(n.y);
+	}
+
+	glm::vec3 unit = glm::normalize(normal);
+	float scaledU = u * QUANTIZED_NORMAL_MAX;
+	float scaledV = v * QUANTIZED_NORMAL_MAX;
+	float best = -2.f;
+	for (int candidate = 0; candidate < 4; candidate++)
+	{
+		float cu = (candidate & 1) ? ceilf(scaledU) : floorf(scaledU);
+		float cv = (candidate & 2) ? ceilf(scaledV) : floorf(scaledV);
+		int8_t x = (int8_t)std::max(-(float)QUANTIZED_NORMAL_MAX, std::min((float)QUANTIZED_NORMAL_MAX, cu));
+		int8_t y = (int8_t)std::max(-(float)QUANTIZED_NORMAL_MAX, std::min((float)QUANTIZED_NORMAL_MAX, cv));
+		float similarity = glm::dot(decodeNormal(x, y), unit);
+		if (similarity > best)
+		{
+			best = similarity;
+			encoded[0] = x;
+			encoded[1] = y;
+		}
+	}
+}
+
+void quantizeMesh(const float* positions, const float* normals, const float* uvs, int nbVertices, QuantizedMesh& out)
+{
+	glm::vec3 boxMin(1e30f, 1e30f, 1e30f);
+	glm::vec3 boxMax(-1e30f, -1e30f, -1e30f);
+	for (int i = 0; i < nbVertices; i++)
+	{
+		glm::vec3 p(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+		boxMin = glm::min(boxMin, p);
+		boxMax = glm::max(boxMax, p);
+	}
+	if (nbVertices == 0) {
+		boxMin = boxMax = glm::vec3(0.f, 0.f, 0.f);
+	}
+	out.boxMin = boxMin;
+	out.boxExtent = boxMax - boxMin;
+
+	out.vertices.resize(nbVertices);
+	for (int i = 0; i < nbVertices; i++)
+	{
+		QuantizedVertex& vertex = out.vertices[i];
+		for (int c = 0; c < 3; c++)
+		{
+			//une figure plate sur un axe y garde 0 : le dcodage redonne boxMin
+			float extent = out.boxExtent[c];
+			float t = extent > 0.f ? (positions[3 * i + c] - boxMin[c]) / extent : 0.f;
+			vertex.position[c] = (uint16_t)(std::max(0.f, std::min(1.f, t)) * QUANTIZED_POSITION_MAX + 0.5f);
+		}
+		encodeNormal(glm::vec3(normals[3 * i], normals[3 * i + 1], normals[3 * i + 2]), vertex.normal);
+		vertex.uv[0] = toHalf(uvs[2 * i]);
+		vertex.uv[1] = toHalf(uvs[2 * i + 1]);
+	}
+}
+
+void dequantizeVertex(const QuantizedMesh& mesh, const QuantizedVertex& vertex, glm::vec3& position, glm::vec3& normal, glm::vec2& uv)
+{
+	glm::vec3 t(vertex.position[0], vertex.position[1], vertex.position[2]);
+	position = t / (float)QUANTIZED_POSITION_MAX * mesh.boxExtent + mesh.boxMin;
+	normal = decodeNormal(vertex.normal[0], vertex.normal[1]);
+	uv = glm::vec2(fromHalf(vertex.uv[0]), fromHalf(vertex.uv[1]));
+}
+
+QuantizationError measureQuantizationError(const float* positions, const float* normals, const float* uvs, int nbVertices, const QuantizedMesh& mesh)
+{
+	QuantizationError error = { 0.f, 0.f, 0.f };
+	for (int i = 0; i < nbVertices; i++)
+	{
+		glm::vec3 position, normal;
+		glm::vec2 uv;
+		dequantizeVertex(mesh, mesh.vertices[i], position, normal, uv);
+
+		glm::vec3 original(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+		error.position = std::max(error.position, glm::length(position - original));
+
+		glm::vec3 originalNormal(normals[3 * i], normals[3 * i + 1], normals[3 * i + 2]);
+		if (glm::length(originalNormal) > 0.f)
+		{
+			float cosine = std::max(-1.f, std::min(1.f, glm::dot(normal, glm::normalize(originalNormal))));
+			error.normalDegrees = std::max(error.normalDegrees, acosf(cosine) * 180.f / (float)M_PI);
+		}
+
+		error.uv = std::max(error.uv, std::max(fabsf(uv.x - uvs[2 * i]), fabsf(uv.y - uvs[2 * i + 1])));
+	}
+	return error;
+}
+
+void reportQuantization(const char* name, const float* positions, const float* normals, const float* uvs, int nbVertices)
+{
+	QuantizedMesh mesh;
+	quantizeMesh(positions, normals, uvs, nbVertices, mesh);
+	QuantizationError error = measureQuantizationError(positions, normals, uvs, nbVertices, mesh);
+
+	//createMesh() envoyait les positions deux fois, avec les uvs puis avec les normales
+	size_t floatBytes = (size_t)nbVertices * (3 + 2 + 3 + 3) * sizeof(float);
+	size_t quantizedBytes = (size_t)nbVertices * sizeof(QuantizedVertex);
+	float diagonal = glm::length(mesh.boxExtent);
+	printf("%-10s %7d vertices : %9zu -> %8zu bytes (x%.2f), max error position %.3g (%.3g of the box diagonal), normal %.4f deg, uv %.3g\n",
+		name, nbVertices, floatBytes, quantizedBytes, quantizedBytes > 0 ? (double)floatBytes / quantizedBytes : 0.0,
+		error.position, diagonal > 0.f ? error.position / diagonal : 0.f, error.normalDegrees, error.uv);
+}
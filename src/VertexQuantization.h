@@ -0,0 +1,42 @@
+#ifndef VERTEXQUANTIZATION_H
+#define VERTEXQUANTIZATION_H
+
+#include <glm/glm.hpp>
+
+#include "stdint.h"
+#include "vector"
+
+#define QUANTIZED_POSITION_MAX 65535 //pas de la position dans la bote englobante, sur 16 bits non signs
+#define QUANTIZED_NORMAL_MAX   127 //composantes de la normale en octadre, sur 8 bits signs
+
+//Sommet compact lu par color.vert : 12 octets au lieu des 44 envoys jusque-l (positions en double, normales et uvs en floats)
+struct QuantizedVertex {
+	uint16_t position[3]; //xyz dans la bote englobante de la figure
+	int8_t normal[2]; //normale projete sur l'octadre |x| + |y| + |z| = 1, la moiti z < 0 replie sur le carr
+	uint16_t uv[2]; //demi-flottants
+};
+
+//position = boxMin + position / QUANTIZED_POSITION_MAX * boxExtent
+struct QuantizedMesh {
+	std::vector<QuantizedVertex> vertices;
+	glm::vec3 boxMin;
+	glm::vec3 boxExtent;
+};
+
+//Mme format d'entre que createMesh() : 3 floats par position et par normale, 2 par uv
+void quantizeMesh(const float* positions, const float* normals, const float* uvs, int nbVertices, QuantizedMesh& out);
+//dcodage sur le processeur, identique  celui de color.vert
+void dequantizeVertex(const QuantizedMesh& mesh, const QuantizedVertex& vertex, glm::vec3& position, glm::vec3& normal, glm::vec2& uv);
+
+//Plus grands carts entre les sommets d'origine et les sommets dcods
+struct QuantizationError {
+	float position; //en units de la figure
+	float normalDegrees;
+	float uv;
+};
+
+QuantizationError measureQuantizationError(const float* positions, const float* normals, const float* uvs, int nbVertices, const QuantizedMesh& mesh);
+//Quantifie la figure et affiche sa taille avant et aprs et l'erreur maximale
+void reportQuantization(const char* name, const float* positions, const float* normals, const float* uvs, int nbVertices);
+
+#endif
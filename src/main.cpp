@@ -11,111 +11,246 @@
 #include <glm/gtc/matrix_transform.hpp> 
 #include <glm/gtc/type_ptr.hpp>
 
-#include "Shader.h"
-
 #include <SDL2/SDL_image.h>
 
 #include "logger.h"
 
 // objects 3D
-#include "Sphere.h"
 #include "Cube.h"
-#include "Cylinder.h"
+
+#include "Animation.h"
+#include "Replay.h"
+#include "RenderBackend.h"
+#include "GLBackend.h"
+#include "SoftwareBackend.h"
+#include "MultiDrawBackend.h"
+#include "BallPhysics.h"
+#include "ParticleSystem.h"
+#include "FrameCapture.h"
+#include "DynamicResolution.h"
+#include "AllocationCounter.h"
+#include "Tessellation.h"
+#include "StereoCamera.h"
+#include "VertexQuantization.h"
+#include "JobSystem.h"
+#include "SceneBvh.h"
+#include "FramePacer.h"
 
 //libraries supplmentaires
 #include "vector"
+#include "algorithm"
 #include "math.h"
 #include "stdlib.h"
+#include "string.h"
+#include "time.h"
 
 //On dfinit une fentre carre pour viter tout problme de rotation ou scaling.
 #define WIDTH     1000
 #define HEIGHT    1000
-#define FRAMERATE 60
-#define TIME_PER_FRAME_MS  (1.0f/FRAMERATE * 1e3)
-#define INDICE_TO_PTR(x) ((void*)(x))
-
-
-//On dfinit ici les paramtres ncessaires pour crer un matriau. La couleur est inutilise dans ce projet.
-struct Material {
-	glm::vec3 color;
-	float ka;
-	float kd;
-	float ks;
-	float alpha;
+#define FRAMERATE 60 //images par seconde des clips et de la trajectoire de la balle, et frquence d'affichage par dfaut
+
+//Dures de l'animation en images. Une phase correspond  0.6 de dplacement de la balle (0.03 par image).
+#define SWING_PHASE_FRAMES  20
+#define CROSSING_FRAMES     (3 * SWING_PHASE_FRAMES + 1) //une traverse de la table plus l'image de renvoi
+#define SWING_PERIOD_FRAMES (2 * CROSSING_FRAMES)
+#define SWING_KEY_STEP      5 //cart entre deux cls des clips, en images
+#define DRILL_RENDERED_BALLS 256 //balles d'entranement affiches au plus, les autres sont seulement simules
+#define FLOAT_PERIOD_FRAMES 120
+#define TRAIL_PARTICLES_PER_FRAME 12 //particules laisses derrire la balle  chaque image
+#define HIT_SPARKS          400 //tincelles  chaque renvoi de la balle anime
+#define DRILL_HIT_SPARKS    40 //tincelles quand une balle d'entranement touche une raquette
+#define RENDER_BUDGET_RATIO 0.9f //part de la priode d'affichage vise par la rsolution dynamique, le reste de l'image va  la simulation
+#define RENDER_SCALE_STEP   0.1f //pas des touches Page up / Page down
+#define SCENE_SLICES        32 //subdivisions des sphres et des cylindres partags par toutes les figures
+
+
+//Options de la ligne de commande
+struct Options {
+	const char* recordPath = NULL; //--record fichier : enregistre les entres et la graine de rand()
+	const char* replayPath = NULL; //--replay fichier : rejoue un enregistrement  l'identique
+	const char* timingsPath = NULL; //--timings fichier : crit la dure de chaque image
+	bool headless = false; //--headless : fentre cache et pas de limite de framerate
+	int frameRate = FRAMERATE; //--fps n : frquence d'affichage vise (60, 120, 144...), la simulation avance d'une image par affichage
+	int swapInterval = SWAP_INTERVAL_AUTO; //--vsync n : 0 sans synchronisation verticale, 1 avec, -1 adaptative, par dfaut selon l'cran
+	const char* capturePath = NULL; //--capture fichier : enregistre chaque image (frame%05d.png ou video.y4m)
+	int vramBudget = 0; //--vram-budget Mo : mmoire maximale des buffers et textures OpenGL, 0 = illimite
+	int textureBudget = 0; //--texture-budget Mo : mipmaps des textures gards sur la carte graphique, les moins rcemment utiliss sont librs, 0 = illimit
+	bool software = false; //--software : rendu sur le processeur (tuiles, tous les coeurs), sans contexte OpenGL
+	int drillBalls = 0; //--drill n : lance n balles simules sur la table en plus de l'change anim
+	int physicsBenchmark = 0; //--physics-bench n : mesure la simulation de n balles et quitte
+	int particleBenchmark = 0; //--particle-bench n : mesure la mise  jour de n particules et quitte
+	int tessellationBenchmark = 0; //--tessellation-bench n : mesure la gnration d'une sphre n x n et d'un cylindre  n secteurs et quitte
+	int jobBenchmark = 0; //--job-bench n : mesure le cot d'ordonnancement de n tches sur 1 thread jusqu' tous les coeurs et quitte
+	bool pickBenchmark = false; //--pick-bench : mesure la construction du BVH et le dbit de rayons sur 10 000 et 1 000 000 de figures et quitte
+	int threads = 0; //--threads n : threads du systme de tches, thread principal compris, 0 = tous les coeurs
+	bool vertexReport = false; //--vertex-report : affiche la taille des sommets quantifis et l'erreur maximale de chaque maillage de la scne et quitte
+	bool multiDraw = false; //--multidraw : toute la scne en un seul glMultiDrawElementsIndirect (OpenGL 4.3)
+	bool occlusionCulling = true; //--no-occlusion : ni pyramide de profondeur, ni pr-passe, pour comparer
+	bool bloom = true; //--no-bloom : image HDR seulement tonemappe, sans halo autour des surfaces brillantes
+	bool shadows = true; //--no-shadows : ni carte d'ombre, ni PCF, pour comparer. --multidraw et --software n'ont jamais d'ombres.
+	float renderScale = 1.f; //--render-scale s : largeur et hauteur de l'image rendue relatives  la fentre
+	bool dynamicResolution = false; //--dynamic-resolution : l'chelle de rendu suit la dure de rendu mesure
+	bool allocationStats = false; //--alloc-stats : signale les images qui allouent sur le tas aprs l'chauffement et affiche un bilan
+	bool stereo = false; //--stereo : les deux yeux cte  cte, rendus en une seule passe
+	float ipd = STEREO_IPD; //--ipd mm : cart entre les yeux
+	float convergence = STEREO_CONVERGENCE; //--convergence d : distance o les deux images concident
+	bool stereoCompare = false; //--stereo-compare : alterne vue unique et stro  chaque image et compare leur temps de rendu sur le processeur
 };
 
-//On dfinit les paramtres ncessaires pour crer une lumire. On a donn une valeur par dfaut  chaque paramtres car ceux de nos diffrentes lumires varient peu.
-struct Light {
-	glm::vec3 position = glm::vec3(0.f,0.4f,-46.f);
-	glm::mat4 Coordinates = glm::translate(glm::mat4(1.0f), position);
-	glm::vec3 color = glm::vec3(0.7f, 0.65f, 0.8f);
+//Les articulations animes par le clip de flottement. Les deux genoux d'un personnage ont le mme mouvement.
+enum FloatJoint { FLOAT_BODY, FLOAT_KNEE, NB_FLOAT_JOINTS };
+
+//Image RGBA8 dcode sur le processeur, en attendant d'tre donne au moteur de rendu
+struct DecodedImage {
+	const char* source;
+	bool mirrored; //colonnes inverses, comme pour les figures
+	int width; //0 si l'image n'a pas pu tre lue
+	int height;
+	std::vector<uint8_t> pixels;
+	int texture; //indice dans le moteur de rendu, -1 tant que loadTexture() ne l'a pas envoye
 };
 
-//La mthode generate() permet d'instancier les buffers associs  une figure, sa texture et sa lumire,  et les rcuprer
-std::vector<GLuint> generate(Geometry g, const char* source)
-{
-	const float* data = g.getVertices(); //get the vertices created by the cube.
-	const float* normals = g.getNormals(); //Get the normal vectors
-	const float* uvs = g.getUVs(); //Get the uv vectors
-	int nbVertices = g.getNbVertices();
+//images dcodes en parallle par le graphe de chargement avant la cration des figures, pour que chaque fichier ne soit lu qu'une fois
+static std::vector<DecodedImage> decodedImages;
 
+//decodeImage() lit image.source. Ne parle pas au moteur de rendu : peut tourner sur n'importe quel thread.
+void decodeImage(DecodedImage& image)
+{
+	image.width = 0;
+	image.height = 0;
+	image.texture = -1;
+	SDL_Surface* img = IMG_Load(image.source);
+	if (img == NULL) {
+		return;
+	}
 	//Convert to an RGBA8888 surface
-	SDL_Surface* img = IMG_Load(source);
 	SDL_Surface* rgbImg = SDL_ConvertSurfaceFormat(img, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(img);
+	if (rgbImg == NULL) {
+		return;
+	}
 
-	uint8_t* imgInverted = (uint8_t*)malloc(sizeof(uint8_t) * 4 * rgbImg->w*rgbImg->h);
-	for (uint32_t j = 0; j < rgbImg->h; j++)
+	image.width = rgbImg->w;
+	image.height = rgbImg->h;
+	image.pixels.resize(4 * (size_t)rgbImg->w * rgbImg->h);
+	for (int j = 0; j < rgbImg->h; j++)
 	{
-		for (uint32_t i = 0; i < rgbImg->w; i++)
+		const uint8_t* row = (const uint8_t*)rgbImg->pixels + (size_t)j * rgbImg->pitch;
+		uint8_t* out = &image.pixels[4 * (size_t)j * rgbImg->w];
+		if (!image.mirrored)
 		{
-			for (uint8_t k = 0; k < 4; k++)
-			{
-				uint32_t oldID = 4 * (j*rgbImg->w + i) + k;
-				uint32_t newID = 4 * (j*rgbImg->w + rgbImg->w - 1 - i) + k;
+			memcpy(out, row, 4 * (size_t)rgbImg->w);
+			continue;
+		}
+		for (int i = 0; i < rgbImg->w; i++) {
+			memcpy(out + 4 * (rgbImg->w - 1 - i), row + 4 * i, 4);
+		}
+	}
+	SDL_FreeSurface(rgbImg);
+}
 
-				imgInverted[newID] = ((uint8_t*)(rgbImg->pixels))[oldID];
-			}
+//findImage() renvoie l'image dj dcode, ou la dcode sur ce thread si le graphe de chargement ne l'avait pas prvue
+DecodedImage& findImage(const char* source, bool mirrored)
+{
+	for (size_t i = 0; i < decodedImages.size(); i++)
+	{
+		if (decodedImages[i].mirrored == mirrored && strcmp(decodedImages[i].source, source) == 0) {
+			return decodedImages[i];
 		}
 	}
+	DecodedImage image;
+	image.source = source;
+	image.mirrored = mirrored;
+	decodeImage(image);
+	decodedImages.push_back(image);
+	return decodedImages.back();
+}
 
-	SDL_FreeSurface(img);
+//loadTexture() donne une image au moteur de rendu, renvoie l'indice de la texture ou -1.
+//Les figures qui utilisent le mme fichier partagent la mme texture, et donc la mme place dans les pages.
+int loadTexture(RenderBackend* backend, const char* source)
+{
+	DecodedImage& image = findImage(source, true);
+	if (image.width == 0)
+	{
+		ERROR("Could not load the texture %s\n", source);
+		return -1;
+	}
+	if (image.texture < 0) {
+		image.texture = backend->createTexture(&image.pixels[0], image.width, image.height);
+	}
+	return image.texture;
+}
 
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_2D, textureID);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+//La mthode generate() permet d'associer un maillage dj dans le moteur de rendu  une texture, et de rcuprer les deux
+std::vector<int> generate(RenderBackend* backend, int mesh, const char* source)
+{
+	std::vector<int> tab;
+	tab.push_back(mesh);
+	tab.push_back(loadTexture(backend, source));
+	return tab;
+}
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+//Mme chose pour une figure du squelette, dont les buffers sont instancis dans le moteur de rendu
+std::vector<int> generate(RenderBackend* backend, Geometry g, const char* source)
+{
+	const float* data = g.getVertices(); //get the vertices created by the cube.
+	const float* normals = g.getNormals(); //Get the normal vectors
+	const float* uvs = g.getUVs(); //Get the uv vectors
+	int mesh = backend->createMesh(data, normals, uvs, g.getNbVertices());
+	return generate(backend, mesh, source);
+}
 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, rgbImg->w, rgbImg->h, 0,
-		GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)imgInverted);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	free(imgInverted);
-	SDL_FreeSurface(rgbImg);
+//generateSphere() et generateCylinder() tessellent une forme dans des tableaux temporaires et la donnent au moteur de rendu, qui la copie
+int generateSphere(RenderBackend* backend, int slices, int stacks)
+{
+	int nbVertices = sphereVertexCount(slices, stacks);
+	std::vector<float> positions(3 * (size_t)nbVertices), normals(3 * (size_t)nbVertices), uvs(2 * (size_t)nbVertices);
+	MeshBuffers out = { &positions[0], &normals[0], &uvs[0] };
+	tessellateSphere(slices, stacks, out);
+	return backend->createMesh(out.positions, out.normals, out.uvs, nbVertices);
+}
 
-	GLuint buffer; //texture buffer
-	glGenBuffers(1, &buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, buffer);
-	glBufferData(GL_ARRAY_BUFFER, (3 + 2) * sizeof(float)*nbVertices, NULL, GL_DYNAMIC_DRAW); // 3 pour les coordonnees , 3 pour la couleur
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * 3 * nbVertices, data);
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(float) * 3 * nbVertices, 2 * sizeof(float)*nbVertices, uvs);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	GLuint buffer2; //light buffer
-	glGenBuffers(1, &buffer2);
-	glBindBuffer(GL_ARRAY_BUFFER, buffer2);
-	glBufferData(GL_ARRAY_BUFFER, (3 + 3) * sizeof(float)*nbVertices, NULL, GL_DYNAMIC_DRAW); // 3 pour les coordonnees , 3 pour la couleur
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * 3 * nbVertices, data);
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(float) * 3 * nbVertices, 3 * sizeof(float)*nbVertices, normals);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	std::vector<GLuint> tab;
-	tab.push_back(buffer);
-	tab.push_back(textureID);
-	tab.push_back(buffer2);
-	return tab;
+int generateCylinder(RenderBackend* backend, int slices)
+{
+	int nbVertices = cylinderVertexCount(slices);
+	std::vector<float> positions(3 * (size_t)nbVertices), normals(3 * (size_t)nbVertices), uvs(2 * (size_t)nbVertices);
+	MeshBuffers out = { &positions[0], &normals[0], &uvs[0] };
+	tessellateCylinder(slices, out);
+	return backend->createMesh(out.positions, out.normals, out.uvs, nbVertices);
+}
+
+//runVertexReport() quantifie les maillages de la scne comme createMesh() et affiche l'erreur de chacun, sans moteur de rendu
+void runVertexReport()
+{
+	Cube cube = Cube();
+	reportQuantization("cube", cube.getVertices(), cube.getNormals(), cube.getUVs(), cube.getNbVertices());
+
+	int nbVertices = sphereVertexCount(SCENE_SLICES, SCENE_SLICES);
+	std::vector<float> positions(3 * (size_t)nbVertices), normals(3 * (size_t)nbVertices), uvs(2 * (size_t)nbVertices);
+	MeshBuffers sphere = { &positions[0], &normals[0], &uvs[0] };
+	tessellateSphere(SCENE_SLICES, SCENE_SLICES, sphere);
+	reportQuantization("sphere", sphere.positions, sphere.normals, sphere.uvs, nbVertices);
+
+	nbVertices = cylinderVertexCount(SCENE_SLICES);
+	positions.resize(3 * (size_t)nbVertices);
+	normals.resize(3 * (size_t)nbVertices);
+	uvs.resize(2 * (size_t)nbVertices);
+	MeshBuffers cylinder = { &positions[0], &normals[0], &uvs[0] };
+	tessellateCylinder(SCENE_SLICES, cylinder);
+	reportQuantization("cylinder", cylinder.positions, cylinder.normals, cylinder.uvs, nbVertices);
+}
+
+//generateSkybox() charge un panorama quirectangulaire et le donne au moteur de rendu comme fond, renvoie -1 en cas d'chec
+int generateSkybox(RenderBackend* backend, const char* source)
+{
+	const DecodedImage& image = findImage(source, false);
+	if (image.width == 0)
+	{
+		ERROR("Could not load the skybox %s\n", source);
+		return -1;
+	}
+	return backend->createSkybox(&image.pixels[0], image.width, image.height);
 }
 
 //getMatrix() permet d'effectuer une translation de tx en x, ty en y, tz en z et effectuer une rotation de angle radians autours de l'axe dont la valeur vaut 1
@@ -139,38 +274,335 @@ glm::mat4 scaleMatrix(float sx, float sy, float sz)
 	return matrix;
 }
 
-//draw permet de dessiner la figure
-void draw(GLuint texture, GLuint buffer, GLuint buffer2, Geometry g, Shader* shader, glm::mat4 mvp, Material m, Light l, std::vector<GLint> glValues)
+//parseOptions() lit les options de la ligne de commande, renvoie false si l'une d'elles est inconnue
+bool parseOptions(int argc, char* argv[], Options& options)
 {
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glBindBuffer(GL_ARRAY_BUFFER, buffer);
-	glVertexAttribPointer(glValues[0], 3, GL_FLOAT, 0, 0, 0);
-	glEnableVertexAttribArray(glValues[0]);
-	glVertexAttribPointer(glValues[10], 2, GL_FLOAT, 0, 0, INDICE_TO_PTR(3 * sizeof(float) * g.getNbVertices()));
-	glEnableVertexAttribArray(glValues[10]);
-	glUniformMatrix4fv(glValues[3], 1, GL_FALSE, glm::value_ptr(mvp));
-	glUniform1i(glValues[9], 0);
-
-	glBindBuffer(GL_ARRAY_BUFFER, buffer2);
-	glVertexAttribPointer(glValues[0], 3, GL_FLOAT, 0, 0, 0);
-	glEnableVertexAttribArray(glValues[0]);
-	glVertexAttribPointer(glValues[1], 3, GL_FLOAT, 0, 0, INDICE_TO_PTR(sizeof(float) * 3 * g.getNbVertices()));
-	glEnableVertexAttribArray(glValues[1]);
-	glUniformMatrix4fv(glValues[3], 1, GL_FALSE, glm::value_ptr(mvp));
-	glUniformMatrix4fv(glValues[4], 1, GL_FALSE, glm::value_ptr(mvp));
-	glUniform4fv(glValues[2], 1, glm::value_ptr(glm::vec4(m.ka, m.kd, m.ks, m.alpha)));
-	glUniform3fv(glValues[5], 1, glm::value_ptr(m.color));
-	glUniform3fv(glValues[6], 1, glm::value_ptr(l.color));
-	glUniform3fv(glValues[7], 1, glm::value_ptr(l.position));
-	glUniform3fv(glValues[8], 1, glm::value_ptr(glm::vec3(0.f, 0.f, 0.f)));
-	
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glDrawArrays(GL_TRIANGLES, 0, g.getNbVertices());
-	glBindTexture(GL_TEXTURE_2D, 0);
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			options.recordPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			options.replayPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--timings") == 0 && i + 1 < argc) {
+			options.timingsPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+			options.capturePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--vram-budget") == 0 && i + 1 < argc) {
+			options.vramBudget = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc) {
+			options.textureBudget = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--drill") == 0 && i + 1 < argc) {
+			options.drillBalls = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--physics-bench") == 0 && i + 1 < argc) {
+			options.physicsBenchmark = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--particle-bench") == 0 && i + 1 < argc) {
+			options.particleBenchmark = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--tessellation-bench") == 0 && i + 1 < argc) {
+			options.tessellationBenchmark = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--job-bench") == 0 && i + 1 < argc) {
+			options.jobBenchmark = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			options.threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+			options.frameRate = std::max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--vsync") == 0 && i + 1 < argc) {
+			options.swapInterval = std::min(1, std::max(-1, atoi(argv[++i])));
+		}
+		else if (strcmp(argv[i], "--ipd") == 0 && i + 1 < argc) {
+			options.ipd = (float)atof(argv[++i]) / 1000.f;
+		}
+		else if (strcmp(argv[i], "--convergence") == 0 && i + 1 < argc) {
+			options.convergence = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--render-scale") == 0 && i + 1 < argc) {
+			options.renderScale = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--headless") == 0) {
+			options.headless = true;
+		}
+		else if (strcmp(argv[i], "--software") == 0) {
+			options.software = true;
+		}
+		else if (strcmp(argv[i], "--multidraw") == 0) {
+			options.multiDraw = true;
+		}
+		else if (strcmp(argv[i], "--no-occlusion") == 0) {
+			options.occlusionCulling = false;
+		}
+		else if (strcmp(argv[i], "--no-bloom") == 0) {
+			options.bloom = false;
+		}
+		else if (strcmp(argv[i], "--no-shadows") == 0) {
+			options.shadows = false;
+		}
+		else if (strcmp(argv[i], "--dynamic-resolution") == 0) {
+			options.dynamicResolution = true;
+		}
+		else if (strcmp(argv[i], "--alloc-stats") == 0) {
+			options.allocationStats = true;
+		}
+		else if (strcmp(argv[i], "--stereo") == 0) {
+			options.stereo = true;
+		}
+		else if (strcmp(argv[i], "--stereo-compare") == 0) {
+			options.stereoCompare = true;
+		}
+		else if (strcmp(argv[i], "--pick-bench") == 0) {
+			options.pickBenchmark = true;
+		}
+		else if (strcmp(argv[i], "--vertex-report") == 0) {
+			options.vertexReport = true;
+		}
+		else {
+			ERROR("Unknown option %s\n", argv[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+//createSwingClip() construit le coup du personnage de droite phase par phase, comme l'ancienne machine  tats : chaque phase tourne l'paule
+//autour d'un axe local  raison de PI/40 par image. Le clip se termine par un retour  la pose de repos pour pouvoir boucler.
+//Le personnage de gauche joue le mme clip dcal d'une traverse.
+AnimationClip createSwingClip()
+{
+	struct SwingPhase {
+		int frames;
+		glm::vec3 axis;
+		float speed;
+	};
+	const float step = M_PI / 40.f;
+	const SwingPhase phases[] = {
+		{ SWING_PHASE_FRAMES, glm::vec3(1, 0, 0), 0.f },   //la balle part vers le personnage de gauche
+		{ SWING_PHASE_FRAMES, glm::vec3(1, 0, 0), step },  //le bras se lve
+		{ SWING_PHASE_FRAMES, glm::vec3(0, 1, 0), step },  //le bras arme le coup
+		{ 1, glm::vec3(1, 0, 0), step },                   //renvoi de la balle
+		{ SWING_PHASE_FRAMES, glm::vec3(1, 0, 0), -step },
+		{ SWING_PHASE_FRAMES, glm::vec3(0, 0, 1), -step },
+	};
+
+	AnimationClip clip(1, SWING_PERIOD_FRAMES / (float)FRAMERATE);
+	glm::quat rotation(1.f, 0.f, 0.f, 0.f);
+	int frame = 0;
+	clip.addRotationKey(0, 0.f, rotation);
+	for (const SwingPhase& phase : phases)
+	{
+		glm::quat start = rotation;
+		for (int f = 1; f <= phase.frames; f++)
+		{
+			rotation = start * glm::angleAxis(phase.speed * f, phase.axis);
+			frame++;
+			if (f % SWING_KEY_STEP == 0 || f == phase.frames) {
+				clip.addRotationKey(0, frame / (float)FRAMERATE, rotation);
+			}
+		}
+	}
+
+	//retour  la pose de repos pendant que la balle revient, puis pause jusqu' la fin du cycle
+	glm::quat end = rotation;
+	for (int f = 1; f <= SWING_PHASE_FRAMES; f++)
+	{
+		frame++;
+		if (f % SWING_KEY_STEP == 0) {
+			clip.addRotationKey(0, frame / (float)FRAMERATE, glm::slerp(end, glm::quat(1.f, 0.f, 0.f, 0.f), f / (float)SWING_PHASE_FRAMES));
+		}
+	}
+	clip.addRotationKey(0, SWING_PERIOD_FRAMES / (float)FRAMERATE, glm::quat(1.f, 0.f, 0.f, 0.f));
+	return clip;
+}
+
+//createFloatClip() construit le flottement des personnages : le corps monte puis redescend et les genoux se plient pendant FLOAT_PERIOD_FRAMES images
+AnimationClip createFloatClip()
+{
+	const float half = FLOAT_PERIOD_FRAMES / 2.f / FRAMERATE;
+	const float bodyHeight = 0.0005f * FLOAT_PERIOD_FRAMES / 2.f; //surlvation simulant une respiration
+	const float kneeAngle = 0.002f * FLOAT_PERIOD_FRAMES / 2.f;
+
+	AnimationClip clip(NB_FLOAT_JOINTS, FLOAT_PERIOD_FRAMES / (float)FRAMERATE);
+	clip.addTranslationKey(FLOAT_BODY, 0.f, glm::vec3(0.f, 0.f, 0.f));
+	clip.addTranslationKey(FLOAT_BODY, half, glm::vec3(0.f, bodyHeight / 3.f, 2.f * bodyHeight / 3.f));
+	clip.addTranslationKey(FLOAT_BODY, 2.f * half, glm::vec3(0.f, 0.f, 0.f));
+	clip.addRotationKey(FLOAT_KNEE, 0.f, glm::quat(1.f, 0.f, 0.f, 0.f));
+	clip.addRotationKey(FLOAT_KNEE, half, glm::angleAxis(kneeAngle, glm::vec3(1, 0, 0)));
+	clip.addRotationKey(FLOAT_KNEE, 2.f * half, glm::quat(1.f, 0.f, 0.f, 0.f));
+	return clip;
+}
+
+//ballTrajectory() donne la position scripte de la balle  l'instant time (en secondes), au lieu de l'incrmenter  chaque image.
+//On renvoie (x, y, z) comme dans l'ancienne version : la balle est ensuite place en (0.9 - x, y, z - 40).
+glm::vec3 ballTrajectory(float time)
+{
+	float frame = fmodf(time * FRAMERATE, SWING_PERIOD_FRAMES);
+	bool back = frame > CROSSING_FRAMES; //la balle revient vers la droite
+	float d = 0.03f * std::min(back ? frame - CROSSING_FRAMES : frame, 3.f * SWING_PHASE_FRAMES); //distance parcourue depuis le dernier renvoi
+	float x = back ? 1.8f - d : d;
+	float y;
+	if (d <= 1.2f) {
+		y = abs(cos(d / 2.4 * M_PI)) * 0.5 + 0.05;
+	}
+	else {
+		y = abs(cos(2 * d / 2.4 * M_PI - M_PI / 2)) * 0.5 + 0.05;
+	}
+	return glm::vec3(x, y, -0.3f + x / 3.f);
+}
+
+//serveDrillBalls() lance count balles depuis la raquette de droite vers l'autre moiti de la table, avec des vitesses et des effets varis
+void serveDrillBalls(BallPhysics& physics, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		glm::vec3 position(0.85f, 0.2f + (rand() % 101) / 500.f, -40.3f + (rand() % 101) / 170.f);
+		glm::vec3 velocity(-1.6f - (rand() % 101) / 100.f, 0.4f + (rand() % 101) / 100.f, 0.3f - (rand() % 101) / 170.f);
+		glm::vec3 spin(0.f, (rand() % 101 - 50) / 2.f, (rand() % 101 - 50) * 2.f); //effet latral, lift ou coup
+		physics.addBall(position, velocity, spin);
+	}
+}
+
+//moveCamera() dplace ou tourne la camra selon la touche appuye
+void moveCamera(SDL_Keycode key, glm::vec3& cameraPos, glm::vec3& cameraFront)
+{
+	if (key == SDLK_UP) {
+		if (cameraPos.y < 10) {
+			cameraPos.y += 0.20f;
+		}
+	}
+	if (key == SDLK_DOWN) {
+		if (cameraPos.y > -10) {
+			cameraPos.y -= 0.20f;
+		}
+	}
+	if (key == SDLK_LEFT) {
+		if (cameraPos.x < 10) {
+			cameraPos.x += 0.20f;
+		}
+	}
+	if (key == SDLK_RIGHT) {
+		if (cameraPos.x > -10) {
+			cameraPos.x -= 0.20f;
+		}
+	}
+	if (key == SDLK_z) {
+		if (cameraPos.z <= -30.11) {
+			cameraPos.z += 0.11f;
+		}
+	}
+	if (key == SDLK_s) {
+		if (cameraPos.z >= -44.89) {
+			cameraPos.z -= 0.11f;
+		}
+	}
+	if (key == SDLK_q) {
+		cameraFront.x += 0.11f;
+	}
+	if (key == SDLK_d) {
+		cameraFront.x -= 0.11f;
+	}
+}
+
+//pickFigure() lance un rayon de la camra par le pixel (x, y) de la fentre, affiche la figure touche et si ce point voit la lumire.
+//stereo : vues de l'image affiche, NULL en vue unique. Les matrices des yeux placent dj chaque oeil dans sa moiti de la fentre.
+void pickFigure(const SceneBvh& bvh, const glm::mat4& viewProjection, const StereoViews* stereo, int x, int y, const glm::vec3& light)
+{
+	glm::mat4 view = viewProjection;
+	if (stereo != NULL) {
+		view = stereo->eyes[x < WIDTH / 2 ? 0 : 1] * viewProjection;
+	}
+	glm::vec3 origin, direction;
+	screenRay(view, x + 0.5f, y + 0.5f, WIDTH, HEIGHT, origin, direction);
+	RayHit hit;
+	if (!bvh.raycast(origin, direction, 1000.f, hit))
+	{
+		printf("Nothing under the mouse\n");
+		return;
+	}
+	bool lit = bvh.lineOfSight(hit.point, light, hit.figure);
+	printf("Figure %d hit at (%.2f, %.2f, %.2f), %.2f from the camera, %s\n", hit.figure, hit.point.x, hit.point.y, hit.point.z, hit.distance,
+		lit ? "lit" : "in shadow");
+}
+
+//changeRenderScale() applique les touches Page up / Page down. Une chelle choisie  la main arrte la rsolution dynamique.
+void changeRenderScale(SDL_Keycode key, RenderBackend* backend, DynamicResolution& resolution, bool& dynamicResolution)
+{
+	if (key != SDLK_PAGEUP && key != SDLK_PAGEDOWN) {
+		return;
+	}
+	float scale = backend->getRenderScale() + (key == SDLK_PAGEUP ? RENDER_SCALE_STEP : -RENDER_SCALE_STEP);
+	backend->setRenderScale(scale);
+	resolution.setScale(scale);
+	dynamicResolution = false;
 }
 
 int main(int argc, char *argv[])
 {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		return EXIT_FAILURE;
+	}
+	if (options.physicsBenchmark > 0)
+	{
+		runPhysicsBenchmark(options.physicsBenchmark);
+		return 0;
+	}
+	if (options.particleBenchmark > 0)
+	{
+		runParticleBenchmark(options.particleBenchmark);
+		return 0;
+	}
+	if (options.tessellationBenchmark > 0)
+	{
+		runTessellationBenchmark(options.tessellationBenchmark);
+		return 0;
+	}
+	if (options.vertexReport)
+	{
+		runVertexReport();
+		return 0;
+	}
+	if (options.jobBenchmark > 0)
+	{
+		runJobBenchmark(options.jobBenchmark);
+		return 0;
+	}
+	if (options.pickBenchmark)
+	{
+		runPickBenchmark();
+		return 0;
+	}
+
+	//La graine de rand() est enregistre avec les entres pour que le rejeu donne exactement les mmes images
+	InputRecorder recorder;
+	InputReplayer replayer;
+	std::vector<SDL_Event> replayEvents;
+	FrameTimings timings;
+	FrameAllocations allocations;
+	uint32_t seed = (uint32_t)time(NULL);
+	int frameRate = options.frameRate;
+	if (options.replayPath != NULL)
+	{
+		if (!replayer.open(options.replayPath)) {
+			return EXIT_FAILURE;
+		}
+		seed = replayer.getSeed();
+		frameRate = (int)replayer.getFramerate(); //mme pas de temps qu' l'enregistrement
+	}
+	if (options.recordPath != NULL && !recorder.open(options.recordPath, seed, frameRate)) {
+		return EXIT_FAILURE;
+	}
+	srand(seed);
+
     ////////////////////////////////////////
     //SDL2 / OpenGL Context initialization : 
     ////////////////////////////////////////
@@ -194,55 +626,96 @@ int main(int argc, char *argv[])
                                           SDL_WINDOWPOS_UNDEFINED,               //X Position
                                           SDL_WINDOWPOS_UNDEFINED,               //Y Position
                                           WIDTH, HEIGHT,                         //Resolution
-                                          SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN); //Flags (OpenGL + Show)
+                                          (options.software ? 0 : SDL_WINDOW_OPENGL) | (options.headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN)); //Flags (OpenGL + Show)
 
-    //Initialize OpenGL Version (version 3.0)
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+    SDL_GLContext context = NULL;
+    RenderBackend* backend = NULL;
+    if (options.software)
+    {
+        backend = new SoftwareBackend(window, WIDTH, HEIGHT);
+    }
+    else
+    {
+        //Initialize OpenGL Version (version 3.0, 4.3 pour le multi draw indirect)
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, options.multiDraw ? 4 : 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, options.multiDraw ? 3 : 0);
 
-    //Initialize the OpenGL Context (where OpenGL resources (Graphics card resources) lives)
-    SDL_GLContext context = SDL_GL_CreateContext(window);
+        //Initialize the OpenGL Context (where OpenGL resources (Graphics card resources) lives)
+        context = SDL_GL_CreateContext(window);
 
-    //Tells GLEW to initialize the OpenGL function with this version
-    glewExperimental = GL_TRUE;
-    glewInit();
+        //Tells GLEW to initialize the OpenGL function with this version
+        glewExperimental = GL_TRUE;
+        glewInit();
 
 
-    //Start using OpenGL to draw something on screen
-    glViewport(0, 0, WIDTH, HEIGHT); //Draw on ALL the screen
+        //Start using OpenGL to draw something on screen
+        glViewport(0, 0, WIDTH, HEIGHT); //Draw on ALL the screen
 
-    //The OpenGL background color (RGBA, each component between 0.0f and 1.0f)
-    glClearColor(0.0, 0.0, 0.0, 1.0); //Full Black
+        //The OpenGL background color (RGBA, each component between 0.0f and 1.0f)
+        glClearColor(0.0, 0.0, 0.0, 1.0); //Full Black
 
-    glEnable(GL_DEPTH_TEST); //Active the depth test
+        glEnable(GL_DEPTH_TEST); //Active the depth test
+
+        //On charge les shaders
+        size_t vramBudget = (size_t)options.vramBudget * 1024 * 1024;
+        GLBackend* glBackend = options.multiDraw ? new MultiDrawBackend(window, vramBudget) : new GLBackend(window, vramBudget);
+        backend = glBackend;
+        if (!glBackend->init())
+        {
+            delete backend;
+            return EXIT_FAILURE;
+        }
+        glBackend->setOcclusionCulling(options.occlusionCulling);
+        glBackend->setBloom(options.bloom);
+        glBackend->setTextureBudget((size_t)options.textureBudget * 1024 * 1024);
+        if (options.multiDraw && options.shadows) {
+            printf("The multi-draw renderer has no shadow pass, the scene is drawn without shadows\n");
+        }
+    }
 
 	//////////////////////////////////////////////////////////////////////////////////////////PARTIE_ELEVE////////////////////////////////////////////////////////////////////////////////////
 	
+	//threads qui se partagent le chargement et la mise  jour de chaque image
+	JobSystem jobs(options.threads);
+
 	//Ici, on instancie des variables qui vont servir  l'animation
     int t = 0; //incrment  chaque tour de boucle
-
-	double x = 0; //position de la balle de ping pong en 0.9 - x (voir plus bas)
-	double y = 0; //position de la balle de ping pong en y (voir plus bas)
-	double z = -0.3; //position de la balle de ping pong en z (voir plus bas)
-	int sideBall = 0; //0 la balle se dirige vers la droite, 1 la balle se dirige vers la gauche
-	//pour les variables suivantes: 0 = arrt, 1 = avant, -1 = arire
-	int shoulderMovement = 0; //rotation du bras du personnage de droite selon l'axe x
-	int shoulderRotation = 0; //rotation du bras du personnage de droite selon l'axe y
-	int shoulderTurning = 0; //rotation du bras du personnage de droite selon l'axe z
-	int shoulderMovement2 = 0; //rotation du bras du personnage de gauche selon l'axe x
-	int shoulderRotation2 = 0; //rotation du bras du personnage de gauche selon l'axe y
-	int shoulderTurning2 = 0; //rotation du bras du personnage de gauche selon l'axe z
-
-	double bodyMovement = 0; //surlvation du corps simulant un flottement ou une respiration
-	float legMovement = 0.002; //mouvement rotatif ajout aux jambes pour simuler un flottement
+	int lastCrossing = 0; //numro de la dernire traverse de la balle, la couleur change  chaque renvoi
+
+	AnimationClip swingClip = createSwingClip();
+	AnimationClip floatClip = createFloatClip();
+	std::vector<JointPose> swingPoses; //une pose par personnage
+	std::vector<JointPose> floatPose; //les deux personnages flottent en mme temps
+
+	//balles d'entranement : simules  pas fixe, elles rebondissent sur la table, le filet, les raquettes et le sol
+	BallPhysics drillPhysics;
+	serveDrillBalls(drillPhysics, options.drillBalls);
+	std::vector<BoxCollider> drillColliders;
+	glm::vec3 lastPaddleCenter[2];
+	bool paddlesKnown = false; //pas de vitesse de raquette  la premire image
+	std::vector<float> drillVelocityX(DRILL_RENDERED_BALLS); //vitesse avant le pas, un changement de signe prs d'une raquette est un renvoi
+
+	//trane de la balle et tincelles des renvois, tires aprs srand() pour que le rejeu soit identique
+	ParticleSettings trailSettings;
+	trailSettings.capacity = 1024;
+	trailSettings.lifetime = 0.6f;
+	trailSettings.gravity = glm::vec3(0.f, -0.3f, 0.f);
+	trailSettings.drag = 3.f;
+	trailSettings.size = 0.04f;
+	ParticleEmitter trail(trailSettings, rand());
+	ParticleSettings sparkSettings;
+	sparkSettings.capacity = 16384;
+	sparkSettings.lifetime = 0.8f;
+	sparkSettings.size = 0.015f;
+	ParticleEmitter sparks(sparkSettings, rand());
+	bool ballHit = false; //la balle anime vient d'tre renvoye
 
     //TODO
-	std::vector <Geometry> listeFigures; //liste de toutes les figures cres
-	std::vector <GLuint> listeBuffer; //liste des buffers texture associs aux figures
-	std::vector <GLuint> listeBuffer2; //liste des buffers lumire associs aux figures
-	std::vector < GLuint> listeTexture; //liste des textures assoccies aux figures
+	std::vector <int> listeMesh; //liste des buffers associs aux figures dans le moteur de rendu
+	std::vector <int> listeTexture; //liste des textures associes aux figures
 	std::vector <glm::mat4> listeMvp; //liste des matrices associes aux figures
 	std::vector <glm::mat4> listeModel; // liste des matrices modle associes aux figures
+	std::vector <glm::mat4> listeScale; // liste des chelles des figures, appliques aprs leur chane de matrices
 	std::vector <Material> listeMaterial; // liste des matriaux associs aux figures
 
 	//Variables lies  la camera
@@ -266,7 +739,6 @@ int main(int argc, char *argv[])
 	ballLight.color = glm::vec3((rand() % 101) / 100.f, (rand() % 101) / 100.f, (rand() % 101) / 100.f);
 	Material textile = { glm::vec3(1.f, 0.f, 0.f), 0.4f, 0.3f, 0.1f, 50.0f};
 	Material lightingBall = { glm::vec3(1.f, 0.f, 0.f), 1.0f, 1.0f, 0.0f, 50.0f };
-	Material lightingWorld = { glm::vec3(1.f, 0.f, 0.f), 0.8f, 0.0f, 0.0f, 50.0f };
 	Material stone = { glm::vec3(1.f, 0.f, 0.f), 0.4f, 0.5f, 0.2f, 50.0f };
 	Material trollSkin = { glm::vec3(1.f, 0.f, 0.f), 0.4f, 0.7f, 0.2f, 50.0f };
 	Material plastic = { glm::vec3(1.f, 0.f, 0.f), 0.4f, 0.8f, 0.4f, 100.0f };
@@ -323,7 +795,6 @@ int main(int argc, char *argv[])
 	listeMaterial.push_back(stone);
 	listeMaterial.push_back(stone);
 	listeMaterial.push_back(lightingBall);
-	listeMaterial.push_back(lightingWorld);
 
 	/*Ici, on va crer une par une toutes les figures qui composent notre personnage
 
@@ -341,525 +812,645 @@ int main(int argc, char *argv[])
 
 	Les paules, coudes, cuisses et genoux car ce sont des articulations dans notre modle
 	*/
-	std::vector<GLuint> tab;
+	std::vector<int> tab;
+
+	//Graphe de chargement : chaque fichier d'image est lu et dcod par sa propre tche, sur tous les coeurs.
+	//Les maillages et les textures sont ensuite crs un par un sur ce thread, le seul qui parle au moteur de rendu.
+	const char* sceneImages[] = { "Images/costar.png", "Images/costar2.png", "Images/TrollFace.png", "Images/TrollFace2.png", "Images/manche.png",
+		"Images/manche2.png", "Images/skin.png", "Images/jean.png", "Images/jean2.png", "Images/chaussure.png", "Images/chaussure2.png",
+		"Images/red.png", "Images/wood.png", "Images/table.png", "Images/filet.png", "Images/support.png", "Images/ball.png" };
+	const int nbSceneImages = sizeof(sceneImages) / sizeof(sceneImages[0]);
+	decodedImages.resize(nbSceneImages + 1);
+	TaskGraph loading;
+	for (int i = 0; i <= nbSceneImages; i++)
+	{
+		decodedImages[i].source = i < nbSceneImages ? sceneImages[i] : "Images/space.png";
+		decodedImages[i].mirrored = i < nbSceneImages; //le fond n'est pas retourn
+		loading.add(decodedImages[i].source, [i]() { decodeImage(decodedImages[i]); });
+	}
+	loading.run(jobs);
+
+	//toutes les sphres et tous les cylindres de la scne sont identiques : un seul maillage de chaque, partag par les figures
+	int sphereMesh = generateSphere(backend, SCENE_SLICES, SCENE_SLICES);
+	int cylinderMesh = generateCylinder(backend, SCENE_SLICES);
 
-	Cylinder body(32);
-	listeFigures.push_back(body);
-	tab = generate(body, "Images/costar.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/costar.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 bodyMatrix = getMatrix(-1.9, 0.3, -40, -M_PI / 2.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix);
 
-	Sphere head(32, 32);
-	listeFigures.push_back(head);
-	tab = generate(head, "Images/TrollFace2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/TrollFace2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 headMatrix = getMatrix(0, 0, 0.55, 0.f, 0, 0, 1);
 	headMatrix = glm::rotate(headMatrix, (float)(M_PI / 2), glm::vec3(1, 0, 0));
 	headMatrix = glm::rotate(headMatrix, (float)(M_PI), glm::vec3(0, 0, 1));
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * headMatrix);
 
-	Sphere shoulder1(32, 32);
-	listeFigures.push_back(shoulder1);
-	tab = generate(shoulder1, "Images/manche.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/manche.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 shoulder1Matrix = getMatrix(-0.32, 0, 0.3, M_PI/14.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * shoulder1Matrix);
 
-	Cylinder arm1(32);
-	listeFigures.push_back(arm1);
-	tab = generate(arm1, "Images/manche.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/manche.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 arm1Matrix = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * shoulder1Matrix * arm1Matrix);
 
-	Sphere elbow1(32, 32);
-	listeFigures.push_back(elbow1);
-	tab = generate(elbow1, "Images/skin.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/skin.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 elbow1Matrix = getMatrix(0, 0, -0.2, M_PI/12.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * shoulder1Matrix * arm1Matrix * elbow1Matrix);
 
-	Cylinder forearm1(32);
-	listeFigures.push_back(forearm1);
-	tab = generate(forearm1, "Images/skin.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/skin.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 forearm1Matrix = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * shoulder1Matrix * arm1Matrix * elbow1Matrix * forearm1Matrix);
 	
-	Sphere shoulder2(32, 32);
-	listeFigures.push_back(shoulder2);
-	tab = generate(shoulder2, "Images/manche.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/manche.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 shoulder2Matrix = getMatrix(0.32, 0, 0.3, M_PI / 1.9f, 1, 0, 0);
 	shoulder2Matrix = glm::rotate(shoulder2Matrix, (float)-M_PI/2.f, glm::vec3(0, 1, 0));
 	shoulder2Matrix = glm::rotate(shoulder2Matrix, (float)-M_PI / 2.f, glm::vec3(1, 0, 0));
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix);
 
-	Cylinder arm2(32);
-	listeFigures.push_back(arm2);
-	tab = generate(arm2, "Images/manche.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/manche.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 arm2Matrix = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix);
 
-	Sphere elbow2(32, 32);
-	listeFigures.push_back(elbow2);
-	tab = generate(elbow2, "Images/skin.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/skin.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 elbow2Matrix = getMatrix(0, 0, -0.2, M_PI/12.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix);
 
-	Cylinder forearm2(32);
-	listeFigures.push_back(forearm2);
-	tab = generate(forearm2, "Images/skin.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/skin.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 forearm2Matrix = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix);
 
-	Cylinder thigh1(32);
-	listeFigures.push_back(thigh1);
-	tab = generate(thigh1, "Images/jean.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/jean.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 thigh1Matrix = getMatrix(-0.15, 0.1, -0.55, M_PI/4.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * thigh1Matrix);
 
-	Sphere knee1(32, 32);
-	listeFigures.push_back(knee1);
-	tab = generate(knee1, "Images/jean.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/jean.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 knee1Matrix = getMatrix(0, 0, -0.2, -M_PI/4.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * thigh1Matrix * knee1Matrix);
 
-	Cylinder leg1(32);
-	listeFigures.push_back(leg1);
-	tab = generate(leg1, "Images/jean.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/jean.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 leg1Matrix = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * thigh1Matrix * knee1Matrix * leg1Matrix);
 
-	Sphere foot1(32, 32);
-	listeFigures.push_back(foot1);
-	tab = generate(foot1, "Images/chaussure.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/chaussure.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 foot1Matrix = getMatrix(0, 0.1, -0.2, 0.f, 0, 0, 1);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * thigh1Matrix * knee1Matrix * leg1Matrix * foot1Matrix);
 
-	Cylinder thigh2(32);
-	listeFigures.push_back(thigh2);
-	tab = generate(thigh2, "Images/jean.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/jean.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 thigh2Matrix = getMatrix(0.15, 0.12, -0.55, M_PI/3.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * thigh2Matrix);
 
-	Sphere knee2(32, 32);
-	listeFigures.push_back(knee2);
-	tab = generate(knee2, "Images/jean.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/jean.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 knee2Matrix = getMatrix(0, 0, -0.2, -M_PI / 3.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * thigh2Matrix * knee2Matrix);
 
-	Cylinder leg2(32);
-	listeFigures.push_back(leg2);
-	tab = generate(leg2, "Images/jean.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/jean.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 leg2Matrix = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * thigh2Matrix * knee2Matrix * leg2Matrix);
 
-	Sphere foot2(32, 32);
-	listeFigures.push_back(foot2);
-	tab = generate(foot2, "Images/chaussure.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/chaussure.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 foot2Matrix = getMatrix(0, 0.1, -0.2, 0.f, 0, 0, 1);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * thigh2Matrix * knee2Matrix * leg2Matrix * foot2Matrix);
 
-	Cylinder body2(32);
-	listeFigures.push_back(body2);
-	tab = generate(body2, "Images/costar2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/costar2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 bodyMatrix2 = getMatrix(1.9, 0.3, -40, -M_PI / 2.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2);
 
-	Sphere head2(32, 32);
-	listeFigures.push_back(head2);
-	tab = generate(head2, "Images/TrollFace.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/TrollFace.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 headMatrix2 = getMatrix(0, 0, 0.55, 0.f, 0, 0, 1);
 	headMatrix2 = glm::rotate(headMatrix2, (float)(M_PI / 2), glm::vec3(1, 0, 0));
 	headMatrix2 = glm::rotate(headMatrix2, (float)(M_PI), glm::vec3(0, 0, 1));
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * headMatrix2);
 
-	Sphere shoulder12(32, 32);
-	listeFigures.push_back(shoulder12);
-	tab = generate(shoulder12, "Images/manche2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/manche2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 shoulder1Matrix2 = getMatrix(-0.32, 0, 0.3, M_PI / 14.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder1Matrix2);
 
-	Cylinder arm12(32);
-	listeFigures.push_back(arm12);
-	tab = generate(arm12, "Images/manche2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/manche2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 arm1Matrix2 = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder1Matrix2 * arm1Matrix2);
 
-	Sphere elbow12(32, 32);
-	listeFigures.push_back(elbow12);
-	tab = generate(elbow12, "Images/skin.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/skin.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 elbow1Matrix2 = getMatrix(0, 0, -0.2, M_PI / 12.f , 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder1Matrix2 * arm1Matrix2 * elbow1Matrix2);
 
-	Cylinder forearm12(32);
-	listeFigures.push_back(forearm12);
-	tab = generate(forearm12, "Images/skin.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/skin.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 forearm1Matrix2 = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder1Matrix2 * arm1Matrix2 * elbow1Matrix2 * forearm1Matrix2);
 
-	Sphere shoulder22(32, 32);
-	listeFigures.push_back(shoulder22);
-	tab = generate(shoulder22, "Images/manche2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/manche2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 shoulder2Matrix2 = getMatrix(0.32, 0, 0.3, M_PI / 1.9f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2);
 
-	Cylinder arm22(32);
-	listeFigures.push_back(arm22);
-	tab = generate(arm22, "Images/manche2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/manche2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 arm2Matrix2 = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2);
 
-	Sphere elbow22(32, 32);
-	listeFigures.push_back(elbow22);
-	tab = generate(elbow22, "Images/skin.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/skin.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 elbow2Matrix2 = getMatrix(0, 0, -0.2, M_PI / 12.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2);
 
-	Cylinder forearm22(32);
-	listeFigures.push_back(forearm22);
-	tab = generate(forearm22, "Images/skin.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/skin.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 forearm2Matrix2 = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2);
 
-	Cylinder thigh12(32);
-	listeFigures.push_back(thigh12);
-	tab = generate(thigh12, "Images/jean2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/jean2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 thigh1Matrix2 = getMatrix(-0.15, 0.1, -0.55, M_PI / 4.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * thigh1Matrix2);
 
-	Sphere knee12(32, 32);
-	listeFigures.push_back(knee12);
-	tab = generate(knee12, "Images/jean2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/jean2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 knee1Matrix2 = getMatrix(0, 0, -0.2, -M_PI / 4.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * thigh1Matrix2 * knee1Matrix2);
 
-	Cylinder leg12(32);
-	listeFigures.push_back(leg12);
-	tab = generate(leg12, "Images/jean2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/jean2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 leg1Matrix2 = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * thigh1Matrix2 * knee1Matrix2 * leg1Matrix2);
 
-	Sphere foot12(32, 32);
-	listeFigures.push_back(foot12);
-	tab = generate(foot12, "Images/chaussure2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/chaussure2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 foot1Matrix2 = getMatrix(0, 0.1, -0.2, 0.f, 0, 0, 1);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * thigh1Matrix2 * knee1Matrix2 * leg1Matrix2 * foot1Matrix2);
 
-	Cylinder thigh22(32);
-	listeFigures.push_back(thigh22);
-	tab = generate(thigh22, "Images/jean2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/jean2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 thigh2Matrix2 = getMatrix(0.15, 0.12, -0.55, M_PI / 3.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * thigh2Matrix2);
 
-	Sphere knee22(32, 32);
-	listeFigures.push_back(knee22);
-	tab = generate(knee22, "Images/jean2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/jean2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 knee2Matrix2 = getMatrix(0, 0, -0.2, -M_PI / 3.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * thigh2Matrix2 * knee2Matrix2);
 
-	Cylinder leg22(32);
-	listeFigures.push_back(leg22);
-	tab = generate(leg22, "Images/jean2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/jean2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 leg2Matrix2 = getMatrix(0, 0, -0.2, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * thigh2Matrix2 * knee2Matrix2 * leg2Matrix2);
 
-	Sphere foot22(32, 32);
-	listeFigures.push_back(foot22);
-	tab = generate(foot22, "Images/chaussure2.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/chaussure2.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 foot2Matrix2 = getMatrix(0, 0.1, -0.2, 0.f, 0, 0, 1);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * thigh2Matrix2 * knee2Matrix2 * leg2Matrix2 * foot2Matrix2);
 
-	Cylinder raquette1(32);
-	listeFigures.push_back(raquette1);
-	tab = generate(raquette1, "Images/red.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/red.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 raquette1Matrix = getMatrix(0, 0, -0.28, -M_PI / 2.f, 1, 0, 0);
 	raquette1Matrix = glm::rotate(raquette1Matrix, (float)M_PI / 2.f, glm::vec3(0, 1, 0));
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix * raquette1Matrix);
 
-	Sphere face1(32, 32);
-	listeFigures.push_back(face1);
-	tab = generate(face1, "Images/red.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/red.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 face1Matrix = getMatrix(0, 0, 0, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix * raquette1Matrix * face1Matrix);
 
-	Cylinder manche1(32);
-	listeFigures.push_back(manche1);
-	tab = generate(manche1, "Images/wood.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/wood.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 manche1Matrix = getMatrix(0, -0.15, 0, M_PI / 2.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix * raquette1Matrix * manche1Matrix);
 
-	Cylinder raquette2(32);
-	listeFigures.push_back(raquette2);
-	tab = generate(raquette2, "Images/red.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/red.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 raquette2Matrix = getMatrix(0, 0, -0.28, -M_PI / 2.f, 1, 0, 0);
 	raquette2Matrix = glm::rotate(raquette2Matrix, (float)M_PI / 2.f, glm::vec3(0, 1, 0));
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2 * raquette2Matrix);
 
-	Sphere face2(32, 32);
-	listeFigures.push_back(face2);
-	tab = generate(face2, "Images/red.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/red.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 face2Matrix = getMatrix(0, 0, 0, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2 * raquette2Matrix * face2Matrix);
 
-	Cylinder manche2(32);
-	listeFigures.push_back(manche2);
-	tab = generate(manche2, "Images/wood.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, cylinderMesh, "Images/wood.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 manche2Matrix = getMatrix(0, -0.15, 0, M_PI / 2.f, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2 * raquette2Matrix * manche2Matrix);
 
 	Cube table = Cube();
-	listeFigures.push_back(table);
-	tab = generate(table, "Images/table.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, table, "Images/table.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 tableMatrix = getMatrix(0, 0, -40,  0 * (M_PI / 2.f), 0, 1, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * tableMatrix);
 
 	Cube filet = Cube();
-	listeFigures.push_back(filet);
-	tab = generate(filet, "Images/filet.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, filet, "Images/filet.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 filetMatrix = getMatrix(0, 0.075, 0, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * tableMatrix * filetMatrix);
 
 	Cube support = Cube();
-	listeFigures.push_back(support);
-	tab = generate(support, "Images/support.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, support, "Images/support.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 supportMatrix = getMatrix(0, -0.34, 0, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * tableMatrix * supportMatrix);
 
 	Cube socle = Cube();
-	listeFigures.push_back(socle);
-	tab = generate(socle, "Images/support.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, socle, "Images/support.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 socleMatrix = getMatrix(0, -0.36, 0, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * tableMatrix * supportMatrix * socleMatrix);
 
-	Sphere ball(32,32);
-	listeFigures.push_back(ball);
-	tab = generate(ball, "Images/ball.png");
-	listeBuffer.push_back(tab[0]);
+	tab = generate(backend, sphereMesh, "Images/ball.png");
+	listeMesh.push_back(tab[0]);
 	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
 	glm::mat4 ballMatrix = getMatrix(0.9, 0.4, -40, 0, 1, 0, 0);
 	listeMvp.push_back(projectionMatrix * cameraMatrix * ballMatrix);
 
-	Sphere World(32, 32);
-	listeFigures.push_back(World);
-	tab = generate(World, "Images/space.png");
-	listeBuffer.push_back(tab[0]);
-	listeTexture.push_back(tab[1]);
-	listeBuffer2.push_back(tab[2]);
-	glm::mat4 worldMatrix = getMatrix(0, 0, 0, M_PI, 0, 1, 0);
-	listeMvp.push_back(projectionMatrix* cameraMatrix* worldMatrix);
-
-	//on scale tous les objets
-
-	listeMvp[0] = listeMvp[0] * scaleMatrix(0.5, 0.25, 0.8);
-	listeMvp[1] = listeMvp[1] * scaleMatrix(0.3, 0.3, 0.3);
-	listeMvp[2] = listeMvp[2] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[3] = listeMvp[3] * scaleMatrix(0.1, 0.1, 0.25);
-	listeMvp[4] = listeMvp[4] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[5] = listeMvp[5] * scaleMatrix(0.1, 0.1, 0.25);
-	listeMvp[6] = listeMvp[6] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[7] = listeMvp[7] * scaleMatrix(0.1, 0.1, 0.25);
-	listeMvp[8] = listeMvp[8] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[9] = listeMvp[9] * scaleMatrix(0.1, 0.1, 0.25);
-	listeMvp[10] = listeMvp[10] * scaleMatrix(0.15, 0.15, 0.38);
-	listeMvp[11] = listeMvp[11] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[12] = listeMvp[12] * scaleMatrix(0.15, 0.15, 0.38);
-	listeMvp[13] = listeMvp[13] * scaleMatrix(0.2, 0.4, 0.2);
-	listeMvp[14] = listeMvp[14] * scaleMatrix(0.15, 0.15, 0.38);
-	listeMvp[15] = listeMvp[15] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[16] = listeMvp[16] * scaleMatrix(0.15, 0.15, 0.38);
-	listeMvp[17] = listeMvp[17] * scaleMatrix(0.2, 0.4, 0.2);
-
-	listeMvp[18] = listeMvp[18] * scaleMatrix(0.5, 0.25, 0.8);
-	listeMvp[19] = listeMvp[19] * scaleMatrix(0.3, 0.3, 0.3);
-	listeMvp[20] = listeMvp[20] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[21] = listeMvp[21] * scaleMatrix(0.1, 0.1, 0.25);
-	listeMvp[22] = listeMvp[22] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[23] = listeMvp[23] * scaleMatrix(0.1, 0.1, 0.25);
-	listeMvp[24] = listeMvp[24] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[25] = listeMvp[25] * scaleMatrix(0.1, 0.1, 0.25);
-	listeMvp[26] = listeMvp[26] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[27] = listeMvp[27] * scaleMatrix(0.1, 0.1, 0.25);
-	listeMvp[28] = listeMvp[28] * scaleMatrix(0.15, 0.15, 0.38);
-	listeMvp[29] = listeMvp[29] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[30] = listeMvp[30] * scaleMatrix(0.15, 0.15, 0.38);
-	listeMvp[31] = listeMvp[31] * scaleMatrix(0.2, 0.4, 0.2);
-	listeMvp[32] = listeMvp[32] * scaleMatrix(0.15, 0.15, 0.38);
-	listeMvp[33] = listeMvp[33] * scaleMatrix(0.2, 0.2, 0.2);
-	listeMvp[34] = listeMvp[34] * scaleMatrix(0.15, 0.15, 0.38);
-	listeMvp[35] = listeMvp[35] * scaleMatrix(0.2, 0.4, 0.2);
-
-	listeMvp[36] = listeMvp[36] * scaleMatrix(0.2, 0.2, 0.02);
-	listeMvp[37] = listeMvp[37] * scaleMatrix(0.2, 0.2, 0.02);
-	listeMvp[38] = listeMvp[38] * scaleMatrix(0.035, 0.02, 0.1);
-
-	listeMvp[39] = listeMvp[39] * scaleMatrix(0.2, 0.2, 0.02);
-	listeMvp[40] = listeMvp[40] * scaleMatrix(0.2, 0.2, 0.02);
-	listeMvp[41] = listeMvp[41] * scaleMatrix(0.035, 0.02, 0.1);
-
-	listeMvp[42] = listeMvp[42] * scaleMatrix(1.8, 0.05, 1.0);
-	listeMvp[43] = listeMvp[43] * scaleMatrix(0.02, 0.15, 0.98);
-	listeMvp[44] = listeMvp[44] * scaleMatrix(0.2, 0.65, 0.95);
-	listeMvp[45] = listeMvp[45] * scaleMatrix(1.0, 0.1, 1.0);
-
-	listeMvp[46] = listeMvp[46] * scaleMatrix(0.075, 0.075, 0.075);
-
-	listeMvp[47] = listeMvp[47] * scaleMatrix(100, 100, 100);
-
-    //From here you can load your OpenGL objects, like VBO, Shaders, etc.
-    //TODO
-	//On charge les fichiers relatifs aux shaders
-    FILE* vertFile = fopen("Shaders/color.vert", "r");
-    FILE* fragFile = fopen("Shaders/color.frag", "r");
-    if (vertFile == NULL || fragFile == NULL) {
-      return EXIT_FAILURE;
-    }
-    Shader* shader = Shader::loadFromFiles(vertFile, fragFile);
+	//le fond n'est plus une sphre claire qui entoure la scne mais une cube map dessine derrire les figures
+	int skybox = generateSkybox(backend, "Images/space.png");
+
+	//on scale tous les objets, l'chelle de chaque figure est garde pour tre rapplique  chaque image
+
+	listeScale.push_back(scaleMatrix(0.5, 0.25, 0.8));
+	listeScale.push_back(scaleMatrix(0.3, 0.3, 0.3));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.1, 0.1, 0.25));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.1, 0.1, 0.25));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.1, 0.1, 0.25));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.1, 0.1, 0.25));
+	listeScale.push_back(scaleMatrix(0.15, 0.15, 0.38));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.15, 0.15, 0.38));
+	listeScale.push_back(scaleMatrix(0.2, 0.4, 0.2));
+	listeScale.push_back(scaleMatrix(0.15, 0.15, 0.38));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.15, 0.15, 0.38));
+	listeScale.push_back(scaleMatrix(0.2, 0.4, 0.2));
+
+	listeScale.push_back(scaleMatrix(0.5, 0.25, 0.8));
+	listeScale.push_back(scaleMatrix(0.3, 0.3, 0.3));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.1, 0.1, 0.25));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.1, 0.1, 0.25));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.1, 0.1, 0.25));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.1, 0.1, 0.25));
+	listeScale.push_back(scaleMatrix(0.15, 0.15, 0.38));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.15, 0.15, 0.38));
+	listeScale.push_back(scaleMatrix(0.2, 0.4, 0.2));
+	listeScale.push_back(scaleMatrix(0.15, 0.15, 0.38));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.2));
+	listeScale.push_back(scaleMatrix(0.15, 0.15, 0.38));
+	listeScale.push_back(scaleMatrix(0.2, 0.4, 0.2));
+
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.02));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.02));
+	listeScale.push_back(scaleMatrix(0.035, 0.02, 0.1));
+
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.02));
+	listeScale.push_back(scaleMatrix(0.2, 0.2, 0.02));
+	listeScale.push_back(scaleMatrix(0.035, 0.02, 0.1));
+
+	listeScale.push_back(scaleMatrix(1.8, 0.05, 1.0));
+	listeScale.push_back(scaleMatrix(0.02, 0.15, 0.98));
+	listeScale.push_back(scaleMatrix(0.2, 0.65, 0.95));
+	listeScale.push_back(scaleMatrix(1.0, 0.1, 1.0));
+
+	listeScale.push_back(scaleMatrix(0.075, 0.075, 0.075));
+	for (int i = 0; i < listeMvp.size(); i++) {
+		listeMvp[i] = listeMvp[i] * listeScale[i];
+	}
+	listeModel.resize(listeMvp.size()); //rempli  chaque image par le graphe de mise  jour
 
+	//une figure ou une texture a pu dpasser le budget mmoire
+	for (int i = 0; i < listeMesh.size(); i++)
+	{
+		if (listeMesh[i] < 0 || listeTexture[i] < 0)
+		{
+			ERROR("The scene does not fit in the memory budget\n");
+			delete backend;
+			return EXIT_FAILURE;
+		}
+	}
+	backend->printMemoryReport("scene");
+
+	//on garde la pose de repos des articulations animes, les clips donnent une transformation relative  celle-ci
+	const glm::mat4 shoulder2Rest = shoulder2Matrix;
+	const glm::mat4 shoulder2Rest2 = shoulder2Matrix2;
+	const glm::mat4 knee1Rest = knee1Matrix;
+	const glm::mat4 knee2Rest = knee2Matrix;
+	const glm::mat4 knee1Rest2 = knee1Matrix2;
+	const glm::mat4 knee2Rest2 = knee2Matrix2;
+
+	//Mise  jour de chaque image en graphe de tches, rparti sur tous les coeurs : les deux personnages et la table sont calculs en mme temps,
+	//la physique attend les raquettes, la trane n'attend que la balle. Le rendu reste sur ce thread, le seul qui parle au moteur de rendu.
+	//rand() n'est tir que sur ce thread, avant le graphe, et chaque metteur n'est touch que par une tche  la fois : le rejeu reste identique.
+	float animTime = 0.f;
+	glm::vec3 ballPosition;
+	std::vector<glm::mat4> drillMvp(DRILL_RENDERED_BALLS);
+	glm::mat4 viewProjection = projectionMatrix * cameraMatrix;
+	SceneBvh sceneBvh;
+	TaskGraph frameUpdate;
+
+	int animationTask = frameUpdate.add("animation", [&]() {
+		viewProjection = projectionMatrix * cameraMatrix;
+		floatClip.sample(animTime, floatPose);
+		float swingTimes[2] = { animTime, animTime + CROSSING_FRAMES / (float)FRAMERATE }; //le personnage de gauche a une traverse d'avance
+		swingClip.sampleBatch(swingTimes, 2, swingPoses);
 
-    fclose(vertFile);
-    fclose(fragFile);
-    if (shader == NULL)
-    {
-      return EXIT_FAILURE;
-    }
+		// On rinitialise les donnes des figure principales (les corps, la balle, la table)
+
+		bodyMatrix = getMatrix(-1.9, 0.3, -40, -M_PI / 2.f, 1, 0, 0);
+		bodyMatrix = glm::rotate(bodyMatrix, (float)(-M_PI / 2.f), glm::vec3(0, 0, 1));
+		bodyMatrix = glm::rotate(bodyMatrix, (float)(-M_PI / 12.f), glm::vec3(1, 0, 0));
+		bodyMatrix = bodyMatrix * poseMatrix(floatPose[FLOAT_BODY]);
+
+		bodyMatrix2 = getMatrix(1.9, 0.3, -40, -M_PI / 2.f, 1, 0, 0);
+		bodyMatrix2 = glm::rotate(bodyMatrix2, (float)(M_PI / 2.f), glm::vec3(0, 0, 1));
+		bodyMatrix2 = glm::rotate(bodyMatrix2, (float)(-M_PI / 12.f), glm::vec3(1, 0, 0));
+		bodyMatrix2 = bodyMatrix2 * poseMatrix(floatPose[FLOAT_BODY]);
+
+		tableMatrix = getMatrix(0, 0, -40, 0 * (M_PI / 2.f), 0, 1, 0);
+		ballMatrix = getMatrix(0.9 - ballPosition.x, ballPosition.y, ballPosition.z - 40, 0, 1, 0, 0);
+	});
+
+	// On recalcule toutes les matrices en fonction de la nouvelle position du corps et de la rotation des articulations, dans le monde
+	int character1Task = frameUpdate.add("character 1", [&]() {
+		shoulder2Matrix = shoulder2Rest * poseMatrix(swingPoses[0]);
+		knee1Matrix = knee1Rest * poseMatrix(floatPose[FLOAT_KNEE]);
+		knee2Matrix = knee2Rest * poseMatrix(floatPose[FLOAT_KNEE]);
+		listeModel[0] = bodyMatrix;
+		listeModel[1] = bodyMatrix * headMatrix;
+		listeModel[2] = bodyMatrix * shoulder1Matrix;
+		listeModel[3] = bodyMatrix * shoulder1Matrix * arm1Matrix;
+		listeModel[4] = bodyMatrix * shoulder1Matrix * arm1Matrix * elbow1Matrix;
+		listeModel[5] = bodyMatrix * shoulder1Matrix * arm1Matrix * elbow1Matrix * forearm1Matrix;
+		listeModel[6] = bodyMatrix * shoulder2Matrix;
+		listeModel[7] = bodyMatrix * shoulder2Matrix * arm2Matrix;
+		listeModel[8] = bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix;
+		listeModel[9] = bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix;
+		listeModel[10] = bodyMatrix * thigh1Matrix;
+		listeModel[11] = bodyMatrix * thigh1Matrix * knee1Matrix;
+		listeModel[12] = bodyMatrix * thigh1Matrix * knee1Matrix * leg1Matrix;
+		listeModel[13] = bodyMatrix * thigh1Matrix * knee1Matrix * leg1Matrix * foot1Matrix;
+		listeModel[14] = bodyMatrix * thigh2Matrix;
+		listeModel[15] = bodyMatrix * thigh2Matrix * knee2Matrix;
+		listeModel[16] = bodyMatrix * thigh2Matrix * knee2Matrix * leg2Matrix;
+		listeModel[17] = bodyMatrix * thigh2Matrix * knee2Matrix * leg2Matrix * foot2Matrix;
+
+		listeModel[36] = bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix * raquette1Matrix;
+		listeModel[37] = bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix * raquette1Matrix * face1Matrix;
+		listeModel[38] = bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix * raquette1Matrix * manche1Matrix;
+	});
+	int character2Task = frameUpdate.add("character 2", [&]() {
+		shoulder2Matrix2 = shoulder2Rest2 * poseMatrix(swingPoses[1]);
+		knee1Matrix2 = knee1Rest2 * poseMatrix(floatPose[FLOAT_KNEE]);
+		knee2Matrix2 = knee2Rest2 * poseMatrix(floatPose[FLOAT_KNEE]);
+		listeModel[18] = bodyMatrix2;
+		listeModel[19] = bodyMatrix2 * headMatrix2;
+		listeModel[20] = bodyMatrix2 * shoulder1Matrix2;
+		listeModel[21] = bodyMatrix2 * shoulder1Matrix2 * arm1Matrix2;
+		listeModel[22] = bodyMatrix2 * shoulder1Matrix2 * arm1Matrix2 * elbow1Matrix2;
+		listeModel[23] = bodyMatrix2 * shoulder1Matrix2 * arm1Matrix2 * elbow1Matrix2 * forearm1Matrix2;
+		listeModel[24] = bodyMatrix2 * shoulder2Matrix2;
+		listeModel[25] = bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2;
+		listeModel[26] = bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2;
+		listeModel[27] = bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2;
+		listeModel[28] = bodyMatrix2 * thigh1Matrix2;
+		listeModel[29] = bodyMatrix2 * thigh1Matrix2 * knee1Matrix2;
+		listeModel[30] = bodyMatrix2 * thigh1Matrix2 * knee1Matrix2 * leg1Matrix2;
+		listeModel[31] = bodyMatrix2 * thigh1Matrix2 * knee1Matrix2 * leg1Matrix2 * foot1Matrix2;
+		listeModel[32] = bodyMatrix2 * thigh2Matrix2;
+		listeModel[33] = bodyMatrix2 * thigh2Matrix2 * knee2Matrix2;
+		listeModel[34] = bodyMatrix2 * thigh2Matrix2 * knee2Matrix2 * leg2Matrix2;
+		listeModel[35] = bodyMatrix2 * thigh2Matrix2 * knee2Matrix2 * leg2Matrix2 * foot2Matrix2;
+
+		listeModel[39] = bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2 * raquette2Matrix;
+		listeModel[40] = bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2 * raquette2Matrix * face2Matrix;
+		listeModel[41] = bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2 * raquette2Matrix * manche2Matrix;
+	});
+	int tableTask = frameUpdate.add("table and ball", [&]() {
+		listeModel[42] = tableMatrix;
+		listeModel[43] = tableMatrix * filetMatrix;
+		listeModel[44] = tableMatrix * supportMatrix;
+		listeModel[45] = tableMatrix * supportMatrix * socleMatrix;
+
+		listeModel[46] = ballMatrix;
+	});
+
+	//on oublie pas de rescale, une fois toutes les chanes calcules, puis on passe dans le repre de la camra
+	int rescaleTask = frameUpdate.add("rescale", [&]() {
+		jobs.parallelFor((int)listeMvp.size(), 16, [&](int begin, int end) {
+			for (int i = begin; i < end; i++)
+			{
+				listeModel[i] = listeModel[i] * listeScale[i];
+				listeMvp[i] = viewProjection * listeModel[i];
+			}
+		});
+	});
+
+	//botes des figures pour le lancer de rayons : l'arbre est construit  la premire image, puis seulement remis  jour
+	int pickingTask = frameUpdate.add("picking", [&]() {
+		if (sceneBvh.getFigureCount() == 0)
+		{
+			std::vector<PickFigure> pickFigures(listeModel.size());
+			for (size_t i = 0; i < listeModel.size(); i++)
+			{
+				pickFigures[i].model = listeModel[i];
+				pickFigures[i].shape = listeMesh[i] == sphereMesh ? PICK_SPHERE : (listeMesh[i] == cylinderMesh ? PICK_CYLINDER : PICK_BOX);
+			}
+			sceneBvh.build(pickFigures);
+			return;
+		}
+		for (size_t i = 0; i < listeModel.size(); i++) {
+			sceneBvh.setFigure((int)i, listeModel[i]);
+		}
+		sceneBvh.refit();
+	});
+
+	int drillTask = frameUpdate.add("drill physics", [&]() {
+		if (drillPhysics.getCount() > 0)
+		{
+			//la face des raquettes est une sphre aplatie, assimile  une bote. Sa vitesse vient de son dplacement depuis l'image prcdente.
+			glm::mat4 paddleModel[2] = {
+				bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix * raquette1Matrix * face1Matrix * scaleMatrix(0.2, 0.2, 0.02),
+				bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2 * raquette2Matrix * face2Matrix * scaleMatrix(0.2, 0.2, 0.02)
+			};
+			drillColliders.clear();
+			drillColliders.push_back(makeBoxCollider(tableMatrix * scaleMatrix(1.8, 0.05, 1.0), 0.9f, 1.f));
+			drillColliders.push_back(makeBoxCollider(tableMatrix * filetMatrix * scaleMatrix(0.02, 0.15, 0.98), 0.2f, 0.5f));
+			drillColliders.push_back(makeBoxCollider(getMatrix(0, -1.25, -40, 0, 1, 0, 0) * scaleMatrix(100, 1, 100), 0.7f, 1.f)); //sol, sous le socle
+			for (int p = 0; p < 2; p++)
+			{
+				glm::vec3 center = glm::vec3(paddleModel[p][3]);
+				glm::vec3 velocity = paddlesKnown ? (center - lastPaddleCenter[p]) * (float)frameRate : glm::vec3(0.f, 0.f, 0.f);
+				drillColliders.push_back(makeBoxCollider(paddleModel[p], 0.85f, 1.f, velocity));
+				lastPaddleCenter[p] = center;
+			}
+			paddlesKnown = true;
+			drillPhysics.setColliders(drillColliders);
+			int nbWatched = std::min(drillPhysics.getCount(), DRILL_RENDERED_BALLS);
+			for (int i = 0; i < nbWatched; i++) {
+				drillVelocityX[i] = drillPhysics.getVelocity(i).x;
+			}
+			drillPhysics.update(1.f / frameRate); //dure fixe pour que le rejeu soit identique
+			for (int i = 0; i < nbWatched; i++)
+			{
+				glm::vec3 position = drillPhysics.getPosition(i);
+				if (fabsf(position.x) > 0.9f && drillVelocityX[i] * drillPhysics.getVelocity(i).x < 0.f) {
+					sparks.emit(DRILL_HIT_SPARKS, position, 0.2f * drillPhysics.getVelocity(i), 0.8f, ballLight.color);
+				}
+			}
+		}
+	});
+
+	//balles d'entranement affiches, par tranches sur tous les coeurs
+	int drillMatricesTask = frameUpdate.add("drill matrices", [&]() {
+		int nbRendered = std::min(drillPhysics.getCount(), DRILL_RENDERED_BALLS);
+		jobs.parallelFor(nbRendered, 64, [&](int begin, int end) {
+			for (int i = begin; i < end; i++)
+			{
+				glm::vec3 position = drillPhysics.getPosition(i);
+				drillMvp[i] = viewProjection * getMatrix(position.x, position.y, position.z, 0, 1, 0, 0) * scaleMatrix(0.075, 0.075, 0.075);
+			}
+		});
+	});
+
+	//les particules avancent  pas fixe, puis la balle laisse sa trane et chaque renvoi (changement de couleur) fait des tincelles
+	int trailTask = frameUpdate.add("trail", [&]() {
+		trail.update(1.f / frameRate);
+		trail.emit(TRAIL_PARTICLES_PER_FRAME, glm::vec3(ballMatrix[3]), glm::vec3(0.f, 0.f, 0.f), 0.05f, ballLight.color);
+	});
+	int sparksTask = frameUpdate.add("sparks", [&]() {
+		sparks.update(1.f / frameRate);
+		if (ballHit)
+		{
+			sparks.emit(HIT_SPARKS, glm::vec3(ballMatrix[3]), glm::vec3(0.f, 0.5f, 0.f), 1.5f, ballLight.color);
+			ballHit = false;
+		}
+	});
+
+	frameUpdate.depends(character1Task, animationTask);
+	frameUpdate.depends(character2Task, animationTask);
+	frameUpdate.depends(tableTask, animationTask);
+	frameUpdate.depends(rescaleTask, character1Task);
+	frameUpdate.depends(rescaleTask, character2Task);
+	frameUpdate.depends(rescaleTask, tableTask);
+	frameUpdate.depends(pickingTask, rescaleTask);
+	frameUpdate.depends(drillTask, character1Task); //raquettes
+	frameUpdate.depends(drillTask, character2Task);
+	frameUpdate.depends(drillMatricesTask, drillTask);
+	frameUpdate.depends(trailTask, animationTask); //balle
+	frameUpdate.depends(sparksTask, drillTask); //les balles d'entranement font aussi des tincelles, avant le pas des particules
 
 	//////////////////////////////////////////////////////////////////////////////////////FIN_PARTIE_ELEVE////////////////////////////////////////////////////////////////////////////////////
 
+	FrameCapture capture;
+	if (options.capturePath != NULL)
+	{
+		if (!capture.open(options.capturePath, WIDTH, HEIGHT, frameRate)) {
+			delete backend;
+			return EXIT_FAILURE;
+		}
+		backend->setCapture(&capture);
+	}
+
+	//sans fentre, chaque image est mesure sans attente
+	FramePacer pacer;
+	if (!options.headless)
+	{
+		pacer.configure(window, (float)frameRate, options.swapInterval);
+		backend->setFramePacer(&pacer);
+	}
+
+	DynamicResolution resolution(RENDER_BUDGET_RATIO * 1000.f / frameRate);
+	bool dynamicResolution = options.dynamicResolution;
+	backend->setRenderScale(options.renderScale);
+	resolution.setScale(options.renderScale);
+
+	//les matrices des yeux ne dpendent que de la projection : les mvp de la camra centrale servent pour les deux yeux
+	StereoViews stereoViews;
+	StereoComparison stereoCost;
+	if (options.stereo || options.stereoCompare)
+	{
+		computeStereoViews(projectionMatrix, options.ipd, std::max(options.convergence, 0.1f), stereoViews);
+		if (!backend->setStereo(&stereoViews))
+		{
+			ERROR("This renderer does not support stereo, use the OpenGL renderers\n");
+			delete backend;
+			return EXIT_FAILURE;
+		}
+	}
+	bool stereoShown = options.stereo; //l'image  l'cran, sur laquelle tombent les clics
+
     bool isOpened = true;
 
     //Main application loop
@@ -867,6 +1458,9 @@ int main(int argc, char *argv[])
 	{
 		//Time in ms telling us when this frame started. Useful for keeping a fix framerate
 		uint32_t timeBegin = SDL_GetTicks();
+		allocations.beginFrame();
+		Uint64 counterBegin = SDL_GetPerformanceCounter(); //plus prcis, pour les mesures
+		bool cameraMoved = false;
 
 		t++;
 
@@ -890,343 +1484,172 @@ int main(int argc, char *argv[])
 
 			case SDL_KEYDOWN:
 			{
-				//Pour dplacer ou tourner la camra
-				if (event.key.keysym.sym == SDLK_UP) {
-					if (cameraPos.y < 10) {
-						cameraPos.y += 0.20f;
-					}
-				}
-				if (event.key.keysym.sym == SDLK_DOWN) {
-					if (cameraPos.y > -10) {
-						cameraPos.y -= 0.20f;
-					}
+				if (options.replayPath != NULL) {
+					break; //en rejeu, seules les entres du journal dplacent la camra
 				}
-				if (event.key.keysym.sym == SDLK_LEFT) {
-					if (cameraPos.x < 10) {
-						cameraPos.x += 0.20f;
-					}
-				}
-				if (event.key.keysym.sym == SDLK_RIGHT) {
-					if (cameraPos.x > -10) {
-						cameraPos.x -= 0.20f;
-					}
-				}
-				if (event.key.keysym.sym == SDLK_z) {
-					if (cameraPos.z <= -30.11) {
-						cameraPos.z += 0.11f;
-					}
-				}
-				if (event.key.keysym.sym == SDLK_s) {
-					if (cameraPos.z >= -44.89) {
-						cameraPos.z -= 0.11f;
-					}
+				recorder.recordEvent(event);
+
+				//Pour dplacer ou tourner la camra
+				moveCamera(event.key.keysym.sym, cameraPos, cameraFront);
+				changeRenderScale(event.key.keysym.sym, backend, resolution, dynamicResolution);
+				cameraMoved = true;
+				break;
+			}
+
+			//figure sous la souris : l'image affiche et le BVH sont tous deux ceux de l'image prcdente
+			case SDL_MOUSEBUTTONDOWN:
+			{
+				if (options.replayPath != NULL || event.button.button != SDL_BUTTON_LEFT) {
+					break;
 				}
-				if (event.key.keysym.sym == SDLK_q) {
-					cameraFront.x += 0.11f;
+				recorder.recordEvent(event);
+				pickFigure(sceneBvh, viewProjection, stereoShown ? &stereoViews : NULL, event.button.x, event.button.y, glm::vec3(myLight.Coordinates[3]));
+				break;
+			}
+			}
+		}
+
+		//en rejeu, on applique les entres enregistres pour cette image
+		if (options.replayPath != NULL)
+		{
+			replayer.getEvents(t, replayEvents);
+			for (size_t i = 0; i < replayEvents.size(); i++)
+			{
+				if (replayEvents[i].type == SDL_KEYDOWN) {
+					moveCamera(replayEvents[i].key.keysym.sym, cameraPos, cameraFront);
+					changeRenderScale(replayEvents[i].key.keysym.sym, backend, resolution, dynamicResolution);
+					cameraMoved = true;
 				}
-				if (event.key.keysym.sym == SDLK_d) {
-					cameraFront.x -= 0.11f;
+				else if (replayEvents[i].type == SDL_MOUSEBUTTONDOWN) {
+					pickFigure(sceneBvh, viewProjection, stereoShown ? &stereoViews : NULL, replayEvents[i].button.x, replayEvents[i].button.y, glm::vec3(myLight.Coordinates[3]));
 				}
-				cameraMatrix = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-				glm::mat4 lightPosition = projectionMatrix * cameraMatrix * myLight.Coordinates;
-				myLight.position = glm::vec3(lightPosition[3][0], lightPosition[3][1], lightPosition[3][2]); // on doit redfinir la position de la lumire  chaque changement de camra
-			}
 			}
 		}
 
+		if (cameraMoved)
+		{
+			cameraMatrix = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+			glm::mat4 lightPosition = projectionMatrix * cameraMatrix * myLight.Coordinates;
+			myLight.position = glm::vec3(lightPosition[3][0], lightPosition[3][1], lightPosition[3][2]); // on doit redfinir la position de la lumire  chaque changement de camra
+		}
 
-		//Clear the screen : the depth buffer and the color buffer
-		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
 		//////////////////////////////////////////////////////////////////////////////////////////PARTIE_ELEVE////////////////////////////////////////////////////////////////////////////////////
 
-		//Simulation de renvoi de la balle de ping pong en fonction des diffrents paramtres dcrits plus haut.
-		if (sideBall == 0) {
-			if (x < 0.6)
-			{
-				x += 0.03;
-				y = abs(cos(x / 2.4 * M_PI)) * 0.5 + 0.05;
-				z += 0.01;
-				shoulderRotation2 = -1;
-			}
-			else if (x < 1.2)
-			{
-				x += 0.03;
-				y = abs(cos(x / 2.4 * M_PI)) * 0.5 + 0.05;
-				z += 0.01;
-				shoulderRotation2 = 0;
-				shoulderTurning2 = -1;
-				shoulderRotation = 1;
-			}
-			else if (x < 1.8)
-			{
-				x += 0.03;
-				y = abs(cos(2 * x / 2.4 * M_PI - M_PI / 2)) * 0.5 + 0.05;
-				z += 0.01;
-				shoulderMovement = 1;
-				shoulderRotation = 0;
-				shoulderTurning2 = 0;
-			}
-			else {
-				sideBall = 1;
-				ballLight.color = glm::vec3((rand() % 101) / 100.f, (rand() % 101) / 100.f, (rand() % 101) / 100.f);
-				shoulderMovement = 0;
-				shoulderRotation = 1;
-			}
-		}
-		else {
-			if (x > 1.2)
-			{
-				x -= 0.03;
-				y = abs(cos((1.8-x) / 2.4 * M_PI)) * 0.5 + 0.05;
-				z -= 0.01;
-				shoulderRotation = -1;
-			}
-			else if (x > 0.6)
-			{
-				x -= 0.03;
-				y = abs(cos((1.8 - x) / 2.4 * M_PI)) * 0.5 + 0.05;
-				z -= 0.01;
-				shoulderRotation = 0;
-				shoulderTurning = -1;
-				shoulderRotation2 = 1;
-			}
-			else if (x > 0)
-			{
-				x -= 0.03;
-				y = abs(cos((2 * (1.8-x) / 2.4 * M_PI - M_PI / 2))) * 0.5 + 0.05;
-				z -= 0.01;
-				shoulderMovement2 = 1;
-				shoulderRotation2 = 0;
-				shoulderTurning = 0;
-			}
-			else {
-				sideBall = 0;
-				ballLight.color = glm::vec3((rand() % 101) / 100.f, (rand() % 101) / 100.f, (rand() % 101) / 100.f);
-				shoulderMovement2 = 0;
-				shoulderRotation2 = 1;
-			}
+		//La balle et les articulations sont values  l'instant animTime : aucune accumulation d'une image  l'autre
+		animTime = t / (float)frameRate;
+		ballPosition = ballTrajectory(animTime);
+
+		int crossing = (int)(t * (double)FRAMERATE / frameRate) / CROSSING_FRAMES; //image de l'animation, quelle que soit la frquence d'affichage
+		if (crossing != lastCrossing) {
+			lastCrossing = crossing;
+			ballHit = true;
+			ballLight.color = glm::vec3((rand() % 101) / 100.f, (rand() % 101) / 100.f, (rand() % 101) / 100.f);
 		}
 
-		//TODO operations on matrix
-		// On rinitialise les donnes des figure principales (les corps, la balle, la table)
+		//animation, matrices, balles d'entranement et particules
+		frameUpdate.run(jobs);
 
-		if (t % 120 - 60 >= 0) {
-			bodyMovement -= 0.0005;
-			legMovement = -abs(legMovement);
-		}
-		else {
-			bodyMovement += 0.0005;
-			legMovement = +abs(legMovement);
+        //TODO rendering
+		bool stereoFrame = options.stereoCompare ? t % 2 == 0 : options.stereo;
+		if (options.stereoCompare) {
+			backend->setStereo(stereoFrame ? &stereoViews : NULL);
 		}
+		Uint64 renderBegin = SDL_GetPerformanceCounter();
 
-		bodyMatrix = getMatrix(-1.9, 0.3, -40, -M_PI / 2.f, 1, 0, 0);
-		bodyMatrix = glm::rotate(bodyMatrix, (float)(-M_PI / 2.f), glm::vec3(0, 0, 1));
-		bodyMatrix = glm::rotate(bodyMatrix, (float)(-M_PI / 12.f), glm::vec3(1, 0, 0));
-		bodyMatrix = glm::translate(bodyMatrix, glm::vec3(0, 1/3.f * bodyMovement, 2/3.f * bodyMovement));
-
-		bodyMatrix2 = getMatrix(1.9, 0.3, -40, -M_PI / 2.f, 1, 0, 0);
-		bodyMatrix2 = glm::rotate(bodyMatrix2, (float)(M_PI / 2.f), glm::vec3(0, 0, 1));
-		bodyMatrix2 = glm::rotate(bodyMatrix2, (float)(-M_PI / 12.f), glm::vec3(1, 0, 0));
-		bodyMatrix2 = glm::translate(bodyMatrix2, glm::vec3(0, 1 / 3.f * bodyMovement, 2 / 3.f * bodyMovement));
-		
+        //Clear the screen : the depth buffer and the color buffer
+        backend->beginFrame();
 
-		tableMatrix = getMatrix(0, 0, -40, 0 * (M_PI / 2.f), 0, 1, 0);
-		ballMatrix = getMatrix(0.9 - x, y, z - 40, 0, 1, 0, 0);
-
-		// On recalcule toutes les matrices en fonction de la nouvelle position du corps et de la rotation des articulations 
-		listeMvp[0] = projectionMatrix * cameraMatrix * bodyMatrix;
-		listeMvp[1] = projectionMatrix * cameraMatrix * bodyMatrix * headMatrix;
-		listeMvp[2] = projectionMatrix * cameraMatrix * bodyMatrix * shoulder1Matrix;
-		listeMvp[3] = projectionMatrix * cameraMatrix * bodyMatrix * shoulder1Matrix * arm1Matrix;
-		listeMvp[4] = projectionMatrix * cameraMatrix * bodyMatrix * shoulder1Matrix * arm1Matrix * elbow1Matrix;
-		listeMvp[5] = projectionMatrix * cameraMatrix * bodyMatrix * shoulder1Matrix * arm1Matrix * elbow1Matrix * forearm1Matrix;
-		shoulder2Matrix = glm::rotate(shoulder2Matrix, (float)(shoulderMovement * M_PI/40.f), glm::vec3(0, 1, 0));
-		shoulder2Matrix = glm::rotate(shoulder2Matrix, (float)(shoulderRotation * M_PI /40.f), glm::vec3(1, 0, 0));
-		shoulder2Matrix = glm::rotate(shoulder2Matrix, (float)(shoulderTurning * M_PI / 40.f), glm::vec3(0, 0, 1));
-		listeMvp[6] = projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix;
-		listeMvp[7] = projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix;
-		listeMvp[8] = projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix;
-		listeMvp[9] = projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix;
-		listeMvp[10] = projectionMatrix * cameraMatrix * bodyMatrix * thigh1Matrix;
-		knee1Matrix = glm::rotate(knee1Matrix, legMovement, glm::vec3(1, 0, 0));
-		listeMvp[11] = projectionMatrix * cameraMatrix * bodyMatrix * thigh1Matrix * knee1Matrix;
-		listeMvp[12] = projectionMatrix * cameraMatrix * bodyMatrix * thigh1Matrix * knee1Matrix * leg1Matrix;
-		listeMvp[13] = projectionMatrix * cameraMatrix * bodyMatrix * thigh1Matrix * knee1Matrix * leg1Matrix * foot1Matrix;
-		listeMvp[14] = projectionMatrix * cameraMatrix * bodyMatrix * thigh2Matrix;
-		knee2Matrix = glm::rotate(knee2Matrix, legMovement, glm::vec3(1, 0, 0));
-		listeMvp[15] = projectionMatrix * cameraMatrix * bodyMatrix * thigh2Matrix * knee2Matrix;
-		listeMvp[16] = projectionMatrix * cameraMatrix * bodyMatrix * thigh2Matrix * knee2Matrix * leg2Matrix;
-		listeMvp[17] = projectionMatrix * cameraMatrix * bodyMatrix * thigh2Matrix * knee2Matrix * leg2Matrix * foot2Matrix;
-
-		listeMvp[18] = projectionMatrix * cameraMatrix * bodyMatrix2;
-		listeMvp[19] = projectionMatrix * cameraMatrix * bodyMatrix2 * headMatrix2;
-		shoulder2Matrix2 = glm::rotate(shoulder2Matrix2, (float)(shoulderMovement2 * M_PI / 40.f), glm::vec3(0, 1, 0));
-		shoulder2Matrix2 = glm::rotate(shoulder2Matrix2, (float)(shoulderRotation2 * M_PI / 40.f), glm::vec3(1, 0, 0));
-		shoulder2Matrix2 = glm::rotate(shoulder2Matrix2, (float)(shoulderTurning2 * M_PI / 40.f), glm::vec3(0, 0, 1));
-		listeMvp[20] = projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder1Matrix2;
-		listeMvp[21] = projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder1Matrix2 * arm1Matrix2;
-		listeMvp[22] = projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder1Matrix2 * arm1Matrix2 * elbow1Matrix2;
-		listeMvp[23] = projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder1Matrix2 * arm1Matrix2 * elbow1Matrix2 * forearm1Matrix2;
-		listeMvp[24] = projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2;
-		listeMvp[25] = projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2;
-		listeMvp[26] = projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2;
-		listeMvp[27] = projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2;
-		listeMvp[28] = projectionMatrix * cameraMatrix * bodyMatrix2 * thigh1Matrix2;
-		knee1Matrix2 = glm::rotate(knee1Matrix2, legMovement, glm::vec3(1, 0, 0));
-		listeMvp[29] = projectionMatrix * cameraMatrix * bodyMatrix2 * thigh1Matrix2 * knee1Matrix2;
-		listeMvp[30] = projectionMatrix * cameraMatrix * bodyMatrix2 * thigh1Matrix2 * knee1Matrix2 * leg1Matrix2;
-		listeMvp[31] = projectionMatrix * cameraMatrix * bodyMatrix2 * thigh1Matrix2 * knee1Matrix2 * leg1Matrix2 * foot1Matrix2;
-		listeMvp[32] = projectionMatrix * cameraMatrix * bodyMatrix2 * thigh2Matrix2;
-		knee2Matrix2 = glm::rotate(knee2Matrix2, legMovement, glm::vec3(1, 0, 0));
-		listeMvp[33] = projectionMatrix * cameraMatrix * bodyMatrix2 * thigh2Matrix2 * knee2Matrix2;
-		listeMvp[34] = projectionMatrix * cameraMatrix * bodyMatrix2 * thigh2Matrix2 * knee2Matrix2 * leg2Matrix2;
-		listeMvp[35] = projectionMatrix * cameraMatrix * bodyMatrix2 * thigh2Matrix2 * knee2Matrix2 * leg2Matrix2 * foot2Matrix2;
-
-		listeMvp[36] = projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix * raquette1Matrix;
-		listeMvp[37] = projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix * raquette1Matrix * face1Matrix;
-		listeMvp[38] = projectionMatrix * cameraMatrix * bodyMatrix * shoulder2Matrix * arm2Matrix * elbow2Matrix * forearm2Matrix * raquette1Matrix * manche1Matrix;
-
-		listeMvp[39] = projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2 * raquette2Matrix;
-		listeMvp[40] = projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2 * raquette2Matrix * face2Matrix;
-		listeMvp[41] = projectionMatrix * cameraMatrix * bodyMatrix2 * shoulder2Matrix2 * arm2Matrix2 * elbow2Matrix2 * forearm2Matrix2 * raquette2Matrix * manche2Matrix;
-
-		listeMvp[42] = projectionMatrix * cameraMatrix * tableMatrix;
-		listeMvp[43] = projectionMatrix * cameraMatrix * tableMatrix * filetMatrix;
-		listeMvp[44] = projectionMatrix * cameraMatrix * tableMatrix * supportMatrix;
-		listeMvp[45] = projectionMatrix * cameraMatrix * tableMatrix * supportMatrix * socleMatrix;
-
-		listeMvp[46] = projectionMatrix * cameraMatrix * ballMatrix;
-
-		listeMvp[47] = projectionMatrix * cameraMatrix * worldMatrix;
-
-		//on oublie pas de rescale
-
-		listeMvp[0] = listeMvp[0] * scaleMatrix(0.5, 0.25, 0.8);
-		listeMvp[1] = listeMvp[1] * scaleMatrix(0.3, 0.3, 0.3);
-		listeMvp[2] = listeMvp[2] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[3] = listeMvp[3] * scaleMatrix(0.1, 0.1, 0.25);
-		listeMvp[4] = listeMvp[4] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[5] = listeMvp[5] * scaleMatrix(0.1, 0.1, 0.25);
-		listeMvp[6] = listeMvp[6] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[7] = listeMvp[7] * scaleMatrix(0.1, 0.1, 0.25);
-		listeMvp[8] = listeMvp[8] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[9] = listeMvp[9] * scaleMatrix(0.1, 0.1, 0.25);
-		listeMvp[10] = listeMvp[10] * scaleMatrix(0.15, 0.15, 0.38);
-		listeMvp[11] = listeMvp[11] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[12] = listeMvp[12] * scaleMatrix(0.15, 0.15, 0.38);
-		listeMvp[13] = listeMvp[13] * scaleMatrix(0.2, 0.4, 0.2);
-		listeMvp[14] = listeMvp[14] * scaleMatrix(0.15, 0.15, 0.38);
-		listeMvp[15] = listeMvp[15] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[16] = listeMvp[16] * scaleMatrix(0.15, 0.15, 0.38);
-		listeMvp[17] = listeMvp[17] * scaleMatrix(0.2, 0.4, 0.2);
-
-		listeMvp[18] = listeMvp[18] * scaleMatrix(0.5, 0.25, 0.8);
-		listeMvp[19] = listeMvp[19] * scaleMatrix(0.3, 0.3, 0.3);
-		listeMvp[20] = listeMvp[20] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[21] = listeMvp[21] * scaleMatrix(0.1, 0.1, 0.25);
-		listeMvp[22] = listeMvp[22] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[23] = listeMvp[23] * scaleMatrix(0.1, 0.1, 0.25);
-		listeMvp[24] = listeMvp[24] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[25] = listeMvp[25] * scaleMatrix(0.1, 0.1, 0.25);
-		listeMvp[26] = listeMvp[26] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[27] = listeMvp[27] * scaleMatrix(0.1, 0.1, 0.25);
-		listeMvp[28] = listeMvp[28] * scaleMatrix(0.15, 0.15, 0.38);
-		listeMvp[29] = listeMvp[29] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[30] = listeMvp[30] * scaleMatrix(0.15, 0.15, 0.38);
-		listeMvp[31] = listeMvp[31] * scaleMatrix(0.2, 0.4, 0.2);
-		listeMvp[32] = listeMvp[32] * scaleMatrix(0.15, 0.15, 0.38);
-		listeMvp[33] = listeMvp[33] * scaleMatrix(0.2, 0.2, 0.2);
-		listeMvp[34] = listeMvp[34] * scaleMatrix(0.15, 0.15, 0.38);
-		listeMvp[35] = listeMvp[35] * scaleMatrix(0.2, 0.4, 0.2);
-
-		listeMvp[36] = listeMvp[36] * scaleMatrix(0.2, 0.2, 0.02);
-		listeMvp[37] = listeMvp[37] * scaleMatrix(0.2, 0.2, 0.02);
-		listeMvp[38] = listeMvp[38] * scaleMatrix(0.035, 0.02, 0.1);
-
-		listeMvp[39] = listeMvp[39] * scaleMatrix(0.2, 0.2, 0.02);
-		listeMvp[40] = listeMvp[40] * scaleMatrix(0.2, 0.2, 0.02);
-		listeMvp[41] = listeMvp[41] * scaleMatrix(0.035, 0.02, 0.1);
-
-		listeMvp[42] = listeMvp[42] * scaleMatrix(1.8, 0.05, 1.0);
-		listeMvp[43] = listeMvp[43] * scaleMatrix(0.02, 0.15, 0.98);
-		listeMvp[44] = listeMvp[44] * scaleMatrix(0.2, 0.65, 0.95);
-		listeMvp[45] = listeMvp[45] * scaleMatrix(1.0, 0.1, 1.0);
-
-		listeMvp[46] = listeMvp[46] * scaleMatrix(0.075, 0.075, 0.075);
-		listeMvp[47] = listeMvp[47] * scaleMatrix(100, 100, 100);
+		//ombres de myLight, tourne vers la table. La table, le filet, le support et le socle ne bougent jamais : leur carte est garde,
+		//seuls les personnages, les raquettes et la balle sont redessins  chaque image.
+		if (options.shadows && backend->setShadowLight(glm::vec3(myLight.Coordinates[3]), glm::vec3(listeModel[42][3]), viewProjection))
+		{
+			for (int i = 0; i < listeMesh.size(); i++) {
+				backend->drawShadowCaster(listeMesh[i], listeModel[i], i >= 42 && i <= 45);
+			}
+		}
 
-        //TODO rendering
-        glUseProgram(shader->getProgramID());
-        {
-			std::vector<GLint> glValues;
-			//on instancie les GLint pour l'affichage de nos figures
-			GLint vPosition = glGetAttribLocation(shader->getProgramID(), "vPosition");
-			glValues.push_back(vPosition);
-			GLint vNormal = glGetAttribLocation(shader->getProgramID(), "vNormal");
-			glValues.push_back(vNormal);
-			GLint uK = glGetUniformLocation(shader->getProgramID(), "uK");
-			glValues.push_back(uK);
-			GLint uMVP = glGetUniformLocation(shader->getProgramID(), "uMVP");
-			glValues.push_back(uMVP);
-			GLint uModelView = glGetUniformLocation(shader->getProgramID(), "uModelView");
-			glValues.push_back(uModelView);
-			GLuint uColor = glGetUniformLocation(shader->getProgramID(), "uColor");
-			glValues.push_back(uColor);
-			GLuint uLightColor = glGetUniformLocation(shader->getProgramID(), "uLightColor");
-			glValues.push_back(uLightColor);
-			GLuint uLightPosition = glGetUniformLocation(shader->getProgramID(), "uLightPosition");
-			glValues.push_back(uLightPosition);
-			GLuint uCameraPosition = glGetUniformLocation(shader->getProgramID(), "uCameraPosition");
-			glValues.push_back(uCameraPosition);
-			glActiveTexture(GL_TEXTURE0);
-			GLint uTexture = glGetUniformLocation(shader->getProgramID(), "uTexture");
-			glValues.push_back(uTexture);
-			GLint vUV = glGetAttribLocation(shader->getProgramID(), "vUV");
-			glValues.push_back(vUV);
-
-			//on dessine toutes nos figures. Notez l'importance d'avoir les bons index et le mme nombre d'lments dans chaque liste, pratique risque mais ici controlle
-			for (int i = 0; i < listeFigures.size(); i++)
+		//on dessine toutes nos figures. Notez l'importance d'avoir les bons index et le mme nombre d'lments dans chaque liste, pratique risque mais ici controlle
+		for (int i = 0; i < listeMesh.size(); i++)
+		{
+			try
 			{
-				try
-				{
-					if (i != 46) { //lumire classique
-						draw(listeTexture[i], listeBuffer[i], listeBuffer2[i], listeFigures[i], shader, listeMvp[i], listeMaterial[i], myLight, glValues);
-					}
-					else { //lumire spcifique  la balle, pour donner un effet sympatique
-						draw(listeTexture[i], listeBuffer[i], listeBuffer2[i], listeFigures[i], shader, listeMvp[i], listeMaterial[i], ballLight, glValues);
-					}
+				if (i != 46) { //lumire classique
+					backend->draw(listeMesh[i], listeTexture[i], listeMvp[i], listeMaterial[i], myLight);
 				}
-				catch (...)
-				{
-					return EXIT_FAILURE;
+				else { //lumire spcifique  la balle, pour donner un effet sympatique
+					backend->draw(listeMesh[i], listeTexture[i], listeMvp[i], listeMaterial[i], ballLight);
 				}
 			}
-        }
+			catch (...)
+			{
+				return EXIT_FAILURE;
+			}
+		}
 
-        glUseProgram(0);
+		//balles d'entranement, avec le maillage et le matriau de la balle
+		for (int i = 0; i < std::min(drillPhysics.getCount(), DRILL_RENDERED_BALLS); i++) {
+			backend->draw(listeMesh[46], listeTexture[46], drillMvp[i], listeMaterial[46], ballLight);
+		}
+
+		//le fond ne suit que l'orientation de la camra
+		if (skybox >= 0) {
+			backend->drawSkybox(skybox, projectionMatrix * glm::mat4(glm::mat3(cameraMatrix)));
+		}
+
+		//un appel par metteur, aprs les figures
+		float pixelScale = 0.5f * HEIGHT * projectionMatrix[1][1];
+		backend->drawParticles(trail.getBatch(projectionMatrix * cameraMatrix, pixelScale));
+		backend->drawParticles(sparks.getBatch(projectionMatrix * cameraMatrix, pixelScale));
 
 		//////////////////////////////////////////////////////////////////////////////////////FIN_PARTIE_ELEVE////////////////////////////////////////////////////////////////////////////////////
 
         //Display on screen (swap the buffer on screen and the buffer you are drawing on)
-        SDL_GL_SwapWindow(window);
+        backend->endFrame();
+		if (options.stereoCompare) {
+			//sans l'attente de l'chance, qui ramnerait les deux vues  la mme priode
+			stereoCost.add(stereoFrame, (SDL_GetPerformanceCounter() - renderBegin) * 1000.0 / SDL_GetPerformanceFrequency() - pacer.getLastWaitMs());
+		}
+		stereoShown = stereoFrame;
 
-        //Time in ms telling us when this frame ended. Useful for keeping a fix framerate
-        uint32_t timeEnd = SDL_GetTicks();
+		//dure de l'image sans l'attente de son chance d'affichage
+		double frameMs = (SDL_GetPerformanceCounter() - counterBegin) * 1000.0 / SDL_GetPerformanceFrequency() - pacer.getLastWaitMs();
+		timings.add(frameMs);
 
-        //We want FRAMERATE FPS
-        if(timeEnd - timeBegin < TIME_PER_FRAME_MS)
-            SDL_Delay(TIME_PER_FRAME_MS - (timeEnd - timeBegin));
+		//dure mesure par le moteur (requtes de temps sur la carte graphique), sinon dure de l'image sur le processeur
+		if (dynamicResolution)
+		{
+			float renderMs = backend->getRenderTime();
+			backend->setRenderScale(resolution.update(renderMs >= 0.f ? renderMs : (float)frameMs));
+		}
+
+		recorder.endFrame(t, timeBegin);
+		if (options.allocationStats) {
+			allocations.endFrame(t);
+		}
+		if (options.replayPath != NULL && replayer.isFinished(t + 1)) {
+			isOpened = false; //fin du journal
+		}
     }
     
-    //Free everything
-	delete(shader);
-	for (int i = 0; i < listeBuffer.size(); i++) {
-		glDeleteBuffers(1, &listeBuffer[i]);
+	recorder.close();
+	backend->setCapture(NULL); //rcupre les dernires images encore sur la carte graphique
+	capture.close();
+	backend->setFramePacer(NULL);
+	pacer.printReport();
+	if (options.timingsPath != NULL)
+	{
+		timings.write(options.timingsPath);
+		timings.printSummary();
 	}
-	for (int i = 0; i < listeTexture.size(); i++) {
-		glDeleteTextures(1, &listeTexture[i]);
+	if (options.allocationStats) {
+		allocations.printSummary();
 	}
+	stereoCost.printSummary();
+
+    //Free everything
+	backend->printMemoryReport("shutdown");
+	delete backend; //shaders, buffers et textures, les objets OpenGL restants sont signals comme des fuites
     if(context != NULL)
         SDL_GL_DeleteContext(context);
     if(window != NULL)